@@ -0,0 +1,47 @@
+// Vertex Shader
+#version 330 core
+
+// Unit quad corner, shared by every instance
+layout (location = 0) in vec2 aCorner;
+
+// Per instance (SpriteInstance)
+layout (location = 1) in vec2 aPosition;
+layout (location = 2) in vec2 aSize;
+layout (location = 3) in float aRotation;
+layout (location = 4) in uint aPackedColor;
+layout (location = 5) in vec4 aUVRect;
+layout (location = 6) in uint aTextureIndex;
+
+uniform mat4 uViewProjection;
+
+out vec4 vColor;
+out vec2 vUV;
+out float vTextureIndex;
+
+vec4 unpackRGBA(uint pack)
+{
+    return vec4(
+        float((pack >> 0u) & 0xFFu),
+        float((pack >> 8u) & 0xFFu),
+        float((pack >> 16u) & 0xFFu),
+        float((pack >> 24u) & 0xFFu)
+    ) / 255.0;
+}
+
+void main()
+{
+    // Scale, rotate then move the corner (same order as makeSpriteQuadVertices)
+    vec2 scaled = aCorner * aSize;
+    float c = cos(aRotation);
+    float s = sin(aRotation);
+    vec2 worldPos = vec2(
+        scaled.x * c - scaled.y * s,
+        scaled.x * s + scaled.y * c
+    ) + aPosition;
+
+    gl_Position = uViewProjection * vec4(worldPos, 0.0, 1.0);
+    vColor = unpackRGBA(aPackedColor);
+    // Left corners take u0 and top corners v0
+    vUV = mix(aUVRect.xy, aUVRect.zw, vec2(aCorner.x + 0.5, 0.5 - aCorner.y));
+    vTextureIndex = float(aTextureIndex);
+}
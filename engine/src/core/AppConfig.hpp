@@ -10,6 +10,10 @@ struct AppConfig {
 	uint32_t width = 800;
 	uint32_t height = 600;
 	std::string title = "App";
+	uint32_t workerThreads = 0; // Thread pool workers, 0 uses one less than the hardware threads
+	float fixedTickRate = 60.0f; // Fixed updates (physics, collider sync) per second
+	uint32_t maxFixedSteps = 5; // Fixed updates per frame at most, slower frames drop the rest of their time
+	uint64_t randomSeed = 0; // Seed of quickRandFloat
 
 	operator Window::Data() const {
 		return Window::Data{width, height, title};
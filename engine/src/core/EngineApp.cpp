@@ -1,7 +1,9 @@
 #include "core/EngineApp.hpp"
 
 #include "utilities/assertions.hpp"
+#include "utilities/misc.hpp"
 #include "renderer/Camera/OrthographicCamera.hpp"
+#include "physics/PhysicsProfiler.hpp"
 #include <events/types/KeyEvent.hpp>
 #include <window/KeyCodes.hpp>
 
@@ -21,8 +23,10 @@ EngineApp::EngineApp()
 void EngineApp::init()
 {
 	// Application initialization.
+	AppConfig appConfig = config();
+
 	// Window creation.
-	Window::Data data = config();
+	Window::Data data = appConfig;
 	data.pushEvent = [&](std::unique_ptr<Event> event) { pushEvent(std::move(event)); };
 	m_window = Window::createWindow(data);
 	ASSERT(m_window != nullptr, "Window not created");
@@ -43,6 +47,14 @@ void EngineApp::init()
 	// Assets interface
 	m_assetsManager.init(&m_resourceHub, &m_renderer2D->getGPUAssets());
 
+	m_threadPool = std::make_unique<ThreadPool>(appConfig.workerThreads);
+
+	ASSERT(appConfig.fixedTickRate > 0.0f && appConfig.maxFixedSteps > 0, "Invalid fixed update config");
+	m_fixedDeltaTime = 1.0f / appConfig.fixedTickRate;
+	m_maxFixedSteps = appConfig.maxFixedSteps;
+
+	getDefaultRandomGenerator().setSeed(appConfig.randomSeed);
+
 	// Engine layers creation.
 	auto stopAppCallback = [&]() { stop(); };
 
@@ -97,6 +109,7 @@ void EngineApp::run()
 	
 	// Engine loop.
 	float deltaTime = 0.0f;
+	float fixedTimeAccumulator = 0.0f;
 	auto lastFrameTime = Clock::now();
 
 	while (m_isRunning)
@@ -108,6 +121,11 @@ void EngineApp::run()
 		fpsLogTimer += deltaTime;
 		framesCounter++;
 
+#ifdef PHYSICS_PROFILING
+		// Physics counters of the previous frame become readable for this one
+		PhysicsProfiler::endFrame();
+#endif
+
 		m_inputManager.update();
 
 		m_window->pollEvents();
@@ -117,6 +135,26 @@ void EngineApp::run()
 
 		auto activeScene = m_sceneManager.getActiveScene();
 		ASSERT(activeScene != nullptr, "Active scene not set");
+
+		// Simulation runs in fixed steps, engine systems (collider sync, physics) first.
+		// Time past maxFixedSteps is dropped so slow frames can't fall further behind each frame.
+		fixedTimeAccumulator += deltaTime;
+		uint32_t fixedSteps = 0;
+		while (fixedTimeAccumulator >= m_fixedDeltaTime && fixedSteps < m_maxFixedSteps)
+		{
+			m_layers.onFixedUpdate(m_fixedDeltaTime);
+			activeScene->onFixedUpdate(m_fixedDeltaTime);
+			fixedTimeAccumulator -= m_fixedDeltaTime;
+			fixedSteps++;
+			m_tickCount++;
+#ifdef DETERMINISTIC_MODE
+			m_tickStateHash = activeScene->computeStateHash();
+#endif
+		}
+		if (fixedTimeAccumulator >= m_fixedDeltaTime)
+			fixedTimeAccumulator = std::fmod(fixedTimeAccumulator, m_fixedDeltaTime);
+		m_interpolationAlpha = fixedTimeAccumulator / m_fixedDeltaTime;
+
 		activeScene->onUpdate(deltaTime);
 		activeScene->updateWorldActions();
 		
@@ -149,6 +187,9 @@ void EngineApp::terminate()
 	// Terminate scenes so resources are freed
 	m_sceneManager.clearScenes();
 
+	// Joins the workers
+	m_threadPool.reset();
+
 	// Renderer2D cleanup
 	// Internaly destroys the resource of the renderer.
 	bool resTerminateRenderer2D = m_renderer2D->terminate();
@@ -16,6 +16,7 @@
 #include "layers/types/DebugLayer.hpp"
 #include "events/EventDispatcher.hpp"
 #include "input/InputManager.hpp"
+#include "utilities/ThreadPool.hpp"
 
 namespace TileBite {
 
@@ -54,6 +55,16 @@ public:
 	InputManager& getInputManager() { return m_inputManager; }
 	Window& getWindow() { return *m_window; }
 	Renderer2D& getRenderer() { return *m_renderer2D; }
+	ThreadPool& getThreadPool() { return *m_threadPool; }
+
+	float getFixedDeltaTime() const { return m_fixedDeltaTime; }
+	// Fraction of a fixed step elapsed since the last fixed update, for interpolating what it moved
+	float getInterpolationAlpha() const { return m_interpolationAlpha; }
+
+	// Fixed updates run since the start of the app
+	uint64_t getTickCount() const { return m_tickCount; }
+	// State hash of the active scene after the last fixed update, only computed in DETERMINISTIC_MODE
+	uint64_t getTickStateHash() const { return m_tickStateHash; }
 
 private:
 	static EngineApp* s_instance;
@@ -64,6 +75,9 @@ private:
 
 	InputManager m_inputManager;
 
+	// Workers for parallel engine and game jobs (eg: batched raycasts)
+	std::unique_ptr<ThreadPool> m_threadPool;
+
 	std::shared_ptr<Window> m_window;
 	std::shared_ptr<Renderer2D> m_renderer2D;
 
@@ -74,6 +88,13 @@ private:
 
 	SceneManager m_sceneManager;
 
+	// Fixed update loop
+	float m_fixedDeltaTime = 1.0f / 60.0f;
+	uint32_t m_maxFixedSteps = 5;
+	float m_interpolationAlpha = 0.0f;
+	uint64_t m_tickCount = 0;
+	uint64_t m_tickStateHash = 0;
+
 	bool m_isRunning;
 };
 
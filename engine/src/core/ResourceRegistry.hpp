@@ -6,6 +6,7 @@ namespace TileBite {
 namespace ResourceNames {
 // Text Files
 constexpr const char* SpriteVertFile = "spriteVertFile";
+constexpr const char* SpriteInstancedVertFile = "spriteInstancedVertFile";
 constexpr const char* LineVertFile = "lineVertFile";
 constexpr const char* TilemapVertFile = "tilemapVertFile";
 constexpr const char* SpriteFragFile = "spriteFragFile";
@@ -17,6 +18,7 @@ constexpr const char* WhiteImageFile = "whiteImageFile";
 
 // Vertex shaders
 constexpr const char* SpriteVertShader = "spriteVertShader";
+constexpr const char* SpriteInstancedVertShader = "spriteInstancedVertShader";
 constexpr const char* TilemapVertShader = "tilemapVertShader";
 constexpr const char* LineVertShader = "lineVertShader";
 // Fragment shaders
@@ -24,6 +26,7 @@ constexpr const char* SpriteFragShader = "spriteFragShader";
 constexpr const char* LineFragShader = "lineFragShader";
 // Programs
 constexpr const char* SpriteShader = "spriteShader";
+constexpr const char* SpriteInstancedShader = "spriteInstancedShader";
 constexpr const char* TilemapShader = "tilemapShader";
 constexpr const char* LineShader = "lineShader";
 
@@ -38,6 +41,7 @@ constexpr const char* ImagesDir = ENGINE_ASSETS_PATH "/images/";
 
 // Vertex
 inline std::string SpriteVertFile() { return ShadersDir + std::string("sprite.vert"); }
+inline std::string SpriteInstancedVertFile() { return ShadersDir + std::string("spriteInstanced.vert"); }
 inline std::string TilemapVertFile() { return ShadersDir + std::string("tilemap.vert"); }
 inline std::string LineVertFile() { return ShadersDir + std::string("line.vert"); }
 // Fragment
@@ -1,6 +1,7 @@
 // Standard libraries
 #include <functional>
 #include <algorithm>
+#include <numeric>
 #include <cmath>
 #include <memory>
 #include <ranges>
@@ -16,9 +17,13 @@
 
 #include <stdexcept>
 #include <limits>
+#include <bit>
+#include <optional>
 
 #include <array>
+#include <span>
 #include <vector>
+#include <deque>
 #include <stack>
 #include <queue>
 #include <unordered_map>
@@ -28,6 +33,11 @@
 
 #include <concepts>
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
 
 // Third party libraries
 
@@ -11,6 +11,8 @@ public:
     virtual ~ISystem() = default;
 	virtual void onAttach() {}; // NOTE: called only on creation, consider if this is correct order of operations.
     virtual void update(float deltaTime) {};
+    // Called at the fixed tick rate of the app, zero or more times per frame before update
+    virtual void fixedUpdate(float /*fixedDeltaTime*/) {};
 private:
 };
 
@@ -26,6 +26,14 @@ public:
         }
     }
 
+    void fixedUpdateSystems(float fixedDeltaTime)
+    {
+        for (auto& system : m_systems)
+        {
+            system->fixedUpdate(fixedDeltaTime);
+        }
+    }
+
 private:
     std::vector<std::unique_ptr<ISystem>> m_systems;
 };
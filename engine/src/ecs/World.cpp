@@ -19,7 +19,12 @@ ID World::createEntity()
 {
 	// Delays the creation of the entity to avoid incosistencies when systems add 
 	// entities, but does return the appropriate ID for the rest of the system to use.
+#ifdef DETERMINISTIC_MODE
+	// IDs only depend on the entities created in this world
+	ID entityID = m_nextEntityID++;
+#else
 	ID entityID = GET_INSTANCE_ID(World, void); // consider global ids under World.
+#endif
 	
 	m_deferredActions.actions.push_back([this, entityID]() mutable {
 		createEntityImpl(entityID);
@@ -92,8 +97,8 @@ void World::createEntityImpl(ID entityID)
 		it = m_archetypes.emplace(sig, std::make_shared<Archetype>(Archetype(sig, {}))).first;
 	}
 
-	m_entityRecords.emplace(entityID, EntityRecord{ 0, it->second });
-	it->second->addEntity({}, entityID); // Add empty entity to archetype.
+	uint32_t entityIndex = it->second->addEntity({}, entityID); // Add empty entity to archetype.
+	m_entityRecords.emplace(entityID, EntityRecord{ entityIndex, it->second });
 }
 
 std::shared_ptr<Archetype> World::getArchetype(Signature& sig)
@@ -127,7 +132,8 @@ std::shared_ptr<Archetype> World::getArchetype(Signature& sig)
 	// and the id based archetype map.
 	if (inserted)
 	{
-		ID archID = archetypeIt->second->getInstanceID();
+		// Indexes count the archetypes of this world only, queries visit archetypes in the order they were created
+		ID archID = static_cast<ID>(m_archetypesByID.size());
 		m_archetypesByID[archID] = archetypeIt->second;
 
 		for (ID id : sig.getTypeIDs())
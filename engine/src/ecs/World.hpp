@@ -25,7 +25,7 @@ struct DefferedActions {
 	std::vector<std::function<void()>> actions;
 
 	std::set<ID> removedEntities;
-	std::set<ID> enhancedEntities;
+	std::set<std::pair<ID, ID>> enhancedEntities; // Entity ID and added component type ID
 };
 
 static constexpr size_t DEFAULT_ARCHETYPES_SIZE = 128;
@@ -68,10 +68,15 @@ public:
 	// systems change world states.
 	template <typename ...ComponentTypes>
 	void addComponents(ID entityID, ComponentTypes&&... components) {
-		if (m_deferredActions.enhancedEntities.find(entityID) != m_deferredActions.enhancedEntities.end())
+		std::vector<ID> newTypeIDs = { GET_TYPE_ID(Component, std::decay_t<ComponentTypes>)... };
+		for (ID typeID : newTypeIDs)
 		{
-			// If the entity is already being enhanced, we can skip this action.
-			return;
+			if (m_deferredActions.enhancedEntities.find({ entityID, typeID }) != m_deferredActions.enhancedEntities.end())
+			{
+				// If the entity is already being enhanced with one of these components, we can skip this action.
+				// Adds of other components still go through (eg: engine systems tagging entities).
+				return;
+			}
 		}
 
 		// Capture components by forwarding each of them separately
@@ -79,7 +84,16 @@ public:
 			// Forward the components correctly to addImpl
 			addComponentsImpl(entityID, std::forward<ComponentTypes>(components)...);
 		});
-		m_deferredActions.enhancedEntities.insert(entityID);
+		for (ID typeID : newTypeIDs)
+			m_deferredActions.enhancedEntities.insert({ entityID, typeID });
+	}
+
+	// Removals are delayed till next update like additions.
+	template <typename ...ComponentTypes>
+	void removeComponents(ID entityID) {
+		m_deferredActions.actions.push_back([this, entityID]() {
+			removeComponentsImpl<ComponentTypes...>(entityID);
+		});
 	}
 
 	// Wrapper to hold component types
@@ -139,6 +153,7 @@ private:
 		);
 
 		auto entityIt = m_entityRecords.find(entityID);
+		if (entityIt == m_entityRecords.end() && m_deferredActions.removedEntities.contains(entityID)) return; // Removed earlier in the same update
 		ASSERT(entityIt != m_entityRecords.end(), "Entity not found");
 
 		EntityRecord& rec = entityIt->second;
@@ -158,7 +173,7 @@ private:
 		};
 		for (auto id : oldSig.getTypeIDs())
 		{
-			void* comp = oldArch.getComponent(rec.entityIndex, id);
+			void* comp = oldArch.getComponent(rec.entityIndex, oldSig.getIndex(id));
 			transferedComponents.push_back({ id, comp });
 		}
 
@@ -169,6 +184,42 @@ private:
 		rec.entityIndex = index;
 	}
 
+	template <typename ...ComponentTypes>
+	void removeComponentsImpl(ID entityID)
+	{
+		auto entityIt = m_entityRecords.find(entityID);
+		if (entityIt == m_entityRecords.end() && m_deferredActions.removedEntities.contains(entityID)) return; // Removed earlier in the same update
+		ASSERT(entityIt != m_entityRecords.end(), "Entity not found");
+
+		EntityRecord& rec = entityIt->second;
+		Signature& oldSig = rec.archetype->getSignature();
+		std::vector<ID> removedTypeIDs = { GET_TYPE_ID(Component, std::decay_t<ComponentTypes>)... };
+		std::vector<ID> keptTypeIDs;
+		for (auto id : oldSig.getTypeIDs())
+		{
+			if (std::find(removedTypeIDs.begin(), removedTypeIDs.end(), id) == removedTypeIDs.end())
+				keptTypeIDs.push_back(id);
+		}
+		ASSERT(keptTypeIDs.size() + removedTypeIDs.size() == oldSig.getTypeIDs().size(), "A removed component is not on the entity");
+
+		Signature newSig = Signature(keptTypeIDs);
+		Archetype& oldArch = *rec.archetype;
+		rec.archetype = getArchetype(newSig); // Update entity record with updated archetype.
+
+		// Only the kept components move to the new archetype.
+		std::vector<std::tuple<ID, void*>> transferedComponents;
+		for (auto id : keptTypeIDs)
+		{
+			void* comp = oldArch.getComponent(rec.entityIndex, oldSig.getIndex(id));
+			transferedComponents.push_back({ id, comp });
+		}
+
+		uint32_t index = rec.archetype->addEntity(transferedComponents, entityID);
+
+		removeEntityFromArchHelper(rec.entityIndex, oldArch);
+		rec.entityIndex = index;
+	}
+
 	void removeEntityFromArchHelper(uint32_t entityIndex, Archetype& arch);
 
 	// Store actions to avoid incosistencies when systems change world states.
@@ -197,6 +248,10 @@ private:
 	std::shared_ptr<Archetype> getArchetype(Signature& sig);
 
 	std::function<void(ID entityID)> m_removeEntityCallback;
+
+#ifdef DETERMINISTIC_MODE
+	ID m_nextEntityID = 0;
+#endif
 };
 
 } // TileBite
@@ -17,6 +17,7 @@ public:
 	virtual void update(float deltaTime) override
 	{
 		glm::vec4 boundsColor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f); // Red color for bounds
+		glm::vec4 deepBoundsColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // White color for the deepest tree bounds
 		glm::vec4 collidersColor = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f); // Green color for colliders
 		glm::vec4 tilemapBoundsColor = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // Blue color for tilemap bounds
 		glm::vec4 helperBoundingBoxColor = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f); // Yellow color for bounding box of more complex shapes
@@ -24,9 +25,14 @@ public:
 		auto& renderer2D = EngineApp::getInstance()->getRenderer();
 		auto& physicsEngine = EngineApp::getInstance()->getSceneManager().getActiveScene()->getPhysicsEngine();
 		const auto& coreTreeBounds = physicsEngine.getCoreTreeInternalBounds();
-		for(const auto& bound : coreTreeBounds)
+		const auto& coreTreeDepths = physicsEngine.getCoreTreeInternalDepths();
+		uint32_t maxDepth = coreTreeDepths.empty() ? 0 : *std::max_element(coreTreeDepths.begin(), coreTreeDepths.end());
+		for (size_t i = 0; i < coreTreeBounds.size(); i++)
 		{
-			renderer2D.drawSquare(bound.Min, bound.Max, boundsColor);
+			// Depth heatmap, shallow nodes are drawn red and the deepest ones white
+			float depthRatio = maxDepth > 0 ? static_cast<float>(coreTreeDepths[i]) / maxDepth : 0.0f;
+			glm::vec4 depthColor = boundsColor + (deepBoundsColor - boundsColor) * depthRatio;
+			renderer2D.drawSquare(coreTreeBounds[i].Min, coreTreeBounds[i].Max, depthColor);
 		}
 
 		const auto& coreTreeColliders = physicsEngine.getCoreTreeColliders();
@@ -51,6 +57,34 @@ public:
 				renderer2D.drawSquare(boundingBox.Min, boundingBox.Max, helperBoundingBoxColor);
 				break;
 			}
+			case Collider::ColliderType::Polygon: {
+				const Polygon& polygon = collider.PolygonCollider;
+				for (uint32_t i = 0; i < polygon.Count; i++)
+					renderer2D.drawLine({ polygon.Vertices[i], polygon.Vertices[(i + 1) % polygon.Count], collidersColor });
+
+				AABB boundingBox = polygon.getBoundingBox();
+				renderer2D.drawSquare(boundingBox.Min, boundingBox.Max, helperBoundingBoxColor);
+				break;
+			}
+			case Collider::ColliderType::Capsule: {
+				const Capsule& capsule = collider.CapsuleCollider;
+				renderer2D.drawCircle(capsule.PointA, capsule.Radius, collidersColor);
+				renderer2D.drawCircle(capsule.PointB, capsule.Radius, collidersColor);
+
+				// Sides of the segment grown by the radius
+				glm::vec2 axis = capsule.PointB - capsule.PointA;
+				float length = glm::length(axis);
+				if (length > 0.0f)
+				{
+					glm::vec2 side = glm::vec2(-axis.y, axis.x) / length * capsule.Radius;
+					renderer2D.drawLine({ capsule.PointA + side, capsule.PointB + side, collidersColor });
+					renderer2D.drawLine({ capsule.PointA - side, capsule.PointB - side, collidersColor });
+				}
+
+				AABB boundingBox = capsule.getBoundingBox();
+				renderer2D.drawSquare(boundingBox.Min, boundingBox.Max, helperBoundingBoxColor);
+				break;
+			}
 			default:
 				ASSERT_FALSE("Unknown collider type");
 				break;
@@ -68,7 +102,57 @@ public:
 		{
 			renderer2D.drawSquare(collider.AABBCollider.Min, collider.AABBCollider.Max, helperBoundingBoxColor);
 		}
+
+#ifdef PHYSICS_PROFILING
+		drawProfilingOverlay(deltaTime);
+#endif
+	}
+
+private:
+#ifdef PHYSICS_PROFILING
+	static constexpr float FrameBudgetMs = 1000.0f / 60.0f;
+	float m_profilingLogTimer = 0.0f;
+
+	// No text rendering yet: physics timers are drawn as bars in the top left corner of the camera, scaled
+	// so the outline is a 60 FPS frame, and all counters are logged once per second.
+	void drawProfilingOverlay(float deltaTime)
+	{
+		auto& renderer2D = EngineApp::getInstance()->getRenderer();
+		auto& scene = *EngineApp::getInstance()->getSceneManager().getActiveScene();
+		PhysicsFrameStats stats = PhysicsEngine::getProfilingStats();
+
+		const AABB& frustum = scene.getCameraController()->getFrustum();
+		glm::vec2 frustumSize = frustum.Max - frustum.Min;
+		float barWidth = frustumSize.x * 0.25f;
+		float barHeight = frustumSize.y * 0.02f;
+		glm::vec2 origin = glm::vec2(frustum.Min.x, frustum.Max.y) + glm::vec2(barHeight, -barHeight * 2.0f);
+
+		const std::array<glm::vec4, static_cast<size_t>(PhysicsTimer::Count)> timerColors = {
+			glm::vec4(0.0f, 1.0f, 1.0f, 1.0f), // Queries
+			glm::vec4(1.0f, 0.0f, 1.0f, 1.0f), // Raycasts
+			glm::vec4(1.0f, 0.5f, 0.0f, 1.0f), // Pairs
+			glm::vec4(0.5f, 1.0f, 0.5f, 1.0f)  // Step
+		};
+		for (uint32_t i = 0; i < static_cast<uint32_t>(PhysicsTimer::Count); i++)
+		{
+			glm::vec2 min = origin - glm::vec2(0.0f, i * barHeight * 1.5f);
+			float ratio = std::min(static_cast<float>(stats.getMs(static_cast<PhysicsTimer>(i))) / FrameBudgetMs, 1.0f);
+			renderer2D.drawSquare(min, min + glm::vec2(barWidth, barHeight), glm::vec4(1.0f));
+			if (ratio > 0.0f)
+				renderer2D.drawSquare(min, min + glm::vec2(barWidth * ratio, barHeight), timerColors[i]);
+		}
+
+		m_profilingLogTimer += deltaTime;
+		if (m_profilingLogTimer >= 1.0f)
+		{
+			m_profilingLogTimer = 0.0f;
+			for (uint32_t i = 0; i < static_cast<uint32_t>(PhysicsCounter::Count); i++)
+				LOG_INFO("Physics {}: {}", PhysicsProfiler::getName(static_cast<PhysicsCounter>(i)), stats.get(static_cast<PhysicsCounter>(i)));
+			for (uint32_t i = 0; i < static_cast<uint32_t>(PhysicsTimer::Count); i++)
+				LOG_INFO("Physics {} time: {:.3f} ms", PhysicsProfiler::getName(static_cast<PhysicsTimer>(i)), stats.getMs(static_cast<PhysicsTimer>(i)));
+		}
 	}
+#endif
 };
 
 } // TileBite
@@ -9,19 +9,51 @@
 
 namespace TileBite {
 
+// Syncs collider components with the physics engine. Colliders left untouched for SleepAfterIdleUpdates fixed updates
+// are tagged with SleepingComponent and skipped, their components then report the next change (see SleepWatch)
+// and the collider is updated and woken up in the following fixed update.
 class ColliderUpdateSystem : public ISystem {
 public:
-    virtual void update(float deltaTime) override {
+    // Synced at the fixed tick rate, queries between fixed updates see the colliders of the last one
+    virtual void fixedUpdate(float /*fixedDeltaTime*/) override {
         auto activeScene = EngineApp::getInstance()->getSceneManager().getActiveScene();
         auto& physicsEngine = activeScene->getPhysicsEngine();
         auto& world = activeScene->getWorld();
         auto& activeSceneGraph = activeScene->getSceneGraph();
 
+        // A scene populated before its first update builds the broad phase at once, the colliders are clean after it.
+        // Runs once per scene, later colliders (or a scene starting empty) go through the incremental updates.
+        if (!physicsEngine.isBuilt()) {
+            m_initialColliders.clear();
+            m_initialStaticColliders.clear();
+            collectColliderType<AABBComponent>(world, activeSceneGraph);
+            collectColliderType<OBBComponent>(world, activeSceneGraph);
+            collectColliderType<CircleColliderComponent>(world, activeSceneGraph);
+            collectColliderType<PolygonColliderComponent>(world, activeSceneGraph);
+            collectColliderType<CapsuleColliderComponent>(world, activeSceneGraph);
+            physicsEngine.buildColliders(m_initialColliders, m_initialStaticColliders, &EngineApp::getInstance()->getThreadPool());
+        }
+
+        // Woken colliders are updated right away, the dirty pass below still skips them till the tag removal lands
+        auto& wokenColliders = physicsEngine.getWokenColliders();
+        for (ID entityID : wokenColliders) {
+            if (!world.entityExists(entityID)) continue;
+            wakeColliderType<AABBComponent>(world, physicsEngine, activeSceneGraph, entityID);
+            wakeColliderType<OBBComponent>(world, physicsEngine, activeSceneGraph, entityID);
+            wakeColliderType<CircleColliderComponent>(world, physicsEngine, activeSceneGraph, entityID);
+            wakeColliderType<PolygonColliderComponent>(world, physicsEngine, activeSceneGraph, entityID);
+            wakeColliderType<CapsuleColliderComponent>(world, physicsEngine, activeSceneGraph, entityID);
+        }
+        wokenColliders.clear();
+
         updateColliderType<AABBComponent>(world, physicsEngine, activeSceneGraph);
         updateColliderType<OBBComponent>(world, physicsEngine, activeSceneGraph);
         updateColliderType<CircleColliderComponent>(world, physicsEngine, activeSceneGraph);
+        updateColliderType<PolygonColliderComponent>(world, physicsEngine, activeSceneGraph);
+        updateColliderType<CapsuleColliderComponent>(world, physicsEngine, activeSceneGraph);
 
-        // Tilemaps are special
+        // Tilemaps are special, the physics engine only tracks their bounds and reads the solid tiles
+        // from the resource, so only moving, adding, switching to merged colliders or changing filters needs an update
         world.query<TilemapComponent, TransformComponent>().each([&](ID entityID, TilemapComponent* tilemap, TransformComponent* transform) {
             if (transform->isDirty() || tilemap->isDirty()) {
                 physicsEngine.updateTilemapColliderGroup(
@@ -29,7 +61,10 @@ public:
                     transform,
                     glm::vec2(tilemap->getResource()->getWidth(), tilemap->getResource()->getHeight()),
                     tilemap->getResource()->getWorldTileSize(),
-                    tilemap->getResource()->getSolidTiles()
+                    &tilemap->getResource()->getSolidTiles(),
+                    &tilemap->getResource()->getSolidOccupancy(),
+                    tilemap->getResource()->getSolidRects(),
+                    tilemap->getCollisionFilter()
                 );
                 transform->resetDirty();
                 tilemap->resetDirty();
@@ -38,21 +73,76 @@ public:
     }
 
 private:
+    constexpr static uint32_t SleepAfterIdleUpdates = 60;
+
+	std::vector<ColliderInfo> m_initialColliders;
+	std::vector<ColliderInfo> m_initialStaticColliders;
+
+	// Same traversal as updateColliderType, the dirty colliders are collected for a single build
 	template<typename ColliderComponent>
-	void updateColliderType(World& world, PhysicsEngine& physicsEngine, SceneGraph& activeSceneGraph) {
+	void collectColliderType(World& world, SceneGraph& activeSceneGraph) {
 		World::TypePack<ParentComponent> excludedTypes;
+
+		auto collect = [&](ID entityID, ColliderComponent* collider, TransformComponent* transform) {
+			auto& colliders = (collider->getBodyType() == BodyType::Static) ? m_initialStaticColliders : m_initialColliders;
+			colliders.push_back(PhysicsEngine::makeColliderInfo(entityID, &collider->getCollider(), transform, collider->getCollisionFilter()));
+		};
+
+		world.query<ColliderComponent, TransformComponent>(excludedTypes).each([&](ID entityID, ColliderComponent* collider, TransformComponent* transform) {
+			if (transform->isDirty() || collider->isDirty()) {
+				collect(entityID, collider, transform);
+				transform->resetDirty();
+				collider->resetDirty();
+			}
+		});
+
+		world.query<ColliderComponent, TransformComponent, ParentComponent>().each([&](
+			ID entityID,
+			ColliderComponent* collider,
+			TransformComponent* transform,
+			ParentComponent*)
+		{
+			auto& worldTransform = activeSceneGraph.getWorldTransform(entityID);
+			if (collider->isDirty() || worldTransform.isDirty()) {
+				collect(entityID, collider, &worldTransform);
+				transform->resetDirty();
+				collider->resetDirty();
+				worldTransform.resetDirty();
+			}
+		});
+	}
+
+	// Counts the fixed updates a clean collider stays untouched, puts it to sleep after SleepAfterIdleUpdates.
+	// The count stops there, the tag is only added with the next world actions.
+	template<typename ColliderComponent>
+	void countIdleUpdate(World& world, PhysicsEngine& physicsEngine, ID entityID, ColliderComponent* collider, TransformComponent* transform) {
+		if (collider->IdleUpdates >= SleepAfterIdleUpdates) return;
+		if (++collider->IdleUpdates == SleepAfterIdleUpdates) {
+			world.addComponents(entityID, SleepingComponent());
+			collider->watch(&physicsEngine.getWokenColliders(), entityID);
+			transform->watch(&physicsEngine.getWokenColliders(), entityID);
+		}
+	}
+
+	template<typename ColliderComponent>
+	void updateColliderType(World& world, PhysicsEngine& physicsEngine, SceneGraph& activeSceneGraph) {
+		World::TypePack<ParentComponent, SleepingComponent> excludedTypes;
         
         // Update colliders that have no parent link
 		world.query<ColliderComponent, TransformComponent>(excludedTypes).each([&](ID entityID, ColliderComponent* collider, TransformComponent* transform) {
 			if (transform->isDirty() || collider->isDirty()) {
-				physicsEngine.updateCollider(entityID, &collider->getCollider(), transform);
+				physicsEngine.updateCollider(entityID, &collider->getCollider(), transform, collider->getCollisionFilter(), collider->getBodyType());
 				transform->resetDirty();
 				collider->resetDirty();
+				collider->IdleUpdates = 0;
+			}
+			else {
+				countIdleUpdate(world, physicsEngine, entityID, collider, transform);
 			}
 	    });
 
         // Update colliders that have parent link
-        world.query<ColliderComponent, TransformComponent, ParentComponent>().each([&](
+        world.query<ColliderComponent, TransformComponent, ParentComponent>(World::TypePack<SleepingComponent>()).each([&](
             ID entityID,
             ColliderComponent* collider,
             TransformComponent* transform,
@@ -60,14 +150,48 @@ private:
         {
             auto& worldTransform = activeSceneGraph.getWorldTransform(entityID);
             if (collider->isDirty() || worldTransform.isDirty()) {
-                physicsEngine.updateCollider(entityID, &collider->getCollider(), &worldTransform);
+                physicsEngine.updateCollider(entityID, &collider->getCollider(), &worldTransform, collider->getCollisionFilter(), collider->getBodyType());
                 transform->resetDirty();
                 collider->resetDirty();
 				worldTransform.resetDirty();
+				collider->IdleUpdates = 0;
             }
+			else {
+				countIdleUpdate(world, physicsEngine, entityID, collider, transform);
+			}
         });
 	}
 
+	// Updates the collider of a woken entity and removes its tag. It stays watched till the removal lands, so changes
+	// in later fixed updates of the same frame still reach the physics engine.
+	template<typename ColliderComponent>
+	void wakeColliderType(World& world, PhysicsEngine& physicsEngine, SceneGraph& activeSceneGraph, ID entityID) {
+		ColliderComponent* collider = world.getComponent<ColliderComponent>(entityID);
+		if (!collider) return;
+
+		bool isAsleep = collider->IdleUpdates >= SleepAfterIdleUpdates;
+		bool isTagged = world.getComponent<SleepingComponent>(entityID) != nullptr;
+		if (!isAsleep && !isTagged) return; // Awake, the dirty pass syncs it
+
+		TransformComponent* transform = world.getComponent<TransformComponent>(entityID);
+		if (world.getComponent<ParentComponent>(entityID)) {
+			auto& worldTransform = activeSceneGraph.getWorldTransform(entityID);
+			physicsEngine.updateCollider(entityID, &collider->getCollider(), &worldTransform, collider->getCollisionFilter(), collider->getBodyType());
+			worldTransform.resetDirty();
+		}
+		else {
+			physicsEngine.updateCollider(entityID, &collider->getCollider(), transform, collider->getCollisionFilter(), collider->getBodyType());
+		}
+		transform->resetDirty();
+		collider->resetDirty();
+
+		if (isAsleep) {
+			collider->IdleUpdates = 0;
+			world.removeComponents<SleepingComponent>(entityID);
+		}
+		collider->watch(&physicsEngine.getWokenColliders(), entityID);
+		transform->watch(&physicsEngine.getWokenColliders(), entityID);
+	}
 };
 
 } // TileBite
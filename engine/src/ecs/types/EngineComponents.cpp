@@ -6,9 +6,17 @@ namespace TileBite {
 // Needs to be in CPP file to avoid circular dependency issues
 void TilemapComponent::setTile(Tile tile, uint8_t xIndex, uint8_t yIndex)
 {
+	// Tilemap collider groups share the solid tiles of the resource,
+	// so tile edits don't need a collider update (the component is not marked dirty)
 	if (m_tilemapResource)
-	{
 		m_tilemapResource->setTile(tile, xIndex, yIndex);
+}
+
+void TilemapComponent::setMergedColliders(bool enabled)
+{
+	if (m_tilemapResource)
+	{
+		m_tilemapResource->setMergedSolidRects(enabled);
 		BaseComponent::setDirty(true);
 	}
 }
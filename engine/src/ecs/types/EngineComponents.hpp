@@ -8,6 +8,10 @@
 #include "physics/AABB.hpp"
 #include "physics/OBB.hpp"
 #include "physics/Circle.hpp"
+#include "physics/Polygon.hpp"
+#include "physics/Capsule.hpp"
+#include "physics/CollisionFilter.hpp"
+#include "physics/BodyType.hpp"
 
 
 namespace TileBite {
@@ -28,7 +32,38 @@ struct SpriteComponent : public BaseComponent
 	}
 };
 
-struct TransformComponent : public BaseComponent {
+// Tells ColliderUpdateSystem about changes of sleeping colliders. The first change after watch() pushes the entity to
+// the woken list and ends the watch, copies are never watched (eg: the world transforms of the scene graph).
+struct SleepWatch {
+	SleepWatch() = default;
+	SleepWatch(const SleepWatch&) {}
+
+	// Assigned components changed as a whole, the watch stays with the assigned one
+	SleepWatch& operator=(const SleepWatch&)
+	{
+		notifyChange();
+		return *this;
+	}
+
+	void watch(std::vector<ID>* wokenIDs, ID entityID)
+	{
+		m_wokenIDs = wokenIDs;
+		m_entityID = entityID;
+	}
+
+	void notifyChange()
+	{
+		if (!m_wokenIDs) return;
+		m_wokenIDs->push_back(m_entityID);
+		m_wokenIDs = nullptr;
+	}
+
+private:
+	std::vector<ID>* m_wokenIDs = nullptr;
+	ID m_entityID = 0;
+};
+
+struct TransformComponent : public BaseComponent, public SleepWatch {
 	TransformComponent(
 		const glm::vec2& position = { 0.0f, 0.0f },
 		const glm::vec2& size = { 1.0f, 1.0f },
@@ -43,16 +78,19 @@ struct TransformComponent : public BaseComponent {
 	void setPosition(const glm::vec2& position) {
 		m_position = position;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
 	void setSize(const glm::vec2& size) {
 		m_size = size;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
 	void setRotation(float rotation) {
 		m_rotation = rotation;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
 private:
@@ -79,17 +117,30 @@ struct Tile : public BaseComponent {
 struct TilemapComponent : public BaseComponent {
 	void setTile(Tile tile, uint8_t xIndex, uint8_t yIndex);
 
+	// Solid tiles are reported as merged rectangles by physics queries (see TilemapResource::setMergedSolidRects)
+	void setMergedColliders(bool enabled);
+
 	TilemapComponent(TilemapResource* ptr = nullptr)
 		: m_tilemapResource(ptr) {
 	}
 
 	TilemapResource* getResource() { return m_tilemapResource; }
 
+	const CollisionFilter& getCollisionFilter() const { return m_filter; }
+
+	// Every solid tile belongs to the categoryBits layers and only collides with the maskBits layers
+	void setCollisionFilter(uint16_t categoryBits, uint16_t maskBits)
+	{
+		m_filter = CollisionFilter{ categoryBits, maskBits };
+		BaseComponent::setDirty(true);
+	}
+
 private:
 	TilemapResource* m_tilemapResource;
+	CollisionFilter m_filter;
 };
 
-struct AABBComponent : public BaseComponent {
+struct AABBComponent : public BaseComponent, public SleepWatch {
 	AABBComponent() : m_collider(glm::vec2(0.0f), glm::vec2(0.0f)) {}
 	AABBComponent(const glm::vec2& min, const glm::vec2& max) : m_collider(min, max) {}
 
@@ -99,13 +150,38 @@ struct AABBComponent : public BaseComponent {
 	{
 		m_collider.setSize(min, max);
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	const CollisionFilter& getCollisionFilter() const { return m_filter; }
+
+	// Collider belongs to the categoryBits layers and only collides with the maskBits layers
+	void setCollisionFilter(uint16_t categoryBits, uint16_t maskBits)
+	{
+		m_filter = CollisionFilter{ categoryBits, maskBits };
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	BodyType getBodyType() const { return m_bodyType; }
+
+	void setBodyType(BodyType bodyType)
+	{
+		m_bodyType = bodyType;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
+	// Fixed updates since the collider or its transform last changed, counted by ColliderUpdateSystem to put it to sleep
+	uint32_t IdleUpdates = 0;
+
 private:
 	AABB m_collider;
+	CollisionFilter m_filter;
+	BodyType m_bodyType = BodyType::Dynamic;
 };
 
-struct OBBComponent : public BaseComponent {
+struct OBBComponent : public BaseComponent, public SleepWatch {
 	OBBComponent() : m_collider() {}
 	OBBComponent(glm::vec2 center, glm::vec2 size, float rotation) 
 		: m_collider(center, size, rotation) {}
@@ -115,23 +191,50 @@ struct OBBComponent : public BaseComponent {
 	void setCenter(const glm::vec2& center) {
 		m_collider.Center = center;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
 	void setSize(const glm::vec2& size) {
 		m_collider.Size = size;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
 	void setRotation(float rotation) {
 		m_collider.Rotation = rotation;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	const CollisionFilter& getCollisionFilter() const { return m_filter; }
+
+	// Collider belongs to the categoryBits layers and only collides with the maskBits layers
+	void setCollisionFilter(uint16_t categoryBits, uint16_t maskBits)
+	{
+		m_filter = CollisionFilter{ categoryBits, maskBits };
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
+	BodyType getBodyType() const { return m_bodyType; }
+
+	void setBodyType(BodyType bodyType)
+	{
+		m_bodyType = bodyType;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	// Fixed updates since the collider or its transform last changed, counted by ColliderUpdateSystem to put it to sleep
+	uint32_t IdleUpdates = 0;
+
 private:
 	OBB m_collider;
+	CollisionFilter m_filter;
+	BodyType m_bodyType = BodyType::Dynamic;
 };
 
-struct CircleColliderComponent : public BaseComponent {
+struct CircleColliderComponent : public BaseComponent, public SleepWatch {
 	CircleColliderComponent() : m_collider() {}
 	CircleColliderComponent(glm::vec2 center, float radius)
 		: m_collider(center, radius) {
@@ -142,17 +245,174 @@ struct CircleColliderComponent : public BaseComponent {
 	void setCenter(const glm::vec2& center) {
 		m_collider.Center = center;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
 	void setSize(float radius) {
 		m_collider.Radius = radius;
 		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
 	}
 
+	const CollisionFilter& getCollisionFilter() const { return m_filter; }
+
+	// Collider belongs to the categoryBits layers and only collides with the maskBits layers
+	void setCollisionFilter(uint16_t categoryBits, uint16_t maskBits)
+	{
+		m_filter = CollisionFilter{ categoryBits, maskBits };
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	BodyType getBodyType() const { return m_bodyType; }
+
+	void setBodyType(BodyType bodyType)
+	{
+		m_bodyType = bodyType;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	// Fixed updates since the collider or its transform last changed, counted by ColliderUpdateSystem to put it to sleep
+	uint32_t IdleUpdates = 0;
+
 private:
 	Circle m_collider;
+	CollisionFilter m_filter;
+	BodyType m_bodyType = BodyType::Dynamic;
 };
 
+// Convex polygon of up to Polygon::MaxVertices vertices in local space, scaled, rotated and moved by the transform
+struct PolygonColliderComponent : public BaseComponent, public SleepWatch {
+	PolygonColliderComponent() : m_collider() {}
+	PolygonColliderComponent(std::span<const glm::vec2> vertices)
+		: m_collider(vertices) {
+	}
+
+	const Polygon& getCollider() { return m_collider; }
+
+	void setVertices(std::span<const glm::vec2> vertices) {
+		m_collider = Polygon(vertices);
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	const CollisionFilter& getCollisionFilter() const { return m_filter; }
+
+	// Collider belongs to the categoryBits layers and only collides with the maskBits layers
+	void setCollisionFilter(uint16_t categoryBits, uint16_t maskBits)
+	{
+		m_filter = CollisionFilter{ categoryBits, maskBits };
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	BodyType getBodyType() const { return m_bodyType; }
+
+	void setBodyType(BodyType bodyType)
+	{
+		m_bodyType = bodyType;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	// Fixed updates since the collider or its transform last changed, counted by ColliderUpdateSystem to put it to sleep
+	uint32_t IdleUpdates = 0;
+
+private:
+	Polygon m_collider;
+	CollisionFilter m_filter;
+	BodyType m_bodyType = BodyType::Dynamic;
+};
+
+struct CapsuleColliderComponent : public BaseComponent, public SleepWatch {
+	CapsuleColliderComponent() : m_collider() {}
+	CapsuleColliderComponent(glm::vec2 pointA, glm::vec2 pointB, float radius)
+		: m_collider(pointA, pointB, radius) {
+	}
+
+	const Capsule& getCollider() { return m_collider; }
+
+	void setSegment(const glm::vec2& pointA, const glm::vec2& pointB) {
+		m_collider.PointA = pointA;
+		m_collider.PointB = pointB;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	void setSize(float radius) {
+		m_collider.Radius = radius;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	const CollisionFilter& getCollisionFilter() const { return m_filter; }
+
+	// Collider belongs to the categoryBits layers and only collides with the maskBits layers
+	void setCollisionFilter(uint16_t categoryBits, uint16_t maskBits)
+	{
+		m_filter = CollisionFilter{ categoryBits, maskBits };
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	BodyType getBodyType() const { return m_bodyType; }
+
+	void setBodyType(BodyType bodyType)
+	{
+		m_bodyType = bodyType;
+		BaseComponent::setDirty(true);
+		SleepWatch::notifyChange();
+	}
+
+	// Fixed updates since the collider or its transform last changed, counted by ColliderUpdateSystem to put it to sleep
+	uint32_t IdleUpdates = 0;
+
+private:
+	Capsule m_collider;
+	CollisionFilter m_filter;
+	BodyType m_bodyType = BodyType::Dynamic;
+};
+
+// Makes a root entity with a collider a rigid body moved by the physics step. Mass 0 makes it static.
+struct RigidBodyComponent : public BaseComponent {
+	float Mass;
+	float Friction;
+	float Restitution;
+	float GravityScale;
+	bool FixedRotation;
+
+	RigidBodyComponent(
+		float mass = 1.0f,
+		float friction = 0.5f,
+		float restitution = 0.0f,
+		float gravityScale = 1.0f,
+		bool fixedRotation = false)
+		: Mass(mass), Friction(friction), Restitution(restitution), GravityScale(gravityScale), FixedRotation(fixedRotation) {
+	}
+};
+
+struct VelocityComponent : public BaseComponent {
+	glm::vec2 Linear;
+	float Angular; // Radians per second
+
+	VelocityComponent(const glm::vec2& linear = glm::vec2(0.0f), float angular = 0.0f)
+		: Linear(linear), Angular(angular) {
+	}
+};
+
+// Sprites of root entities with this component are drawn between their transforms of the last two fixed updates,
+// for entities moved in fixed updates (eg: rigid bodies) to move smoothly at any frame rate.
+struct InterpolationComponent : public BaseComponent {
+	glm::vec2 PreviousPosition = glm::vec2(0.0f);
+	float PreviousRotation = 0.0f;
+	bool HasPrevious = false; // Set by the first fixed update after adding the component
+};
+
+// Tag of collider entities left untouched for a while. ColliderUpdateSystem skips them every fixed update,
+// their collider and transform are watched (see SleepWatch) to wake them up (remove the tag) on their next change.
+struct SleepingComponent : public BaseComponent {};
+
 struct ParentComponent : public BaseComponent {
 	ParentComponent(ID parentID = 0) : m_parentID(parentID) {}
 
@@ -38,6 +38,12 @@ public:
 		activeSceneGraph.updateWorldTransforms();
 	}
 
+	// Child colliders are synced in fixed updates from the world transforms
+	virtual void fixedUpdate(float fixedDeltaTime) override
+	{
+		update(fixedDeltaTime);
+	}
+
 };
 
 } // TileBite
@@ -0,0 +1,29 @@
+#ifndef INTERPOLATION_UPDATE_SYSTEM_HPP
+#define INTERPOLATION_UPDATE_SYSTEM_HPP
+
+#include "ecs/ISystem.hpp"
+#include "ecs/types/EngineComponents.hpp"
+
+#include "core/EngineApp.hpp"
+
+namespace TileBite {
+
+// Keeps the transforms of interpolated entities from before each fixed update, runs before the systems that move them.
+class InterpolationUpdateSystem : public ISystem {
+public:
+	virtual void fixedUpdate(float /*fixedDeltaTime*/) override
+	{
+		auto activeScene = EngineApp::getInstance()->getSceneManager().getActiveScene();
+		auto& activeWorld = activeScene->getWorld();
+
+		activeWorld.query<InterpolationComponent, TransformComponent>().each([&](ID, InterpolationComponent* interpolation, TransformComponent* transform) {
+			interpolation->PreviousPosition = transform->getPosition();
+			interpolation->PreviousRotation = transform->getRotation();
+			interpolation->HasPrevious = true;
+		});
+	}
+};
+
+} // TileBite
+
+#endif // !INTERPOLATION_UPDATE_SYSTEM_HPP
@@ -0,0 +1,123 @@
+#ifndef PHYSICS_STEP_SYSTEM_HPP
+#define PHYSICS_STEP_SYSTEM_HPP
+
+#include "ecs/ISystem.hpp"
+#include "ecs/types/EngineComponents.hpp"
+#include "physics/RigidBodyData.hpp"
+
+#include "core/EngineApp.hpp"
+
+namespace TileBite {
+
+// Moves root entities with a RigidBodyComponent, VelocityComponent and a collider. Bodies rotate about their
+// transform position, colliders offset from it add to the moment of inertia. Runs after ColliderUpdateSystem
+// so the physics engine sees the colliders of this frame.
+class PhysicsStepSystem : public ISystem {
+public:
+    virtual void fixedUpdate(float fixedDeltaTime) override {
+        auto activeScene = EngineApp::getInstance()->getSceneManager().getActiveScene();
+        auto& physicsEngine = activeScene->getPhysicsEngine();
+        auto& world = activeScene->getWorld();
+
+        m_bodies.clear();
+        m_links.clear();
+
+        gatherBodies<AABBComponent>(world);
+        gatherBodies<OBBComponent>(world);
+        gatherBodies<CircleColliderComponent>(world);
+        gatherBodies<PolygonColliderComponent>(world);
+        gatherBodies<CapsuleColliderComponent>(world);
+        if (m_bodies.size() == 0) return;
+
+        physicsEngine.stepBodies(m_bodies, fixedDeltaTime, &EngineApp::getInstance()->getThreadPool());
+
+        for (uint32_t i = 0; i < m_bodies.size(); i++)
+        {
+            m_links[i].Transform->setPosition(m_bodies.Positions[i]);
+            m_links[i].Transform->setRotation(m_bodies.Rotations[i]);
+            m_links[i].Velocity->Linear = m_bodies.LinearVelocities[i];
+            m_links[i].Velocity->Angular = m_bodies.AngularVelocities[i];
+        }
+    }
+
+private:
+    // Components written back after the step, entry i belongs to body i
+    struct BodyLink {
+        TransformComponent* Transform;
+        VelocityComponent* Velocity;
+    };
+
+    RigidBodyData m_bodies;
+    std::vector<BodyLink> m_links;
+
+    // Moments of inertia about the world space center of each shape
+    static float getInertia(const AABB&, float) { return 0.0f; } // AABBs can't rotate
+    static float getInertia(const OBB& obb, float mass) { return mass * (obb.Size.x * obb.Size.x + obb.Size.y * obb.Size.y) / 12.0f; }
+    static float getInertia(const Circle& circle, float mass) { return 0.5f * mass * circle.Radius * circle.Radius; }
+
+    // Sum over the triangle fan around the centroid (same as b2ComputePolygonMass)
+    static float getInertia(const Polygon& polygon, float mass) {
+        glm::vec2 centroid = polygon.getCentroid();
+        float doubleArea = 0.0f, secondMoment = 0.0f;
+        for (uint32_t i = 0; i < polygon.Count; i++)
+        {
+            glm::vec2 e1 = polygon.Vertices[i] - centroid;
+            glm::vec2 e2 = polygon.Vertices[(i + 1) % polygon.Count] - centroid;
+            float cross = e1.x * e2.y - e1.y * e2.x;
+            doubleArea += cross;
+            secondMoment += cross * (glm::dot(e1, e1) + glm::dot(e1, e2) + glm::dot(e2, e2));
+        }
+        return (doubleArea > 0.0f) ? mass * secondMoment / (6.0f * doubleArea) : 0.0f;
+    }
+
+    // Box for the segment and two half circles moved to the ends (same as b2ComputeCapsuleMass)
+    static float getInertia(const Capsule& capsule, float mass) {
+        float radius = capsule.Radius;
+        float length = glm::length(capsule.PointB - capsule.PointA);
+        float boxMass = 2.0f * radius * length;
+        float circleMass = glm::pi<float>() * radius * radius;
+        float totalMass = boxMass + circleMass;
+        if (totalMass <= 0.0f) return 0.0f;
+
+        float boxInertia = boxMass * (4.0f * radius * radius + length * length) / 12.0f;
+        float lc = 4.0f * radius / (3.0f * glm::pi<float>());
+        float h = 0.5f * length;
+        float circleInertia = circleMass * (0.5f * radius * radius + h * h + 2.0f * h * lc);
+        return mass * (boxInertia + circleInertia) / totalMass;
+    }
+
+    static glm::vec2 getCenter(const AABB& aabb) { return (aabb.Min + aabb.Max) * 0.5f; }
+    static glm::vec2 getCenter(const OBB& obb) { return obb.Center; }
+    static glm::vec2 getCenter(const Circle& circle) { return circle.Center; }
+    static glm::vec2 getCenter(const Polygon& polygon) { return polygon.getCentroid(); }
+    static glm::vec2 getCenter(const Capsule& capsule) { return (capsule.PointA + capsule.PointB) * 0.5f; }
+
+    template<typename ColliderComponent>
+    void gatherBodies(World& world) {
+        World::TypePack<ParentComponent> excludedTypes;
+
+        // Static bodies are left to the physics engine as plain colliders
+        world.query<RigidBodyComponent, VelocityComponent, TransformComponent, ColliderComponent>(excludedTypes).each([&](
+            ID entityID,
+            RigidBodyComponent* body,
+            VelocityComponent* velocity,
+            TransformComponent* transform,
+            ColliderComponent* collider)
+        {
+            if (body->Mass <= 0.0f) return;
+
+            auto worldCollider = collider->getCollider().toWorldSpace(transform->getPosition(), transform->getSize(), transform->getRotation());
+            glm::vec2 offset = getCenter(worldCollider) - transform->getPosition();
+            float inertia = getInertia(worldCollider, body->Mass);
+            float inverseInertia = (body->FixedRotation || inertia <= 0.0f) ? 0.0f : 1.0f / (inertia + body->Mass * glm::dot(offset, offset));
+
+            m_bodies.add(entityID, transform->getPosition(), transform->getRotation(), velocity->Linear, velocity->Angular,
+                1.0f / body->Mass, inverseInertia, body->Friction, body->Restitution, body->GravityScale);
+            m_links.push_back(BodyLink{ transform, velocity });
+        });
+    }
+};
+
+} // TileBite
+
+#endif // !PHYSICS_STEP_SYSTEM_HPP
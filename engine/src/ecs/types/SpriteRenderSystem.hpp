@@ -18,13 +18,34 @@ public:
 		auto& activeWorld = activeScene->getWorld();
 		auto& activeSceneGraph = activeScene->getSceneGraph();
 
-		World::TypePack<ParentComponent> excludedTypes;
+		World::TypePack<ParentComponent, InterpolationComponent> excludedTypes;
 
 		// Render children without parent link
 		activeWorld.query<SpriteComponent, TransformComponent>(excludedTypes).each([&](ID entityID, SpriteComponent* spriteComp, TransformComponent* transformComp) {
 			renderer2D.drawQuad(SpriteQuad{ transformComp, spriteComp });
 		});
 
+		// Render interpolated children without parent link, the quads point to transforms kept until the next update
+		m_interpolatedTransforms.clear();
+		float alpha = EngineApp::getInstance()->getInterpolationAlpha();
+		World::TypePack<ParentComponent> excludedParentLink;
+		activeWorld.query<SpriteComponent, TransformComponent, InterpolationComponent>(excludedParentLink).each([&](
+			ID, SpriteComponent* spriteComp,
+			TransformComponent* transformComp, InterpolationComponent* interpolation)
+		{
+			if (!interpolation->HasPrevious)
+			{
+				renderer2D.drawQuad(SpriteQuad{ transformComp, spriteComp });
+				return;
+			}
+
+			TransformComponent& interpolated = m_interpolatedTransforms.emplace_back(
+				glm::mix(interpolation->PreviousPosition, transformComp->getPosition(), alpha),
+				transformComp->getSize(),
+				glm::mix(interpolation->PreviousRotation, transformComp->getRotation(), alpha));
+			renderer2D.drawQuad(SpriteQuad{ &interpolated, spriteComp });
+		});
+
 		// Render children with parent link
 		activeWorld.query<SpriteComponent, TransformComponent, ParentComponent>().each([&](
 			ID entityID, SpriteComponent* spriteComp, 
@@ -34,6 +55,9 @@ public:
 			renderer2D.drawQuad(SpriteQuad{ &worldTransform, spriteComp });
 		});
 	}
+
+private:
+	std::deque<TransformComponent> m_interpolatedTransforms; // Deque so drawn quads keep valid pointers while it grows
 };
 
 } // TileBite
@@ -41,6 +41,14 @@ public:
 		m_systemManager.updateSystems(deltaTime);
 	}
 
+	virtual void onFixedUpdate(float fixedDeltaTime)
+	{
+		if (!m_isEnabled)
+			return;
+
+		m_systemManager.fixedUpdateSystems(fixedDeltaTime);
+	}
+
 	virtual void onEvent(Event& event) 
 	{
 		if (!m_isEnabled)
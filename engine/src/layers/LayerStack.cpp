@@ -68,4 +68,12 @@ void LayerStack::onUpdate(float deltaTime)
 	}
 }
 
+void LayerStack::onFixedUpdate(float fixedDeltaTime)
+{
+	for (auto& layer : m_layers)
+	{
+		layer->onFixedUpdate(fixedDeltaTime);
+	}
+}
+
 } // TileBite
\ No newline at end of file
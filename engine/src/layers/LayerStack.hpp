@@ -18,6 +18,7 @@ public:
 
 	void dispatchEventToLayers(Event& event);
 	void onUpdate(float deltaTime);
+	void onFixedUpdate(float fixedDeltaTime);
 
 	std::shared_ptr<Layer> getLayerByName(const std::string& name) const;
 
@@ -9,6 +9,8 @@
 #include "input/InputManager.hpp"
 #include "ecs/types/CollidersUpdateSystem.hpp"
 #include "ecs/types/HierarchiesUpdateSystem.hpp"
+#include "ecs/types/InterpolationUpdateSystem.hpp"
+#include "ecs/types/PhysicsStepSystem.hpp"
 
 #include "core/EngineApp.hpp"
 
@@ -80,8 +82,10 @@ void SystemLayer::onAttach()
 	eventDispatcher.subscribe(mouseMovedEventCallback);
 	eventDispatcher.subscribe(mouseScrollEventCallback);
 
+	getSystemManager().addSystem(std::make_unique<InterpolationUpdateSystem>());
 	getSystemManager().addSystem(std::make_unique<HierarchiesUpdateSystem>());
 	getSystemManager().addSystem(std::make_unique<ColliderUpdateSystem>());
+	getSystemManager().addSystem(std::make_unique<PhysicsStepSystem>());
 }
 
 } // TileBite
\ No newline at end of file
@@ -3,7 +3,9 @@
 #include "physics/Collider.hpp"
 
 #include "physics/CollisionUtilities.hpp"
+#include "physics/GJK.hpp"
 #include "utilities/assertions.hpp"
+#include "utilities/DeterministicMath.hpp"
 
 namespace TileBite {
 
@@ -17,8 +19,8 @@ AABB AABB::toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) const
     }
 
     // rotation math
-    float c = cos(radians);
-    float s = sin(radians);
+    float c = simCos(radians);
+    float s = simSin(radians);
 
     glm::vec2 centerPoint = (Max + Min) * 0.5f;
     glm::vec2 rotatedCenter(
@@ -61,6 +63,8 @@ bool AABB::contains(const Collider& other) const
 	case Collider::ColliderType::AABB:   return contains(other.AABBCollider);
     case Collider::ColliderType::OBB:    return contains(other.OBBCollider);
     case Collider::ColliderType::Circle: return contains(other.CircleCollider);
+    case Collider::ColliderType::Polygon: return contains(other.PolygonCollider);
+    case Collider::ColliderType::Capsule: return contains(other.CapsuleCollider);
     default: ASSERT_FALSE("Unknown collider type");
     }
     return false;
@@ -71,6 +75,16 @@ bool AABB::contains(const Circle& other) const
     return contains(other.getBoundingBox());
 }
 
+bool AABB::contains(const Polygon& other) const
+{
+    return contains(other.getBoundingBox());
+}
+
+bool AABB::contains(const Capsule& other) const
+{
+    return contains(other.getBoundingBox());
+}
+
 bool AABB::intersects(const OBB& other) const
 {
 	return CollisionUtilities::intersects(*this, other);
@@ -86,4 +100,14 @@ bool AABB::intersects(const Circle& other) const
     return CollisionUtilities::intersects(*this, other);
 }
 
+bool AABB::intersects(const Polygon& other) const
+{
+    return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool AABB::intersects(const Capsule& other) const
+{
+    return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
 } // TileBite
\ No newline at end of file
@@ -8,6 +8,8 @@ namespace TileBite {
 struct OBB; // Forward declaration to avoid circular dependency
 struct Collider;
 struct Circle;
+struct Polygon;
+struct Capsule;
 
 struct AABB {
 	glm::vec2 Min; // Minimum point (bottom-left corner)
@@ -52,9 +54,18 @@ struct AABB {
 		return contains(other.Min) && contains(other.Max);
 	}
 
+	// Distance from point to the box, 0 inside
+	inline float distance(const glm::vec2& point) const noexcept
+	{
+		glm::vec2 outside = glm::max(glm::max(Min - point, point - Max), glm::vec2(0.0f));
+		return glm::length(outside);
+	}
+
 	bool contains(const OBB& other) const;
 	bool contains(const Collider& other) const;
 	bool contains(const Circle& other) const;
+	bool contains(const Polygon& other) const;
+	bool contains(const Capsule& other) const;
 
 	inline bool intersects(const AABB& other) const noexcept
 	{
@@ -65,6 +76,8 @@ struct AABB {
 	bool intersects(const OBB& other) const;
 	bool intersects(const Collider& other) const;
 	bool intersects(const Circle& other) const;
+	bool intersects(const Polygon& other) const;
+	bool intersects(const Capsule& other) const;
 
 	inline void setSize(const glm::vec2& min, const glm::vec2& max) noexcept
 	{
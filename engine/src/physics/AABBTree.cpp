@@ -6,10 +6,10 @@ namespace TileBite {
 
 void AABBTree::insert(const ColliderInfo& colliderInfo)
 {
-	// TODO: tree rebalancing !!!!!!!!!
+	ASSERT(m_leafIndices.find(colliderInfo.id) == m_leafIndices.end(), "Collider is already in the tree");
 
 	uint32_t newNodeIndex = createLeafNode(colliderInfo);
-	m_leafNodesIndices[colliderInfo.id] = newNodeIndex;
+	if (m_trackMoves) m_movedIDs.push_back(colliderInfo.id);
 
 	if (m_rootIndex == NullIndex)
 	{
@@ -24,42 +24,40 @@ void AABBTree::insert(const ColliderInfo& colliderInfo)
 
 uint32_t AABBTree::findBestSibbling(uint32_t newLeafIndex)
 {
-	// Branch and bound algorithm to find the best sibling node for the new leaf
+	// Branch and bound algorithm to find the best sibling node for the new leaf.
+	// The cost of choosing a node as sibling is the area of the new parent plus the area
+	// every ancestor grows by (inherited cost), which also bounds the cost of its children.
 
-	float bestCost = std::numeric_limits<float>::max();
-	uint32_t bestIndex = m_rootIndex;
-
-	static std::vector<uint32_t> nodeQueue;
-	nodeQueue.reserve(256);
+	std::vector<SiblingCandidate>& nodeQueue = m_siblingQueue;
 	nodeQueue.clear();
 	uint32_t queueHead = 0;
-	nodeQueue.push_back(m_rootIndex);
+	nodeQueue.push_back(SiblingCandidate{ m_rootIndex, 0.0f });
+
+	const AABB newBounds = getNode(newLeafIndex).Bounds;
+	float newNodeArea = newBounds.getArea();
 
-	Node& newNode = m_nodePool.get(newLeafIndex);
-	float newNodeArea = newNode.Bounds.getArea();
+	float bestCost = std::numeric_limits<float>::max();
+	uint32_t bestIndex = m_rootIndex;
 	while (queueHead < nodeQueue.size())
 	{
-		uint32_t currIndex = nodeQueue[queueHead++];
-		if(currIndex == NullIndex)
-			continue;
-
-		const Node& currNode = m_nodePool.get(currIndex);
-		
-		float newParentArea = AABB::getUnion(currNode.Bounds, newNode.Bounds).getArea();
-		float deltaCost = computeRefitCostDelta(currNode.ParentIndex, newParentArea, bestCost);
+		SiblingCandidate candidate = nodeQueue[queueHead++];
+		const Node& currNode = getNode(candidate.Index);
 
-		float lowerBound = newNodeArea + deltaCost;
-		float cost = newParentArea + deltaCost;
+		float newParentArea = AABB::getUnion(currNode.Bounds, newBounds).getArea();
+		float cost = newParentArea + candidate.InheritedCost;
 		if (cost < bestCost)
 		{
 			bestCost = cost;
-			bestIndex = currIndex;
+			bestIndex = candidate.Index;
 		}
 
-		if (lowerBound < bestCost)
+		// Children would also grow this node
+		float inheritedCost = candidate.InheritedCost + newParentArea - currNode.Bounds.getArea();
+		float lowerBound = newNodeArea + inheritedCost;
+		if (!currNode.isLeaf() && lowerBound < bestCost)
 		{
-			nodeQueue.push_back(currNode.LeftIndex);
-			nodeQueue.push_back(currNode.RightIndex);
+			nodeQueue.push_back(SiblingCandidate{ currNode.LeftIndex, inheritedCost });
+			nodeQueue.push_back(SiblingCandidate{ currNode.RightIndex, inheritedCost });
 		}
 	}
 
@@ -69,62 +67,190 @@ uint32_t AABBTree::findBestSibbling(uint32_t newLeafIndex)
 
 uint32_t AABBTree::createLeafNode(const ColliderInfo& colliderInfo)
 {
-	uint32_t newNodeIndex = m_nodePool.createNode(Node{ .IsLeaf = true });
-	Node& newNode = m_nodePool.get(newNodeIndex);
+	uint32_t newNodeIndex = allocateNode();
+	uint32_t payloadIndex = static_cast<uint32_t>(m_leaves.size());
+	m_leaves.push_back(LeafPayload{ colliderInfo, newNodeIndex });
+	m_leafIndices[colliderInfo.id] = payloadIndex;
+
+	Node& newNode = getNode(newNodeIndex);
 	newNode.Bounds = AABB::inflate(colliderInfo.getAABBBounds());
-	newNode.Value = colliderInfo;
+	newNode.LeftIndex = payloadIndex;
+	newNode.CategoryBits = colliderInfo.Filter.CategoryBits;
 
 	return newNodeIndex;
 }
 
+uint32_t AABBTree::allocateNode()
+{
+	uint32_t index;
+	if (m_freeListHead != NullIndex)
+	{
+		// Reuse the most recently freed node
+		index = m_freeListHead;
+		m_freeListHead = m_nodes[index].ParentIndex;
+		m_nodes[index] = Node{};
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+	}
+
+	return index;
+}
+
+void AABBTree::freeNode(uint32_t index)
+{
+	Node& node = getNode(index);
+	node.Height = -1;
+	node.ParentIndex = m_freeListHead;
+	m_freeListHead = index;
+}
+
+void AABBTree::removePayload(uint32_t payloadIndex)
+{
+	// Swap with the last payload to keep the array dense
+	uint32_t lastIndex = static_cast<uint32_t>(m_leaves.size()) - 1;
+	if (payloadIndex != lastIndex)
+	{
+		m_leaves[payloadIndex] = std::move(m_leaves[lastIndex]);
+		const LeafPayload& moved = m_leaves[payloadIndex];
+		getNode(moved.NodeIndex).LeftIndex = payloadIndex;
+		m_leafIndices[moved.Info.id] = payloadIndex;
+	}
+	m_leaves.pop_back();
+}
+
 void AABBTree::refitParentNodes(uint32_t startingIndex)
 {
+	PHYSICS_PROFILE_LOCAL(refits, TreeRefits);
 	uint32_t updateIndex = startingIndex;
 	while (updateIndex != NullIndex)
 	{
-		Node& updateNode = m_nodePool.get(updateIndex);
-		ASSERT(updateNode.IsLeaf == false, "Refitting parent node that is a leaf");
-		updateNode.Bounds = AABB::getUnion(m_nodePool.get(updateNode.LeftIndex).Bounds, m_nodePool.get(updateNode.RightIndex).Bounds);
-		updateIndex = updateNode.ParentIndex;
+		ASSERT(getNode(updateIndex).isLeaf() == false, "Refitting parent node that is a leaf");
+		PHYSICS_PROFILE_INC(refits);
+		refitNode(updateIndex);
+		rotate(updateIndex);
+		updateIndex = getNode(updateIndex).ParentIndex;
 	}
 }
 
-float AABBTree::computeRefitCostDelta(uint32_t startingIndex, float newParentArea, float bestCost) const
+void AABBTree::refitNode(uint32_t index)
 {
-	float deltaCost = 0.0f;
+	Node& node = getNode(index);
+	const Node& left = getNode(node.LeftIndex);
+	const Node& right = getNode(node.RightIndex);
+	node.Bounds = AABB::getUnion(left.Bounds, right.Bounds);
+	node.CategoryBits = left.CategoryBits | right.CategoryBits;
+	ASSERT(std::max(left.Height, right.Height) < INT16_MAX, "AABBTree is too deep for 16 bit node heights");
+	node.Height = static_cast<int16_t>(1 + std::max(left.Height, right.Height));
+}
 
-	uint32_t currIndex = startingIndex;
-	while (currIndex != NullIndex)
+void AABBTree::refitCategories(uint32_t startingIndex)
+{
+	// Categories are or'ed upwards, ancestors are only visited while their categories change
+	uint32_t updateIndex = startingIndex;
+	while (updateIndex != NullIndex)
+	{
+		Node& node = getNode(updateIndex);
+		uint16_t categoryBits = getNode(node.LeftIndex).CategoryBits | getNode(node.RightIndex).CategoryBits;
+		if (categoryBits == node.CategoryBits) return;
+
+		node.CategoryBits = categoryBits;
+		updateIndex = node.ParentIndex;
+	}
+}
+
+void AABBTree::rotate(uint32_t index)
+{
+	// Tree rotations from the GDC talk. For node A with children B and C, a child of one side
+	// is swapped with a grandchild of the other side (B <-> F, B <-> G, C <-> D, C <-> E)
+	// if that reduces the area of the child that receives the swapped node.
+	// The bounds of A do not change since it still holds the same leaves.
+	//
+	//        A
+	//    +---+---+
+	//    B       C
+	//  +-+-+   +-+-+
+	//  D   E   F   G
+
+	const Node& nodeA = getNode(index);
+	if (nodeA.Height < 2) return;
+
+	uint32_t indexB = nodeA.LeftIndex;
+	uint32_t indexC = nodeA.RightIndex;
+	const Node& nodeB = getNode(indexB);
+	const Node& nodeC = getNode(indexC);
+
+	float bestDelta = 0.0f;
+	uint32_t bestAunt = NullIndex;
+	uint32_t bestNephew = NullIndex;
+
+	auto considerSwap = [&](uint32_t auntIndex, const AABB& auntBounds, const Node& parent, uint32_t nephewIndex, uint32_t remainingIndex) {
+		// Area of parent after the aunt takes the place of its nephew
+		float delta = AABB::getUnion(auntBounds, getNode(remainingIndex).Bounds).getArea() - parent.Bounds.getArea();
+		if (delta < bestDelta)
+		{
+			bestDelta = delta;
+			bestAunt = auntIndex;
+			bestNephew = nephewIndex;
+		}
+	};
+
+	if (!nodeC.isLeaf())
 	{
-		if (deltaCost + newParentArea > bestCost) break;
-
-		const Node& currNode = m_nodePool.get(currIndex);
-		ASSERT(currNode.IsLeaf == false, "Refiting cost delta should start with a parent node");
-		float oldSA = currNode.Bounds.getArea(); // TODO: Could be stored.
-		float newSA = AABB::getUnion(m_nodePool.get(currNode.LeftIndex).Bounds, m_nodePool.get(currNode.RightIndex).Bounds).getArea();
-		float delta = newSA - oldSA;
-		if (delta <= 0.001) break; // If delta is almost zero then parent delta will not change significantly, so we can stop here
-		ASSERT(delta >= 0, "Delta cost should not be negative");
-		deltaCost += delta;
-		currIndex = currNode.ParentIndex;
+		considerSwap(indexB, nodeB.Bounds, nodeC, nodeC.LeftIndex, nodeC.RightIndex);
+		considerSwap(indexB, nodeB.Bounds, nodeC, nodeC.RightIndex, nodeC.LeftIndex);
 	}
+	if (!nodeB.isLeaf())
+	{
+		considerSwap(indexC, nodeC.Bounds, nodeB, nodeB.LeftIndex, nodeB.RightIndex);
+		considerSwap(indexC, nodeC.Bounds, nodeB, nodeB.RightIndex, nodeB.LeftIndex);
+	}
+
+	if (bestAunt == NullIndex) return;
+
+	swapWithNephew(bestAunt, bestNephew);
+	refitNode(index); // Bounds are the same but the height may change
+}
+
+void AABBTree::swapWithNephew(uint32_t auntIndex, uint32_t nephewIndex)
+{
+	Node& aunt = getNode(auntIndex);
+	Node& nephew = getNode(nephewIndex);
+	uint32_t grandParentIndex = aunt.ParentIndex;
+	uint32_t parentIndex = nephew.ParentIndex;
+	Node& grandParent = getNode(grandParentIndex);
+	Node& parent = getNode(parentIndex);
+
+	if (grandParent.LeftIndex == auntIndex)
+		grandParent.LeftIndex = nephewIndex;
+	else
+		grandParent.RightIndex = nephewIndex;
 
-	return deltaCost;
+	if (parent.LeftIndex == nephewIndex)
+		parent.LeftIndex = auntIndex;
+	else
+		parent.RightIndex = auntIndex;
+
+	aunt.ParentIndex = parentIndex;
+	nephew.ParentIndex = grandParentIndex;
+	refitNode(parentIndex);
 }
 
 uint32_t AABBTree::createParentNode(uint32_t bestSiblingIndex, uint32_t newNodeIndex)
 {
-	uint32_t newParentNodeIndex = m_nodePool.createNode(Node{ .IsLeaf = false });
+	uint32_t newParentNodeIndex = allocateNode();
 
-	Node& newParentNode = m_nodePool.get(newParentNodeIndex);
-	Node& bestSiblingNode = m_nodePool.get(bestSiblingIndex);
-	Node& newNode = m_nodePool.get(newNodeIndex);
+	Node& newParentNode = getNode(newParentNodeIndex);
+	Node& bestSiblingNode = getNode(bestSiblingIndex);
+	Node& newNode = getNode(newNodeIndex);
 
 	uint32_t siblingParentIndex = bestSiblingNode.ParentIndex;
 
 	if(siblingParentIndex != NullIndex)
 	{
-		Node& siblingParentNode = m_nodePool.get(siblingParentIndex);
+		Node& siblingParentNode = getNode(siblingParentIndex);
 		if (siblingParentNode.LeftIndex == bestSiblingIndex)
 			siblingParentNode.LeftIndex = newParentNodeIndex;
 		else
@@ -141,23 +267,27 @@ uint32_t AABBTree::createParentNode(uint32_t bestSiblingIndex, uint32_t newNodeI
 	newParentNode.RightIndex = newNodeIndex;
 	newNode.ParentIndex = newParentNodeIndex;
 	bestSiblingNode.ParentIndex = newParentNodeIndex;
+	refitNode(newParentNodeIndex);
 
 	return newParentNodeIndex;
 }
 
 bool AABBTree::remove(ID id)
 {
-	// TODO: removing nodes leaves a gap in the nodes list, which is not ideal for cache locality
-	
-	if (m_leafNodesIndices.find(id) == m_leafNodesIndices.end())
+	auto it = m_leafIndices.find(id);
+	if (it == m_leafIndices.end())
 		return false;
 
-	uint32_t nodeIndex = m_leafNodesIndices[id]; // Find the index of the leaf node
-	Node& node = m_nodePool.get(nodeIndex);
-	ASSERT(node.IsLeaf, "Trying to remove non leaf node");
+	uint32_t payloadIndex = it->second;
+	uint32_t nodeIndex = m_leaves[payloadIndex].NodeIndex;
+	ASSERT(getNode(nodeIndex).isLeaf(), "Trying to remove non leaf node");
+
+	m_leafIndices.erase(it);
+	removePayload(payloadIndex);
+	if (m_trackMoves) m_movedIDs.push_back(id);
 
-	m_leafNodesIndices.erase(id);
-	m_nodePool.freeNode(nodeIndex);
+	uint32_t parentIndex = getNode(nodeIndex).ParentIndex;
+	freeNode(nodeIndex);
 
 	// If the node is the root, we need to update the root index
 	if (nodeIndex == m_rootIndex)
@@ -167,14 +297,12 @@ bool AABBTree::remove(ID id)
 	}
 
 	// If the node is not the root, we need to remove it from its parent
-	uint32_t parentIndex = node.ParentIndex;
-	Node& parentNode = m_nodePool.get(parentIndex);
+	const Node& parentNode = getNode(parentIndex);
 	uint32_t grandParentIndex = parentNode.ParentIndex;
-
-	m_nodePool.freeNode(parentIndex);
-
 	uint32_t siblingIndex = (parentNode.LeftIndex == nodeIndex) ? parentNode.RightIndex : parentNode.LeftIndex;
-	Node& siblingNode = m_nodePool.get(siblingIndex);
+	freeNode(parentIndex);
+
+	Node& siblingNode = getNode(siblingIndex);
 	// Update the sibling's parent index to point to the grandparent
 	siblingNode.ParentIndex = grandParentIndex;
 
@@ -184,7 +312,7 @@ bool AABBTree::remove(ID id)
 	}
 	else
 	{
-		Node& grandParentNode = m_nodePool.get(grandParentIndex);
+		Node& grandParentNode = getNode(grandParentIndex);
 		if (grandParentNode.LeftIndex == parentIndex)
 			grandParentNode.LeftIndex = siblingIndex;
 		else
@@ -198,104 +326,509 @@ bool AABBTree::remove(ID id)
 
 bool AABBTree::update(const ColliderInfo& colliderInfo)
 {
-	auto it = m_leafNodesIndices.find(colliderInfo.id);
-	if (it == m_leafNodesIndices.end()) return false;
+	auto it = m_leafIndices.find(colliderInfo.id);
+	if (it == m_leafIndices.end()) return false;
 
-	Node& node = m_nodePool.get(it->second);
+	LeafPayload& leaf = m_leaves[it->second];
+	const Node& node = getNode(leaf.NodeIndex);
 	const float shrinkThreshold = 0.5f;
 	if (node.Bounds.contains(colliderInfo) && colliderInfo.getArea() / node.Bounds.getArea() > shrinkThreshold)
 	{
 		// No need to update if the collider is still within the bounds
-		node.Value = colliderInfo;
+		bool filterChanged = leaf.Info.Filter != colliderInfo.Filter;
+		leaf.Info = colliderInfo;
+		if (filterChanged)
+		{
+			// Pairs of the collider have to be filtered again
+			if (m_trackMoves) m_movedIDs.push_back(colliderInfo.id);
+
+			Node& leafNode = getNode(leaf.NodeIndex);
+			leafNode.CategoryBits = colliderInfo.Filter.CategoryBits;
+			refitCategories(leafNode.ParentIndex);
+		}
 		return true;
 	}
 
 	remove(colliderInfo.id);
 	insert(colliderInfo);
 
+	PHYSICS_PROFILE_ADD(TreeReinsertions, 1);
+	m_reinsertionsSinceCheck++;
+	if (m_rebuildCostRatio > 0.0f && m_reinsertionsSinceCheck >= m_rebuildCheckInterval)
+		checkRebuildThreshold();
+
 	return true;
 }
 
-std::vector<CollisionData> AABBTree::query(const Collider& collider, ID excludeID) const {
+const ColliderInfo* AABBTree::getCollider(ID id) const
+{
+	auto it = m_leafIndices.find(id);
+	return it != m_leafIndices.end() ? &m_leaves[it->second].Info : nullptr;
+}
+
+const AABB& AABBTree::getFatBounds(ID id) const
+{
+	auto it = m_leafIndices.find(id);
+	ASSERT(it != m_leafIndices.end(), "Collider is not in the tree");
+	return getNode(m_leaves[it->second].NodeIndex).Bounds;
+}
+
+void AABBTree::setMoveTracking(bool enabled)
+{
+	m_trackMoves = enabled;
+	m_movedIDs.clear();
+	if (!enabled) return;
+
+	m_movedIDs.reserve(m_leaves.size());
+	for (const LeafPayload& leaf : m_leaves)
+		m_movedIDs.push_back(leaf.Info.id);
+}
+
+void AABBTree::setRebuildThreshold(float costRatio, uint32_t checkInterval)
+{
+	ASSERT(costRatio == 0.0f || costRatio >= 1.0f, "Rebuild cost ratio should be 0 (disabled) or at least 1");
+	m_rebuildCostRatio = costRatio;
+	m_rebuildCheckInterval = std::max(checkInterval, 1u);
+	m_reinsertionsSinceCheck = 0;
+	m_referenceCostPerLeaf = 0.0f;
+}
+
+void AABBTree::checkRebuildThreshold()
+{
+	m_reinsertionsSinceCheck = 0;
+	if (m_leaves.empty()) return;
+
+	// Cost is compared per leaf so that a growing tree does not trigger rebuilds on its own
+	float costPerLeaf = computeSAHCost() / m_leaves.size();
+	if (m_referenceCostPerLeaf <= 0.0f)
+	{
+		// No rebuild happened yet, the incrementally built tree is the reference
+		m_referenceCostPerLeaf = costPerLeaf;
+		return;
+	}
+
+	if (costPerLeaf > m_referenceCostPerLeaf * m_rebuildCostRatio)
+	{
+		rebuild();
+		m_referenceCostPerLeaf = computeSAHCost() / m_leaves.size();
+	}
+}
+
+void AABBTree::build(std::span<const ColliderInfo> colliders, ThreadPool* threadPool)
+{
+	// Colliders that were in the tree are reported as moved (removed) too
+	if (m_trackMoves)
+	{
+		for (const LeafPayload& leaf : m_leaves)
+			m_movedIDs.push_back(leaf.Info.id);
+	}
+
+	m_leaves.clear();
+	m_leafIndices.clear();
+	m_leaves.reserve(colliders.size());
+	m_leafIndices.reserve(colliders.size());
+
+	std::vector<BuildItem> items;
+	items.reserve(colliders.size());
+	for (const ColliderInfo& colliderInfo : colliders)
+	{
+		ASSERT(m_leafIndices.find(colliderInfo.id) == m_leafIndices.end(), "Collider is given twice to the tree build");
+
+		uint32_t payloadIndex = static_cast<uint32_t>(m_leaves.size());
+		m_leafIndices[colliderInfo.id] = payloadIndex;
+		m_leaves.push_back(LeafPayload{ colliderInfo, NullIndex });
+		items.push_back(BuildItem{ AABB::inflate(colliderInfo.getAABBBounds()), payloadIndex });
+		if (m_trackMoves) m_movedIDs.push_back(colliderInfo.id);
+	}
+
+	buildNodes(items, threadPool);
+
+	// The built tree is the reference of the automatic rebuilds
+	m_reinsertionsSinceCheck = 0;
+	m_referenceCostPerLeaf = (m_rebuildCostRatio > 0.0f && !m_leaves.empty()) ? computeSAHCost() / m_leaves.size() : 0.0f;
+}
+
+void AABBTree::rebuild(ThreadPool* threadPool)
+{
+	if (m_leaves.empty()) return;
+
+	// Leaves keep their fat bounds, every node is created again in a fresh array
+	std::vector<BuildItem> items;
+	items.reserve(m_leaves.size());
+	for (uint32_t i = 0; i < m_leaves.size(); i++)
+		items.push_back(BuildItem{ getNode(m_leaves[i].NodeIndex).Bounds, i });
+
+	buildNodes(items, threadPool);
+}
+
+void AABBTree::buildNodes(std::vector<BuildItem>& items, ThreadPool* threadPool)
+{
+	m_nodes.clear();
+	m_freeListHead = NullIndex;
+	m_rootIndex = NullIndex;
+	if (items.empty()) return;
+
+	// A subtree of n leaves takes 2n - 1 nodes, so the nodes of every subtree are known before it is built:
+	// a node is followed by its left subtree, then its right subtree (depth first layout).
+	// Subtrees write disjoint ranges of m_nodes, which never reallocates during the build.
+	uint32_t itemCount = static_cast<uint32_t>(items.size());
+	m_nodes.resize(2 * itemCount - 1);
+	m_rootIndex = 0;
+
+	if (threadPool == nullptr || itemCount < ParallelBuildMinLeaves)
+	{
+		buildSubtree(items, 0, itemCount, m_rootIndex, NullIndex);
+		return;
+	}
+
+	// The largest subtree is split on this thread until there are enough of them for every thread
+	struct BuildTask {
+		uint32_t Begin;
+		uint32_t End;
+		uint32_t NodeIndex;
+		uint32_t ParentIndex;
+	};
+	std::vector<BuildTask> tasks = { BuildTask{ 0, itemCount, m_rootIndex, NullIndex } };
+	std::vector<uint32_t> splitNodes;
+
+	uint32_t taskCount = ParallelBuildTasksPerThread * (threadPool->getWorkerCount() + 1);
+	while (tasks.size() < taskCount)
+	{
+		auto largest = std::max_element(tasks.begin(), tasks.end(), [](const BuildTask& a, const BuildTask& b) {
+			return a.End - a.Begin < b.End - b.Begin;
+		});
+		if (largest->End - largest->Begin < ParallelBuildMinLeaves / ParallelBuildTasksPerThread) break;
+
+		BuildTask task = *largest;
+		uint32_t mid = splitBuildItems(items, task.Begin, task.End);
+		uint32_t leftIndex = task.NodeIndex + 1;
+		uint32_t rightIndex = task.NodeIndex + 2 * (mid - task.Begin);
+
+		Node& node = getNode(task.NodeIndex);
+		node.ParentIndex = task.ParentIndex;
+		node.LeftIndex = leftIndex;
+		node.RightIndex = rightIndex;
+		splitNodes.push_back(task.NodeIndex);
+
+		*largest = BuildTask{ task.Begin, mid, leftIndex, task.NodeIndex };
+		tasks.push_back(BuildTask{ mid, task.End, rightIndex, task.NodeIndex });
+	}
+
+	threadPool->parallelFor(static_cast<uint32_t>(tasks.size()), 1, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+			buildSubtree(items, tasks[i].Begin, tasks[i].End, tasks[i].NodeIndex, tasks[i].ParentIndex);
+	});
+
+	// Nodes were split before their children, refitting in reverse goes bottom up
+	for (auto it = splitNodes.rbegin(); it != splitNodes.rend(); ++it)
+		refitNode(*it);
+}
+
+void AABBTree::buildSubtree(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t nodeIndex, uint32_t parentIndex)
+{
+	ASSERT(end > begin, "Building subtree from empty range");
+
+	if (end - begin == 1)
+	{
+		Node& leaf = getNode(nodeIndex);
+		leaf.Bounds = items[begin].Bounds;
+		leaf.ParentIndex = parentIndex;
+		leaf.LeftIndex = items[begin].PayloadIndex;
+		leaf.CategoryBits = m_leaves[items[begin].PayloadIndex].Info.Filter.CategoryBits;
+		m_leaves[items[begin].PayloadIndex].NodeIndex = nodeIndex;
+		return;
+	}
+
+	uint32_t mid = splitBuildItems(items, begin, end);
+	uint32_t leftIndex = nodeIndex + 1;
+	uint32_t rightIndex = nodeIndex + 2 * (mid - begin);
+	buildSubtree(items, begin, mid, leftIndex, nodeIndex);
+	buildSubtree(items, mid, end, rightIndex, nodeIndex);
+
+	Node& node = getNode(nodeIndex);
+	node.ParentIndex = parentIndex;
+	node.LeftIndex = leftIndex;
+	node.RightIndex = rightIndex;
+	refitNode(nodeIndex);
+}
+
+uint32_t AABBTree::splitBuildItems(std::vector<BuildItem>& items, uint32_t begin, uint32_t end)
+{
+	auto centroid = [](const BuildItem& item) {
+		return (item.Bounds.Min + item.Bounds.Max) * 0.5f;
+	};
+
+	// Split along the axis with the biggest centroid extent
+	glm::vec2 centroidMin(std::numeric_limits<float>::max());
+	glm::vec2 centroidMax(-std::numeric_limits<float>::max());
+	for (uint32_t i = begin; i < end; i++)
+	{
+		glm::vec2 c = centroid(items[i]);
+		centroidMin = glm::min(centroidMin, c);
+		centroidMax = glm::max(centroidMax, c);
+	}
+	int axis = (centroidMax.x - centroidMin.x >= centroidMax.y - centroidMin.y) ? 0 : 1;
+	float extent = centroidMax[axis] - centroidMin[axis];
+
+	uint32_t mid = begin + (end - begin) / 2;
+	bool binned = false;
+	if (extent > 0.0f)
+	{
+		// Binned SAH, centroids are bucketed in BinCount bins and every boundary between bins
+		// is evaluated as a split with cost = area(left) * leftCount + area(right) * rightCount
+		constexpr uint32_t BinCount = 16;
+		struct Bin {
+			AABB Bounds;
+			uint32_t Count = 0;
+		};
+		Bin bins[BinCount];
+
+		float binScale = BinCount / extent;
+		auto binOf = [&](const BuildItem& item) {
+			uint32_t bin = static_cast<uint32_t>((centroid(item)[axis] - centroidMin[axis]) * binScale);
+			return std::min(bin, BinCount - 1);
+		};
+
+		for (uint32_t i = begin; i < end; i++)
+		{
+			Bin& bin = bins[binOf(items[i])];
+			bin.Bounds = bin.Count == 0 ? items[i].Bounds : AABB::getUnion(bin.Bounds, items[i].Bounds);
+			bin.Count++;
+		}
+
+		// Sweep from the right to store the right partitions, then sweep from the left
+		float rightAreas[BinCount] = {};
+		uint32_t rightCounts[BinCount] = {};
+		AABB rightBounds;
+		uint32_t rightCount = 0;
+		for (uint32_t i = BinCount - 1; i > 0; i--)
+		{
+			if (bins[i].Count > 0)
+			{
+				rightBounds = rightCount == 0 ? bins[i].Bounds : AABB::getUnion(rightBounds, bins[i].Bounds);
+				rightCount += bins[i].Count;
+			}
+			rightAreas[i] = rightCount > 0 ? rightBounds.getArea() : 0.0f;
+			rightCounts[i] = rightCount;
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		uint32_t bestSplit = 0;
+		AABB leftBounds;
+		uint32_t leftCount = 0;
+		for (uint32_t i = 1; i < BinCount; i++)
+		{
+			if (bins[i - 1].Count > 0)
+			{
+				leftBounds = leftCount == 0 ? bins[i - 1].Bounds : AABB::getUnion(leftBounds, bins[i - 1].Bounds);
+				leftCount += bins[i - 1].Count;
+			}
+			if (leftCount == 0 || rightCounts[i] == 0) continue;
+
+			float cost = leftBounds.getArea() * leftCount + rightAreas[i] * rightCounts[i];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = i;
+			}
+		}
+
+		if (bestSplit > 0)
+		{
+			auto it = std::partition(items.begin() + begin, items.begin() + end, [&](const BuildItem& item) {
+				return binOf(item) < bestSplit;
+			});
+			mid = static_cast<uint32_t>(it - items.begin());
+			binned = mid > begin && mid < end;
+		}
+	}
+
+	if (!binned)
+	{
+		// All centroids fall in the same spot, median split
+		mid = begin + (end - begin) / 2;
+		std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, [&](const BuildItem& a, const BuildItem& b) {
+			return centroid(a)[axis] < centroid(b)[axis];
+		});
+	}
+
+	return mid;
+}
+
+uint32_t AABBTree::getHeight() const
+{
+	return m_rootIndex == NullIndex ? 0 : static_cast<uint32_t>(getNode(m_rootIndex).Height);
+}
+
+float AABBTree::computeSAHCost() const
+{
+	return getMetrics().SAHCost;
+}
+
+AABBTree::Metrics AABBTree::getMetrics() const
+{
+	Metrics metrics;
+	if (m_rootIndex == NullIndex) return metrics;
+
+	metrics.Height = getHeight();
+
+	std::vector<uint32_t> nodeStack;
+	nodeStack.push_back(m_rootIndex);
+	while (!nodeStack.empty())
+	{
+		const Node& node = getNode(nodeStack.back());
+		nodeStack.pop_back();
+		metrics.NodeCount++;
+
+		if (node.isLeaf())
+		{
+			metrics.LeafCount++;
+			continue;
+		}
+
+		metrics.SAHCost += node.Bounds.getArea();
+		nodeStack.push_back(node.LeftIndex);
+		nodeStack.push_back(node.RightIndex);
+	}
+
+	return metrics;
+}
+
+std::vector<CollisionData> AABBTree::query(const Collider& collider, const QueryFilter& filter) const {
 	switch (collider.Type) {
 	case Collider::ColliderType::AABB:
-		return query(collider.AABBCollider, excludeID);
+		return query(collider.AABBCollider, filter);
 	case Collider::ColliderType::OBB:
-		return query(collider.OBBCollider, excludeID);
+		return query(collider.OBBCollider, filter);
+	case Collider::ColliderType::Circle:
+		return query(collider.CircleCollider, filter);
+	case Collider::ColliderType::Polygon:
+		return query(collider.PolygonCollider, filter);
+	case Collider::ColliderType::Capsule:
+		return query(collider.CapsuleCollider, filter);
 	default:
 		ASSERT_FALSE("Unknown collider type");
 	}
 	return {};
 }
 
-std::vector<RayHitData> AABBTree::raycastAll(const Ray2D& ray, ID excludeID) const
+std::vector<RayHitData> AABBTree::raycastAll(const Ray2D& ray, const QueryFilter& filter) const
 {
-	static std::vector<uint32_t> nodeStack;
-	nodeStack.clear();
-	nodeStack.reserve(256);
 	std::vector<RayHitData> results;
-	uint32_t index = m_rootIndex;
+	raycastAll(ray, filter, [&](const ColliderInfo& info, float tmin, float tmax) {
+		results.push_back(RayHitData(GenericCollisionData(info.id, info), tmin, tmax));
+		return true;
+	});
 
-	if (index != NullIndex)
-		nodeStack.push_back(index);
-	while (!nodeStack.empty())
-	{
-		index = nodeStack.back();
-		nodeStack.pop_back();
-		const Node& currNode = m_nodePool.get(index);
+	return results;
+}
+
+void AABBTree::raycastAll(const Ray2D& ray, const QueryFilter& filter, std::vector<RayHit>& results) const
+{
+	raycastAll(ray, filter, [&](const ColliderInfo& info, float tmin, float tmax) {
+		results.push_back(RayHit(CollisionHit(info.id), tmin, tmax));
+		return true;
+	});
+}
+
+void AABBTree::queryPoint(glm::vec2 point, const QueryFilter& filter, std::vector<CollisionHit>& results) const
+{
+	queryPoint(point, filter, [&](const ColliderInfo& info) {
+		results.emplace_back(info.id);
+		return true;
+	});
+}
 
-		float tmin, tmax;
-		if (!ray.intersect(currNode.Bounds, tmin, tmax) || ray.getMaxT() < tmin)
-			continue; // skip non-overlapping branches
+void AABBTree::nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const
+{
+	results.clear();
+	mergeNearest(k, point, maxDistance, filter, results);
+}
 
-		if (currNode.IsLeaf)
+void AABBTree::mergeNearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const
+{
+	if (k == 0 || m_rootIndex == NullIndex) return;
+
+	// With k hits the search only looks for colliders closer than the furthest one
+	auto searchDistance = [&]() {
+		return (results.size() == k) ? results.back().distance : maxDistance;
+	};
+
+	// Leaves are queued with the distance to their collider, internal nodes with the distance to their bounds
+	// which is never larger than the distance to the colliders below. A leaf popped before every node left
+	// is closer than anything in them.
+	PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+	PHYSICS_PROFILE_LOCAL(leavesTested, TreeLeavesTested);
+	TraversalQueue queue;
+	auto pushNode = [&](uint32_t index) {
+		const Node& node = getNode(index);
+		if (!filter.accepts(node.CategoryBits)) return;
+
+		float distance = node.Bounds.distance(point);
+		if (distance > searchDistance()) return;
+
+		if (node.isLeaf())
 		{
-			ASSERT(currNode.Value.has_value(), "Leaf node without value");
-			// If the collider intersects, add it to results (Collider may not be AABB)
-			const ColliderInfo& info = currNode.Value.value();
-			bool intersects = ray.intersect(info, tmin, tmax);
-			if (info.id != excludeID &&
-				intersects &&
-				ray.getMaxT() >= tmin)
-				results.push_back(RayHitData(GenericCollisionData(info.id, info), tmin, tmax));
+			const ColliderInfo& info = m_leaves[node.LeftIndex].Info;
+			if (info.id == filter.ExcludeID) return;
+			PHYSICS_PROFILE_INC(leavesTested);
+			distance = CollisionUtilities::distance(info, point);
+			if (distance > searchDistance()) return;
 		}
-		else
+		queue.push(distance, index);
+	};
+
+	pushNode(m_rootIndex);
+	while (!queue.isEmpty())
+	{
+		TraversalQueue<>::Entry entry = queue.pop();
+		if (results.size() == k && entry.Priority >= results.back().distance) return;
+
+		const Node& node = getNode(entry.Index);
+		PHYSICS_PROFILE_INC(nodesVisited);
+
+		if (node.isLeaf())
 		{
-			// Traverse children
-			if (currNode.RightIndex != NullIndex)
-				nodeStack.push_back(currNode.RightIndex);
-			if (currNode.LeftIndex != NullIndex)
-				nodeStack.push_back(currNode.LeftIndex);
+			// Hits already in results go first on equal distances
+			size_t position = std::upper_bound(results.begin(), results.end(), entry.Priority, [](float distance, const NearestHit& hit) {
+				return distance < hit.distance;
+			}) - results.begin();
+			if (results.size() == k) results.pop_back();
+			results.emplace(results.begin() + position, CollisionHit(m_leaves[node.LeftIndex].Info.id), entry.Priority);
+			continue;
 		}
-	}
 
-	return results;
+		pushNode(node.LeftIndex);
+		pushNode(node.RightIndex);
+	}
 }
 
-std::optional<RayHitData> AABBTree::raycastClosest(const Ray2D& ray, ID excludeID) const
+std::optional<RayHitData> AABBTree::raycastClosest(const Ray2D& ray, const QueryFilter& filter) const
 {
-	if (m_rootIndex == NullIndex) return std::nullopt;
+	if (m_rootIndex == NullIndex || !filter.accepts(getNode(m_rootIndex).CategoryBits)) return std::nullopt;
 
-	std::vector<uint32_t> stack;
-	stack.reserve(256);
-	stack.push_back(m_rootIndex);
+	TraversalStack stack;
+	stack.push(m_rootIndex);
 
 	float bestT = std::numeric_limits<float>::max();
 	std::optional<RayHitData> closestHit;
 
-	while (!stack.empty())
+	PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+	PHYSICS_PROFILE_LOCAL(leavesTested, TreeLeavesTested);
+	while (!stack.isEmpty())
 	{
-		const Node& node = m_nodePool.get(stack.back());
-		stack.pop_back();
+		const Node& node = getNode(stack.pop());
+		PHYSICS_PROFILE_INC(nodesVisited);
 
-		if (node.IsLeaf)
+		if (node.isLeaf())
 		{
-			const auto& info = node.Value.value();
+			const auto& info = m_leaves[node.LeftIndex].Info;
 			ASSERT(info.isValid(), "Leaf node without valid collider");
+			PHYSICS_PROFILE_INC(leavesTested);
 
 			float tmin, tmax;
 			// New tmin is new cloest hist, and not bigger than maxT of the ray
-			if (info.id != excludeID &&
+			if (info.id != filter.ExcludeID &&
 				ray.intersect(info, tmin, tmax) &&
 				tmin <= ray.getMaxT() &&
 				tmin <= bestT)
@@ -310,12 +843,14 @@ std::optional<RayHitData> AABBTree::raycastClosest(const Ray2D& ray, ID excludeI
 			float tminR = std::numeric_limits<float>::max(), tmaxR;
 
 			bool hitL = node.LeftIndex != NullIndex &&
-				ray.intersect(m_nodePool.get(node.LeftIndex).Bounds, tminL, tmaxL) &&
+				filter.accepts(getNode(node.LeftIndex).CategoryBits) &&
+				ray.intersect(getNode(node.LeftIndex).Bounds, tminL, tmaxL) &&
 				tminL <= ray.getMaxT() &&
 				tminL <= bestT;
 
 			bool hitR = node.RightIndex != NullIndex &&
-				ray.intersect(m_nodePool.get(node.RightIndex).Bounds, tminR, tmaxR) &&
+				filter.accepts(getNode(node.RightIndex).CategoryBits) &&
+				ray.intersect(getNode(node.RightIndex).Bounds, tminR, tmaxR) &&
 				tminR <= ray.getMaxT() &&
 				tminR <= bestT;
 
@@ -324,17 +859,17 @@ std::optional<RayHitData> AABBTree::raycastClosest(const Ray2D& ray, ID excludeI
 			{
 				if (tminL < tminR)
 				{
-					stack.push_back(node.RightIndex);
-					stack.push_back(node.LeftIndex);
+					stack.push(node.RightIndex);
+					stack.push(node.LeftIndex);
 				}
 				else
 				{
-					stack.push_back(node.LeftIndex);
-					stack.push_back(node.RightIndex);
+					stack.push(node.LeftIndex);
+					stack.push(node.RightIndex);
 				}
 			}
-			else if (hitL) stack.push_back(node.LeftIndex);
-			else if (hitR) stack.push_back(node.RightIndex);
+			else if (hitL) stack.push(node.LeftIndex);
+			else if (hitR) stack.push(node.RightIndex);
 		}
 	}
 
@@ -353,11 +888,11 @@ std::vector<AABB> AABBTree::getInternalBounds() const
 	{
 		index = nodeStack.back();
 		nodeStack.pop_back();
-		const Node& currNode = m_nodePool.get(index);
+		const Node& currNode = getNode(index);
 
 		results.push_back(currNode.Bounds);
 
-		if (!currNode.IsLeaf)
+		if (!currNode.isLeaf())
 		{
 			// Traverse children
 			if (currNode.RightIndex != NullIndex)
@@ -370,16 +905,51 @@ std::vector<AABB> AABBTree::getInternalBounds() const
 	return results;
 }
 
-std::vector<Collider> AABBTree::getLeafColliders() const
+std::vector<uint32_t> AABBTree::getInternalDepths() const
 {
-	std::vector<Collider> colliders;
-	for (auto& pair : m_leafNodesIndices)
+	// Same traversal order as getInternalBounds()
+	std::vector<std::pair<uint32_t, uint32_t>> nodeStack;
+	std::vector<uint32_t> results;
+
+	if (m_rootIndex != NullIndex)
+		nodeStack.push_back({ m_rootIndex, 0 });
+	while (!nodeStack.empty())
 	{
-		uint32_t index = pair.second;
-		const Node& node = m_nodePool.get(index);
-		colliders.push_back(node.Value.value());
+		auto [index, depth] = nodeStack.back();
+		nodeStack.pop_back();
+		const Node& currNode = getNode(index);
+
+		results.push_back(depth);
+
+		if (!currNode.isLeaf())
+		{
+			if (currNode.RightIndex != NullIndex)
+				nodeStack.push_back({ currNode.RightIndex, depth + 1 });
+			if (currNode.LeftIndex != NullIndex)
+				nodeStack.push_back({ currNode.LeftIndex, depth + 1 });
+		}
 	}
 
+	return results;
+}
+
+std::vector<Collider> AABBTree::getLeafColliders() const
+{
+	std::vector<Collider> colliders;
+	colliders.reserve(m_leaves.size());
+	for (const LeafPayload& leaf : m_leaves)
+		colliders.push_back(leaf.Info);
+
+	return colliders;
+}
+
+std::vector<ColliderInfo> AABBTree::getColliderInfos() const
+{
+	std::vector<ColliderInfo> colliders;
+	colliders.reserve(m_leaves.size());
+	for (const LeafPayload& leaf : m_leaves)
+		colliders.push_back(leaf.Info);
+
 	return colliders;
 }
 
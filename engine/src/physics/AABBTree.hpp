@@ -2,95 +2,485 @@
 #define AABB_TREE_HPP
 
 #include "physics/CollisionData.hpp"
+#include "physics/CollisionFilter.hpp"
 #include "physics/Collider.hpp"
 #include "physics/Ray2D.hpp"
+#include "physics/BoundsBatch.hpp"
+#include "physics/TraversalStack.hpp"
+#include "physics/TraversalQueue.hpp"
+#include "physics/PhysicsProfiler.hpp"
 #include "core/types.hpp"
 #include "utilities/assertions.hpp"
-#include "utilities/NodePool.hpp"
+#include "utilities/ThreadPool.hpp"
 
 namespace TileBite {
 
 struct ColliderInfo : public Collider {
 	ID id;
+	CollisionFilter Filter;
 
 	template<typename ColliderT>
-    ColliderInfo(ID id, const ColliderT& collider) : id(id), Collider(collider) {}
+    ColliderInfo(ID id, const ColliderT& collider, const CollisionFilter& filter = CollisionFilter())
+        : id(id), Collider(collider), Filter(filter) {}
 };
 
 // https://box2d.org/files/ErinCatto_DynamicBVH_GDC2019.pdf
+// Const member functions (queries and raycasts) keep their traversal state per call, so any
+// number of threads can query the tree at the same time as long as nothing modifies it.
+// Nodes keep the categories of the leaves below them, subtrees without a category of the
+// query mask are skipped without testing their bounds.
 class AABBTree {
 public:
     // Templated internal query for every collider type
     // (Assumes ColliderT is supported by AABB and ColliderInfo)
-    template<typename ColliderT>
-    std::vector<CollisionData> query(const ColliderT& collider, ID excludeID) const {
-        static std::vector<uint32_t> nodeStack;
-        nodeStack.clear();
-        nodeStack.reserve(256);
-        std::vector<CollisionData> results;
-        uint32_t index = m_rootIndex;
-
-        if (index != NullIndex)
-            nodeStack.push_back(index);
-
-        while (!nodeStack.empty()) {
-            index = nodeStack.back();
-            nodeStack.pop_back();
-            const Node& currNode = m_nodePool.get(index);
+    // Calls visitor(const ColliderInfo&) for every overlapping collider, stops early if it returns false.
+    template<typename ColliderT, typename Visitor>
+    requires HitVisitor<Visitor, const ColliderInfo&>
+    void query(const ColliderT& collider, const QueryFilter& filter, Visitor&& visitor) const {
+        if constexpr (std::same_as<ColliderT, Collider>) {
+            // Dispatch once so the narrow phase runs against the concrete shape
+            switch (collider.Type) {
+            case Collider::ColliderType::AABB:   query(collider.AABBCollider, filter, visitor); return;
+            case Collider::ColliderType::OBB:    query(collider.OBBCollider, filter, visitor); return;
+            case Collider::ColliderType::Circle: query(collider.CircleCollider, filter, visitor); return;
+            case Collider::ColliderType::Polygon: query(collider.PolygonCollider, filter, visitor); return;
+            case Collider::ColliderType::Capsule: query(collider.CapsuleCollider, filter, visitor); return;
+            default: ASSERT_FALSE("Unknown collider type"); return;
+            }
+        }
+        else {
+            TraversalStack nodeStack;
+            uint32_t index = m_rootIndex;
 
             // Broad phase against bounding box of collider area
             // NOTE: if rotation causes big bounds this might be slower.
-            if (!currNode.Bounds.intersects(collider.getBoundingBox()))
-                continue;
-
-            if (currNode.IsLeaf) {
-                ASSERT(currNode.Value.has_value(), "Leaf node without value");
-                const ColliderInfo& info = currNode.Value.value();
-                if (info.id != excludeID && info.intersects(collider))
-                    results.push_back(CollisionData(GenericCollisionData(info.id, info)));
-            }
-            else {
-                if (currNode.RightIndex != NullIndex)
-                    nodeStack.push_back(currNode.RightIndex);
-                if (currNode.LeftIndex != NullIndex)
-                    nodeStack.push_back(currNode.LeftIndex);
+            const AABB queryBounds = collider.getBoundingBox();
+
+            // Leaves are not tested one by one, they are gathered and tested in batches.
+            BoundsBatch candidateLeaves;
+
+            if (index != NullIndex)
+                nodeStack.push(index);
+
+            PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+            while (!nodeStack.isEmpty()) {
+                index = nodeStack.pop();
+                const Node& currNode = getNode(index);
+                PHYSICS_PROFILE_INC(nodesVisited);
+
+                if (!filter.accepts(currNode.CategoryBits))
+                    continue;
+
+                if (currNode.isLeaf()) {
+                    candidateLeaves.push(currNode.Bounds, currNode.LeftIndex);
+                    if (candidateLeaves.isFull()) {
+                        if (!narrowPhase(collider, queryBounds, filter.ExcludeID, candidateLeaves, visitor)) return;
+                        candidateLeaves.clear();
+                    }
+                    continue;
+                }
+
+                if (!currNode.Bounds.intersects(queryBounds))
+                    continue;
+
+                nodeStack.push(currNode.RightIndex);
+                nodeStack.push(currNode.LeftIndex);
             }
+
+            if (!candidateLeaves.isEmpty())
+                narrowPhase(collider, queryBounds, filter.ExcludeID, candidateLeaves, visitor);
         }
+    }
+
+    // Appends a hit for every overlapping collider to results (no allocations once results has grown)
+    template<typename ColliderT>
+    void query(const ColliderT& collider, const QueryFilter& filter, std::vector<CollisionHit>& results) const {
+        query(collider, filter, [&](const ColliderInfo& info) {
+            results.emplace_back(info.id);
+            return true;
+        });
+    }
 
+    template<typename ColliderT>
+    std::vector<CollisionData> query(const ColliderT& collider, const QueryFilter& filter) const {
+        std::vector<CollisionData> results;
+        query(collider, filter, [&](const ColliderInfo& info) {
+            results.push_back(CollisionData(GenericCollisionData(info.id, info)));
+            return true;
+        });
         return results;
     }
 
-    std::vector<CollisionData> query(const Collider& collider, ID excludeID) const;
+    std::vector<CollisionData> query(const Collider& collider, const QueryFilter& filter) const;
+
+	// Calls visitor(const ColliderInfo&, float tmin, float tmax) for every collider hit by the ray,
+	// in no particular order. Stops early if the visitor returns false.
+	template<typename Visitor>
+	requires HitVisitor<Visitor, const ColliderInfo&, float, float>
+	void raycastAll(const Ray2D& ray, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		TraversalStack nodeStack;
+		if (m_rootIndex != NullIndex)
+			nodeStack.push(m_rootIndex);
+
+		PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+		PHYSICS_PROFILE_LOCAL(leavesTested, TreeLeavesTested);
+		while (!nodeStack.isEmpty())
+		{
+			const Node& currNode = getNode(nodeStack.pop());
+			PHYSICS_PROFILE_INC(nodesVisited);
+			if (!filter.accepts(currNode.CategoryBits))
+				continue;
+
+			float tmin, tmax;
+			if (!ray.intersect(currNode.Bounds, tmin, tmax) || ray.getMaxT() < tmin)
+				continue; // skip non-overlapping branches
+
+			if (currNode.isLeaf())
+			{
+				// If the collider intersects, report it (Collider may not be AABB)
+				const ColliderInfo& info = m_leaves[currNode.LeftIndex].Info;
+				PHYSICS_PROFILE_INC(leavesTested);
+				if (info.id != filter.ExcludeID &&
+					ray.intersect(info, tmin, tmax) &&
+					ray.getMaxT() >= tmin &&
+					!visitor(info, tmin, tmax))
+					return;
+			}
+			else
+			{
+				// Traverse children
+				nodeStack.push(currNode.RightIndex);
+				nodeStack.push(currNode.LeftIndex);
+			}
+		}
+	}
+
+	// Appends a hit for every collider hit by the ray to results
+	void raycastAll(const Ray2D& ray, const QueryFilter& filter, std::vector<RayHit>& results) const;
+
+	// Calls visitor(const ColliderInfo&) for every collider containing point, stops early if it returns false.
+	// Cheaper than a query with a small box for picking, only the nodes around point are visited.
+	template<typename Visitor>
+	requires HitVisitor<Visitor, const ColliderInfo&>
+	void queryPoint(glm::vec2 point, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		TraversalStack nodeStack;
+		if (m_rootIndex != NullIndex)
+			nodeStack.push(m_rootIndex);
+
+		PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+		PHYSICS_PROFILE_LOCAL(leavesTested, TreeLeavesTested);
+		while (!nodeStack.isEmpty())
+		{
+			const Node& currNode = getNode(nodeStack.pop());
+			PHYSICS_PROFILE_INC(nodesVisited);
+			if (!filter.accepts(currNode.CategoryBits) || !currNode.Bounds.contains(point))
+				continue;
+
+			if (currNode.isLeaf())
+			{
+				const ColliderInfo& info = m_leaves[currNode.LeftIndex].Info;
+				PHYSICS_PROFILE_INC(leavesTested);
+				if (info.id != filter.ExcludeID && CollisionUtilities::contains(info, point) && !visitor(info))
+					return;
+				continue;
+			}
+
+			nodeStack.push(currNode.RightIndex);
+			nodeStack.push(currNode.LeftIndex);
+		}
+	}
+
+	// Appends a hit for every collider containing point to results
+	void queryPoint(glm::vec2 point, const QueryFilter& filter, std::vector<CollisionHit>& results) const;
+
+	// Replaces results with the k colliders closest to point no further than maxDistance, closest first.
+	// Best first search: nodes are visited in order of the distance to their bounds, so the search stops
+	// as soon as k colliders are closer than every node left.
+	void nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const;
+	// Same search, but results already holds hits (closest first, at most k) of colliders outside the tree.
+	// The colliders of the tree closer than the k-th hit are merged in, results keeps the k closest.
+	void mergeNearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const;
 
 	void insert(const ColliderInfo& colliderInfo);
 	bool remove(ID id);
 	bool update(const ColliderInfo& colliderInfo);
-	std::vector<RayHitData> raycastAll(const Ray2D& ray, ID excludeID = INVALID_ID) const;
-	std::optional<RayHitData> raycastClosest(const Ray2D& ray, ID excludeID = INVALID_ID) const;
+	std::vector<RayHitData> raycastAll(const Ray2D& ray, const QueryFilter& filter = QueryFilter()) const;
+	std::optional<RayHitData> raycastClosest(const Ray2D& ray, const QueryFilter& filter = QueryFilter()) const;
+
+	// Calls callback(const ColliderInfo&) for every leaf with a category in maskBits whose fat bounds
+	// overlap bounds (broad phase only). Traversal stops early if the callback returns false.
+	template<typename Callback>
+	void queryFatBounds(const AABB& bounds, uint16_t maskBits, Callback&& callback) const
+	{
+		TraversalStack nodeStack;
+		if (m_rootIndex != NullIndex)
+			nodeStack.push(m_rootIndex);
+
+		PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+		while (!nodeStack.isEmpty())
+		{
+			const Node& currNode = getNode(nodeStack.pop());
+			PHYSICS_PROFILE_INC(nodesVisited);
+
+			if ((currNode.CategoryBits & maskBits) == 0 || !currNode.Bounds.intersects(bounds))
+				continue;
+
+			if (currNode.isLeaf())
+			{
+				if (!callback(m_leaves[currNode.LeftIndex].Info)) return;
+				continue;
+			}
+
+			nodeStack.push(currNode.RightIndex);
+			nodeStack.push(currNode.LeftIndex);
+		}
+	}
+
+	// Calls visitor(const ColliderInfo&) for every leaf whose bounds are touched by bounds moving along
+	// displacement (broad phase only), roughly closest first. The visitor returns the fraction of the
+	// displacement still of interest (the closest time of impact found so far, or 1 to visit every leaf),
+	// leaves reached only after it are skipped.
+	template<typename Visitor>
+	requires std::is_invocable_r_v<float, Visitor, const ColliderInfo&>
+	void sweep(const AABB& bounds, glm::vec2 displacement, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		if (m_rootIndex == NullIndex) return;
+
+		TraversalStack nodeStack;
+		nodeStack.push(m_rootIndex);
+		float maxT = 1.0f;
+
+		// Time the swept bounds first touch the node, false if not before maxT
+		auto enterTime = [&](uint32_t index, float& tEnter) {
+			const Node& node = getNode(index);
+			float tExit;
+			return filter.accepts(node.CategoryBits) &&
+				CollisionUtilities::sweepInterval(bounds, displacement, node.Bounds, tEnter, tExit) &&
+				tEnter <= maxT;
+		};
+
+		float tEnter;
+		if (!enterTime(m_rootIndex, tEnter)) return;
+
+		PHYSICS_PROFILE_LOCAL(nodesVisited, TreeNodesVisited);
+		PHYSICS_PROFILE_LOCAL(leavesTested, TreeLeavesTested);
+		while (!nodeStack.isEmpty())
+		{
+			uint32_t index = nodeStack.pop();
+			const Node& currNode = getNode(index);
+			PHYSICS_PROFILE_INC(nodesVisited);
+
+			if (currNode.isLeaf())
+			{
+				// Parent tested this node before maxT may have shrunk
+				const ColliderInfo& info = m_leaves[currNode.LeftIndex].Info;
+				PHYSICS_PROFILE_INC(leavesTested);
+				if (info.id != filter.ExcludeID && enterTime(index, tEnter))
+					maxT = std::min(maxT, static_cast<float>(visitor(info)));
+				continue;
+			}
+
+			float tLeft, tRight;
+			bool hitLeft = enterTime(currNode.LeftIndex, tLeft);
+			bool hitRight = enterTime(currNode.RightIndex, tRight);
+
+			// Push closer child last so it's popped first
+			if (hitLeft && hitRight)
+			{
+				bool leftFirst = tLeft < tRight;
+				nodeStack.push(leftFirst ? currNode.RightIndex : currNode.LeftIndex);
+				nodeStack.push(leftFirst ? currNode.LeftIndex : currNode.RightIndex);
+			}
+			else if (hitLeft) nodeStack.push(currNode.LeftIndex);
+			else if (hitRight) nodeStack.push(currNode.RightIndex);
+		}
+	}
+
+	// nullptr if the collider is not in the tree
+	const ColliderInfo* getCollider(ID id) const;
+	const AABB& getFatBounds(ID id) const;
+
+	// Records the IDs of leaves that were inserted, removed or reinserted (moved out of their fat bounds)
+	// until clearMovedIDs() is called. IDs may repeat. Off by default, enabling it reports every
+	// leaf already in the tree as moved.
+	void setMoveTracking(bool enabled);
+	bool isTrackingMoves() const { return m_trackMoves; }
+	const std::vector<ID>& getMovedIDs() const { return m_movedIDs; }
+	void clearMovedIDs() { m_movedIDs.clear(); }
 
 	std::vector<AABB> getInternalBounds() const;
+	// Depth of each node of getInternalBounds(), the root is 0
+	std::vector<uint32_t> getInternalDepths() const;
 	std::vector<Collider> getLeafColliders() const;
+	std::vector<ColliderInfo> getColliderInfos() const;
+
+	uint32_t size() const { return static_cast<uint32_t>(m_leaves.size()); }
+
+	// Replaces the content of the tree with colliders, built top down like rebuild(). Much faster than
+	// inserting them one by one and gives a better tree, meant for loading many colliders at once.
+	// The top of the tree is split on the calling thread and the subtrees below are built on threadPool when given.
+	void build(std::span<const ColliderInfo> colliders, ThreadPool* threadPool = nullptr);
+
+	// Discards the nodes and builds the tree again top down with a binned SAH.
+	// Nodes are laid out in depth first order, left children are next to their parent.
+	void rebuild(ThreadPool* threadPool = nullptr);
+
+	// Rebuilds the tree automatically when its SAH cost per leaf grows over costRatio times
+	// the cost measured after the last rebuild. The cost is checked every checkInterval
+	// reinsertions (leaves that moved out of their fat bounds). A costRatio of 0 disables it.
+	void setRebuildThreshold(float costRatio, uint32_t checkInterval = 1024);
+
+	// Tree quality metrics
+	struct Metrics {
+		uint32_t Height = 0;
+		uint32_t NodeCount = 0;
+		uint32_t LeafCount = 0;
+		float SAHCost = 0.0f; // Sum of the areas of internal nodes
+	};
+
+	uint32_t getHeight() const;
+	float computeSAHCost() const;
+	Metrics getMetrics() const;
 private:
 	constexpr static uint32_t NullIndex = UINT32_MAX;
 
+	// Internal nodes and leaves share the same packed layout so that two nodes fit in a cache line.
+	// Leaves store the index of their payload (m_leaves) in place of the left child,
+	// traversals only read colliders of the leaves that survive the broad phase.
 	struct Node {
-		uint32_t ParentIndex = NullIndex;
-		uint32_t LeftIndex = NullIndex;
+		AABB Bounds;
+		uint32_t ParentIndex = NullIndex; // Next free node while the node is in the free list
+		uint32_t LeftIndex = NullIndex; // Payload index for leaves
 		uint32_t RightIndex = NullIndex;
+		int16_t Height = 0; // 0 for leaves, -1 for free nodes
+		uint16_t CategoryBits = 0; // Categories of the leaves below (of the collider for leaves)
 
-		AABB Bounds;
-		bool IsLeaf = false;
-		std::optional<ColliderInfo> Value;
+		inline bool isLeaf() const { return Height == 0; }
 	};
+	static_assert(sizeof(Node) == 32, "AABBTree::Node should stay 32 bytes");
 
-	NodePool<Node> m_nodePool;
+	struct LeafPayload {
+		ColliderInfo Info;
+		uint32_t NodeIndex;
+	};
+
+	std::vector<Node> m_nodes;
+	uint32_t m_freeListHead = NullIndex;
 
-	std::unordered_map<ID, uint32_t> m_leafNodesIndices;
+	// Dense, removing a leaf moves the last payload in its place
+	std::vector<LeafPayload> m_leaves;
+	std::unordered_map<ID, uint32_t> m_leafIndices; // Payload index of each collider
 	uint32_t m_rootIndex = NullIndex;
 
-	float computeRefitCostDelta(uint32_t startingIndex, float newParentArea, float bestCost) const;
+	inline Node& getNode(uint32_t index)
+	{
+		ASSERT(index < m_nodes.size() && m_nodes[index].Height >= 0, "AABBTree node index is out of bounds or freed");
+		return m_nodes[index];
+	}
+
+	inline const Node& getNode(uint32_t index) const
+	{
+		ASSERT(index < m_nodes.size() && m_nodes[index].Height >= 0, "AABBTree node index is out of bounds or freed");
+		return m_nodes[index];
+	}
+
+	// Tests a batch of candidate leaves against the query bounds (SIMD), then groups the
+	// survivors per collider type so each group runs a single specialized narrow phase test
+	// instead of a type switch per leaf. Returns false if the visitor stopped the query.
+	template<typename ColliderT, typename Visitor>
+	bool narrowPhase(
+		const ColliderT& collider,
+		const AABB& queryBounds,
+		ID excludeID,
+		const BoundsBatch& candidates,
+		Visitor& visitor) const
+	{
+		uint32_t groups[Collider::TypesCount][BoundsBatch::Capacity];
+		uint32_t groupSizes[Collider::TypesCount] = {};
+
+		uint32_t overlaps = candidates.overlapMask(queryBounds);
+		while (overlaps)
+		{
+			uint32_t lane = std::countr_zero(overlaps);
+			overlaps &= overlaps - 1;
+
+			const ColliderInfo& info = m_leaves[candidates.Indices[lane]].Info;
+			if (info.id == excludeID) continue;
+
+			uint32_t type = static_cast<uint32_t>(info.Type);
+			groups[type][groupSizes[type]++] = candidates.Indices[lane];
+		}
+
+		using Type = Collider::ColliderType;
+		return
+			narrowPhaseGroup(collider, &Collider::AABBCollider, groups[uint32_t(Type::AABB)], groupSizes[uint32_t(Type::AABB)], visitor) &&
+			narrowPhaseGroup(collider, &Collider::OBBCollider, groups[uint32_t(Type::OBB)], groupSizes[uint32_t(Type::OBB)], visitor) &&
+			narrowPhaseGroup(collider, &Collider::CircleCollider, groups[uint32_t(Type::Circle)], groupSizes[uint32_t(Type::Circle)], visitor) &&
+			narrowPhaseGroup(collider, &Collider::PolygonCollider, groups[uint32_t(Type::Polygon)], groupSizes[uint32_t(Type::Polygon)], visitor) &&
+			narrowPhaseGroup(collider, &Collider::CapsuleCollider, groups[uint32_t(Type::Capsule)], groupSizes[uint32_t(Type::Capsule)], visitor);
+	}
+
+	template<typename ColliderT, typename ShapeT, typename Visitor>
+	bool narrowPhaseGroup(
+		const ColliderT& collider,
+		ShapeT Collider::* shape,
+		const uint32_t* group,
+		uint32_t groupSize,
+		Visitor& visitor) const
+	{
+		if (groupSize == 0) return true;
+
+		PHYSICS_PROFILE_ADD(TreeLeavesTested, groupSize);
+		for (uint32_t i = 0; i < groupSize; i++)
+		{
+			const ColliderInfo& info = m_leaves[group[i]].Info;
+			if (collider.intersects(info.*shape) && !visitor(info))
+				return false;
+		}
+		return true;
+	}
+
+	// Reused by insertions
+	struct SiblingCandidate {
+		uint32_t Index;
+		float InheritedCost;
+	};
+	std::vector<SiblingCandidate> m_siblingQueue;
+
+	bool m_trackMoves = false;
+	std::vector<ID> m_movedIDs;
+
+	// Automatic rebuild state
+	float m_rebuildCostRatio = 0.0f;
+	uint32_t m_rebuildCheckInterval = 1024;
+	uint32_t m_reinsertionsSinceCheck = 0;
+	float m_referenceCostPerLeaf = 0.0f;
+
+	struct BuildItem {
+		AABB Bounds;
+		uint32_t PayloadIndex;
+	};
+
+	// Trees with fewer leaves are built on a single thread
+	constexpr static uint32_t ParallelBuildMinLeaves = 4096;
+	// Subtrees built in parallel per thread, a few per thread balance uneven splits
+	constexpr static uint32_t ParallelBuildTasksPerThread = 4;
 
+	uint32_t allocateNode();
+	void freeNode(uint32_t index);
+	void removePayload(uint32_t payloadIndex);
 	void refitParentNodes(uint32_t startingIndex);
+	void refitNode(uint32_t index);
+	void refitCategories(uint32_t startingIndex);
+	void rotate(uint32_t index);
+	void swapWithNephew(uint32_t auntIndex, uint32_t nephewIndex);
+	void checkRebuildThreshold();
+	void buildNodes(std::vector<BuildItem>& items, ThreadPool* threadPool);
+	void buildSubtree(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t nodeIndex, uint32_t parentIndex);
+	// Partitions items[begin, end) in two with a binned SAH, returns the first item of the right part
+	uint32_t splitBuildItems(std::vector<BuildItem>& items, uint32_t begin, uint32_t end);
 	uint32_t createParentNode(uint32_t bestSiblingIndex, uint32_t newNodeIndex);
 	uint32_t findBestSibbling(uint32_t newLeafIndex);
 	uint32_t createLeafNode(const ColliderInfo& colliderInfo);
@@ -0,0 +1,18 @@
+#ifndef BODY_TYPE_HPP
+#define BODY_TYPE_HPP
+
+#include <cstdint>
+
+namespace TileBite {
+
+// How a collider moves. Static colliders never move (level geometry, props) and are kept in their own tree,
+// kinematic ones are moved by game code and dynamic ones by the physics step.
+enum class BodyType : uint8_t {
+	Static,
+	Kinematic,
+	Dynamic
+};
+
+} // TileBite
+
+#endif // !BODY_TYPE_HPP
@@ -0,0 +1,58 @@
+#include "physics/BoundsBatch.hpp"
+
+#include "utilities/SIMD.hpp"
+
+namespace TileBite {
+
+uint32_t BoundsBatch::overlapMask(const AABB& bounds) const
+{
+	uint32_t mask = 0;
+
+#if defined(TILEBITE_SIMD_AVX)
+	const __m256 queryMinX = _mm256_set1_ps(bounds.Min.x);
+	const __m256 queryMinY = _mm256_set1_ps(bounds.Min.y);
+	const __m256 queryMaxX = _mm256_set1_ps(bounds.Max.x);
+	const __m256 queryMaxY = _mm256_set1_ps(bounds.Max.y);
+
+	for (uint32_t i = 0; i < Count; i += 8)
+	{
+		__m256 overlapX = _mm256_and_ps(
+			_mm256_cmp_ps(_mm256_load_ps(MinX + i), queryMaxX, _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_load_ps(MaxX + i), queryMinX, _CMP_GE_OQ));
+		__m256 overlapY = _mm256_and_ps(
+			_mm256_cmp_ps(_mm256_load_ps(MinY + i), queryMaxY, _CMP_LE_OQ),
+			_mm256_cmp_ps(_mm256_load_ps(MaxY + i), queryMinY, _CMP_GE_OQ));
+		mask |= uint32_t(_mm256_movemask_ps(_mm256_and_ps(overlapX, overlapY))) << i;
+	}
+#elif defined(TILEBITE_SIMD_SSE)
+	const __m128 queryMinX = _mm_set1_ps(bounds.Min.x);
+	const __m128 queryMinY = _mm_set1_ps(bounds.Min.y);
+	const __m128 queryMaxX = _mm_set1_ps(bounds.Max.x);
+	const __m128 queryMaxY = _mm_set1_ps(bounds.Max.y);
+
+	for (uint32_t i = 0; i < Count; i += 4)
+	{
+		__m128 overlapX = _mm_and_ps(
+			_mm_cmple_ps(_mm_load_ps(MinX + i), queryMaxX),
+			_mm_cmpge_ps(_mm_load_ps(MaxX + i), queryMinX));
+		__m128 overlapY = _mm_and_ps(
+			_mm_cmple_ps(_mm_load_ps(MinY + i), queryMaxY),
+			_mm_cmpge_ps(_mm_load_ps(MaxY + i), queryMinY));
+		mask |= uint32_t(_mm_movemask_ps(_mm_and_ps(overlapX, overlapY))) << i;
+	}
+#else
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		bool overlaps =
+			MinX[i] <= bounds.Max.x && MaxX[i] >= bounds.Min.x &&
+			MinY[i] <= bounds.Max.y && MaxY[i] >= bounds.Min.y;
+		mask |= uint32_t(overlaps) << i;
+	}
+#endif
+
+	// Lanes past Count hold stale data
+	uint32_t validLanes = (Count >= 32) ? ~0u : ((1u << Count) - 1);
+	return mask & validLanes;
+}
+
+} // TileBite
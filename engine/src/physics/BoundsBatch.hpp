@@ -0,0 +1,44 @@
+#ifndef BOUNDS_BATCH_HPP
+#define BOUNDS_BATCH_HPP
+
+#include "core/pch.hpp"
+#include "physics/AABB.hpp"
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+// Small fixed size block of bounding boxes stored in SoA fashion.
+// Boxes are gathered during traversals and then tested against a single
+// query box 4 (SSE) or 8 (AVX) at a time.
+struct BoundsBatch {
+	static constexpr uint32_t Capacity = 16; // Multiple of the widest SIMD lane count
+
+	alignas(32) float MinX[Capacity] = {};
+	alignas(32) float MinY[Capacity] = {};
+	alignas(32) float MaxX[Capacity] = {};
+	alignas(32) float MaxY[Capacity] = {};
+	uint32_t Indices[Capacity] = {}; // Caller defined payload (eg: node index)
+	uint32_t Count = 0;
+
+	inline void push(const AABB& bounds, uint32_t index)
+	{
+		ASSERT(Count < Capacity, "BoundsBatch is full");
+		MinX[Count] = bounds.Min.x;
+		MinY[Count] = bounds.Min.y;
+		MaxX[Count] = bounds.Max.x;
+		MaxY[Count] = bounds.Max.y;
+		Indices[Count] = index;
+		Count++;
+	}
+
+	inline bool isFull() const { return Count == Capacity; }
+	inline bool isEmpty() const { return Count == 0; }
+	inline void clear() { Count = 0; }
+
+	// Bit i is set if box i overlaps bounds (same semantics as AABB::intersects)
+	uint32_t overlapMask(const AABB& bounds) const;
+};
+
+} // TileBite
+
+#endif // !BOUNDS_BATCH_HPP
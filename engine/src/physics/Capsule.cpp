@@ -0,0 +1,65 @@
+#include "physics/Capsule.hpp"
+
+#include "physics/AABB.hpp"
+#include "physics/Collider.hpp"
+#include "physics/GJK.hpp"
+#include "utilities/DeterministicMath.hpp"
+
+namespace TileBite {
+
+Capsule Capsule::toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) const
+{
+	float c = simCos(radians);
+	float s = simSin(radians);
+
+	auto toWorld = [&](glm::vec2 point) {
+		glm::vec2 scaled = point * size;
+		return glm::vec2(
+			scaled.x * c - scaled.y * s,
+			scaled.x * s + scaled.y * c
+		) + position;
+	};
+
+	// uniform scaling of the radius by using max size component, same as circles
+	return Capsule(toWorld(PointA), toWorld(PointB), Radius * std::max(size.x, size.y));
+}
+
+AABB Capsule::getBoundingBox() const
+{
+	return AABB(
+		glm::min(PointA, PointB) - glm::vec2(Radius),
+		glm::max(PointA, PointB) + glm::vec2(Radius)
+	);
+}
+
+bool Capsule::intersects(const AABB& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Capsule::intersects(const Collider& other) const
+{
+	return other.intersects(*this);
+}
+
+bool Capsule::intersects(const OBB& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Capsule::intersects(const Circle& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Capsule::intersects(const Polygon& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Capsule::intersects(const Capsule& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+} // TileBite
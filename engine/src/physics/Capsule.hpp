@@ -0,0 +1,49 @@
+#ifndef CAPSULE_HPP
+#define CAPSULE_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace TileBite {
+
+struct AABB; // Forward declaration to avoid circular dependency
+struct Collider;
+struct OBB;
+struct Circle;
+struct Polygon;
+
+// Segment from PointA to PointB grown by Radius (a stadium).
+// Tested against other shapes with GJK (see physics/GJK.hpp).
+struct Capsule {
+	glm::vec2 PointA;
+	glm::vec2 PointB;
+	float Radius;
+
+	Capsule() : PointA(0.0f, -0.25f), PointB(0.0f, 0.25f), Radius(0.25f) {}
+	Capsule(const glm::vec2& pointA, const glm::vec2& pointB, float radius)
+		: PointA(pointA), PointB(pointB), Radius(radius)
+	{}
+
+	Capsule toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) const;
+
+	inline bool isValid() const noexcept {
+		return Radius >= 0.0f;
+	}
+
+	inline float getArea() const {
+		return glm::pi<float>() * Radius * Radius + 2.0f * Radius * glm::length(PointB - PointA);
+	}
+
+	AABB getBoundingBox() const;
+
+	bool intersects(const AABB& other) const;
+	bool intersects(const Collider& other) const;
+	bool intersects(const OBB& other) const;
+	bool intersects(const Circle& other) const;
+	bool intersects(const Polygon& other) const;
+	bool intersects(const Capsule& other) const;
+};
+
+} // TileBite
+
+#endif // !CAPSULE_HPP
@@ -2,7 +2,9 @@
 
 #include "physics/Collider.hpp"
 #include "physics/CollisionUtilities.hpp"
+#include "physics/GJK.hpp"
 #include "utilities/Logger.hpp"
+#include "utilities/DeterministicMath.hpp"
 
 namespace TileBite{
 
@@ -11,8 +13,8 @@ Circle Circle::toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) c
     glm::vec2 scaledCenter = Center * size;
 	
     // TODO: utility function for rotation
-    float cosTheta = std::cos(radians);
-    float sinTheta = std::sin(radians);
+    float cosTheta = simCos(radians);
+    float sinTheta = simSin(radians);
     glm::vec2 rotatedCenter = {
         scaledCenter.x * cosTheta - scaledCenter.y * sinTheta,
         scaledCenter.x * sinTheta + scaledCenter.y * cosTheta
@@ -57,4 +59,14 @@ bool Circle::intersects(const Circle& other) const
     return glm::dot(delta, delta) <= rSum * rSum;
 }
 
+bool Circle::intersects(const Polygon& other) const
+{
+    return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Circle::intersects(const Capsule& other) const
+{
+    return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
 } // TileBite
\ No newline at end of file
@@ -11,6 +11,8 @@ namespace TileBite {
 struct AABB; // Forward declaration to avoid circular dependency
 struct Collider;
 struct OBB;
+struct Polygon;
+struct Capsule;
 
 struct Circle {
     glm::vec2 Center;
@@ -37,6 +39,8 @@ struct Circle {
     bool intersects(const Collider& other) const;
     bool intersects(const OBB& other) const;
     bool intersects(const Circle& other) const;
+    bool intersects(const Polygon& other) const;
+    bool intersects(const Capsule& other) const;
 
 };
 
@@ -7,6 +7,8 @@
 #include "physics/AABB.hpp"
 #include "physics/OBB.hpp"
 #include "physics/Circle.hpp"
+#include "physics/Polygon.hpp"
+#include "physics/Capsule.hpp"
 #include "physics/CollisionUtilities.hpp"
 #include "utilities/assertions.hpp"
 
@@ -16,24 +18,34 @@ struct Collider {
 	enum class ColliderType {
 		AABB,
 		OBB,
-        Circle
+        Circle,
+        Polygon,
+        Capsule
 	} Type;
 
+    static constexpr uint32_t TypesCount = 5;
+
 	union {
 		AABB AABBCollider;
 		OBB OBBCollider;
         Circle CircleCollider;
+        Polygon PolygonCollider;
+        Capsule CapsuleCollider;
 	};
 
     Collider(const AABB& aabb) :     Type(ColliderType::AABB), AABBCollider(aabb) {}
     Collider(const OBB& obb) :       Type(ColliderType::OBB), OBBCollider(obb) {}
     Collider(const Circle& circle) : Type(ColliderType::Circle), CircleCollider(circle) {}
+    Collider(const Polygon& polygon) : Type(ColliderType::Polygon), PolygonCollider(polygon) {}
+    Collider(const Capsule& capsule) : Type(ColliderType::Capsule), CapsuleCollider(capsule) {}
 
 	AABB getAABBBounds() const {
 		switch (Type) {
 		case ColliderType::AABB:   return AABBCollider.getBoundingBox();
 		case ColliderType::OBB:    return OBBCollider.getBoundingBox();
         case ColliderType::Circle: return CircleCollider.getBoundingBox();
+        case ColliderType::Polygon: return PolygonCollider.getBoundingBox();
+        case ColliderType::Capsule: return CapsuleCollider.getBoundingBox();
         default: ASSERT_FALSE("Unknown type");
 		}
         return AABB(); // Return an empty AABB if type is unknown
@@ -44,6 +56,8 @@ struct Collider {
         case ColliderType::AABB:   return AABBCollider.getArea();
         case ColliderType::OBB:    return OBBCollider.getArea();
         case ColliderType::Circle: return CircleCollider.getArea();
+        case ColliderType::Polygon: return PolygonCollider.getArea();
+        case ColliderType::Capsule: return CapsuleCollider.getArea();
         default: ASSERT_FALSE("Unknown collider type");
         }
         return false;
@@ -54,6 +68,8 @@ struct Collider {
         case ColliderType::AABB:    return AABBCollider.isValid();
         case ColliderType::OBB:     return OBBCollider.isValid();
         case ColliderType::Circle:  return CircleCollider.isValid();
+        case ColliderType::Polygon: return PolygonCollider.isValid();
+        case ColliderType::Capsule: return CapsuleCollider.isValid();
         default: ASSERT_FALSE("Unknown collider type");
         }
         return false;
@@ -65,6 +81,8 @@ struct Collider {
         case ColliderType::AABB:    return AABBCollider.intersects(other);
         case ColliderType::OBB:     return OBBCollider.intersects(other);
         case ColliderType::Circle:  return CircleCollider.intersects(other);
+        case ColliderType::Polygon: return PolygonCollider.intersects(other);
+        case ColliderType::Capsule: return CapsuleCollider.intersects(other);
         default: ASSERT_FALSE("Unknown collider type");
         }
         return false;
@@ -75,6 +93,8 @@ struct Collider {
         case ColliderType::AABB:    return intersects(other.AABBCollider);
         case ColliderType::OBB:     return intersects(other.OBBCollider);
         case ColliderType::Circle:  return intersects(other.CircleCollider);
+        case ColliderType::Polygon: return intersects(other.PolygonCollider);
+        case ColliderType::Capsule: return intersects(other.CapsuleCollider);
         default: ASSERT_FALSE("Unknown collider type");
         }
         return false;
@@ -1,6 +1,7 @@
 #ifndef COLLISION_DATA_HPP
 #define COLLISION_DATA_HPP
 
+#include "core/pch.hpp"
 #include "physics/Collider.hpp"
 #include "core/types.hpp"
 
@@ -16,12 +17,17 @@ struct GenericCollisionData {
     {}
 };
 
+// Tile (or block of XTileSpan x YTileSpan tiles for merged tilemap colliders) of a tilemap,
+// the indices are the ones of its bottom left tile.
 struct TilemapCollisionData : public GenericCollisionData {
 	uint32_t XTilemapIndex;
 	uint32_t YTilemapIndex;
+	uint16_t XTileSpan;
+	uint16_t YTileSpan;
 
-    TilemapCollisionData(ID id, const AABB& collider, uint32_t xTilemapIndex, uint32_t yTilemapIndex)
-        : GenericCollisionData(id, Collider(collider)), XTilemapIndex(xTilemapIndex), YTilemapIndex(yTilemapIndex) 
+    TilemapCollisionData(ID id, const AABB& collider, uint32_t xTilemapIndex, uint32_t yTilemapIndex, uint16_t xTileSpan = 1, uint16_t yTileSpan = 1)
+        : GenericCollisionData(id, Collider(collider)), XTilemapIndex(xTilemapIndex), YTilemapIndex(yTilemapIndex),
+        XTileSpan(xTileSpan), YTileSpan(yTileSpan)
     {}
 };
 
@@ -63,6 +69,65 @@ struct RayHitData : public CollisionData {
 	RayHitData() : CollisionData(), tmin(0.0f), tmax(0.0f) {} // dummy default
 };
 
+// Lightweight hit record for allocation free queries.
+// Tile indices are only set for tilemap hits, spans are larger than 1 for merged tilemap colliders.
+struct CollisionHit {
+	static constexpr uint32_t NoTile = UINT32_MAX;
+
+	ID id;
+	uint32_t XTilemapIndex;
+	uint32_t YTilemapIndex;
+	uint16_t XTileSpan;
+	uint16_t YTileSpan;
+
+	CollisionHit(ID id, uint32_t xTilemapIndex = NoTile, uint32_t yTilemapIndex = NoTile, uint16_t xTileSpan = 1, uint16_t yTileSpan = 1)
+		: id(id), XTilemapIndex(xTilemapIndex), YTilemapIndex(yTilemapIndex), XTileSpan(xTileSpan), YTileSpan(yTileSpan)
+	{}
+
+	bool isTile() const { return XTilemapIndex != NoTile; }
+};
+
+struct RayHit : public CollisionHit {
+	float tmin;
+	float tmax;
+
+	RayHit(const CollisionHit& hit, float tmin_, float tmax_)
+		: CollisionHit(hit), tmin(tmin_), tmax(tmax_)
+	{}
+};
+
+// First contact of a shape cast, toi is the fraction of the displacement travelled before contact
+// and normal the surface normal of the hit collider or tile at the contact (facing the cast shape).
+struct ShapeCastHit : public CollisionHit {
+	float toi;
+	glm::vec2 normal;
+
+	ShapeCastHit(const CollisionHit& hit, float toi_, glm::vec2 normal_)
+		: CollisionHit(hit), toi(toi_), normal(normal_)
+	{}
+};
+
+// Collider found by a nearest neighbour search, distance from the query point to the collider (0 inside it)
+struct NearestHit : public CollisionHit {
+	float distance;
+
+	NearestHit(const CollisionHit& hit, float distance_)
+		: CollisionHit(hit), distance(distance_)
+	{}
+};
+
+// Callback of visitor based queries, returning false stops the query early.
+template<typename Visitor, typename... Args>
+concept HitVisitor = std::is_invocable_r_v<bool, Visitor, Args...>;
+
+// Pair of overlapping colliders, idA < idB
+struct CollisionPair {
+	ID idA;
+	ID idB;
+
+	bool operator==(const CollisionPair& other) const = default;
+};
+
 } // TileBite
 
 #endif // !COLLISION_DATA_HPP
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef COLLISION_FILTER_HPP
+#define COLLISION_FILTER_HPP
+
+#include <cstdint>
+#include "core/Types.hpp"
+
+namespace TileBite {
+
+// Collision layers of a collider. CategoryBits are the layers it belongs to, MaskBits the layers it collides with.
+// Two colliders collide only if each one's mask contains a category of the other.
+struct CollisionFilter {
+	static constexpr uint16_t AllCategories = 0xFFFF;
+
+	uint16_t CategoryBits = 0x0001;
+	uint16_t MaskBits = AllCategories;
+
+	inline bool accepts(uint16_t categoryBits) const { return (MaskBits & categoryBits) != 0; }
+	inline bool collidesWith(const CollisionFilter& other) const { return accepts(other.CategoryBits) && other.accepts(CategoryBits); }
+
+	inline bool operator==(const CollisionFilter& other) const = default;
+};
+
+// Colliders reported by a query: every collider but ExcludeID with a category in MaskBits.
+// Converts from an ID so queries can still be given only the ID to exclude.
+struct QueryFilter {
+	ID ExcludeID;
+	uint16_t MaskBits;
+
+	QueryFilter(ID excludeID = INVALID_ID, uint16_t maskBits = CollisionFilter::AllCategories)
+		: ExcludeID(excludeID), MaskBits(maskBits)
+	{}
+
+	inline bool accepts(uint16_t categoryBits) const { return (MaskBits & categoryBits) != 0; }
+	inline bool accepts(ID id, uint16_t categoryBits) const { return id != ExcludeID && accepts(categoryBits); }
+};
+
+} // TileBite
+
+#endif // !COLLISION_FILTER_HPP
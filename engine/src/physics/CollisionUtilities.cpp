@@ -1,5 +1,7 @@
 #include "physics/CollisionUtilities.hpp"
+#include "physics/GJK.hpp"
 #include "utilities/Logger.hpp"
+#include "utilities/DeterministicMath.hpp"
 
 namespace TileBite {
 namespace CollisionUtilities {
@@ -26,8 +28,8 @@ bool intersects(const Circle& a, const OBB& b)
 	glm::vec2 local = a.Center - b.Center;
 
 	// rotate by -Rotation (inverse of OBB rotation)
-	float c = cos(-b.Rotation);
-	float s = sin(-b.Rotation);
+	float c = simCos(-b.Rotation);
+	float s = simSin(-b.Rotation);
 	glm::vec2 localCircle(
 		local.x * c - local.y * s,
 		local.x * s + local.y * c
@@ -136,5 +138,736 @@ bool SATTest(const std::array<glm::vec2, 4>& points1, const std::array<glm::vec2
 	return true;
 }
 
+// ==========================================
+// Swept tests
+
+// Same as sweepInterval, enterAxis is the axis (0 for x, 1 for y) entered last or -1 if none moves
+static bool sweepInterval(const AABB& moving, glm::vec2 displacement, const AABB& target, float& tEnter, float& tExit, int& enterAxis)
+{
+	tEnter = -std::numeric_limits<float>::infinity();
+	tExit = std::numeric_limits<float>::infinity();
+	enterAxis = -1;
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (displacement[axis] == 0.0f)
+		{
+			// Not moving on this axis, the projections have to overlap all along
+			if (moving.Max[axis] < target.Min[axis] || moving.Min[axis] > target.Max[axis]) return false;
+			continue;
+		}
+
+		float invDisplacement = 1.0f / displacement[axis];
+		float t0 = (target.Min[axis] - moving.Max[axis]) * invDisplacement;
+		float t1 = (target.Max[axis] - moving.Min[axis]) * invDisplacement;
+		if (t0 > t1) std::swap(t0, t1);
+
+		if (t0 > tEnter)
+		{
+			tEnter = t0;
+			enterAxis = axis;
+		}
+		tExit = std::min(tExit, t1);
+	}
+
+	return tEnter <= tExit && tEnter <= 1.0f && tExit >= 0.0f;
+}
+
+bool sweepInterval(const AABB& moving, glm::vec2 displacement, const AABB& target, float& tEnter, float& tExit)
+{
+	int enterAxis;
+	return sweepInterval(moving, displacement, target, tEnter, tExit, enterAxis);
+}
+
+// Unit normal of the axis, facing against the displacement
+static glm::vec2 axisNormal(int axis, glm::vec2 displacement)
+{
+	glm::vec2 normal(0.0f);
+	normal[axis] = (displacement[axis] > 0.0f) ? -1.0f : 1.0f;
+	return normal;
+}
+
+// Swept SAT between two 4 point convex shapes
+static bool sweepPolygons(const std::array<glm::vec2, 4>& moving, glm::vec2 displacement, const std::array<glm::vec2, 4>& target, float& toi, glm::vec2& normal)
+{
+	std::array<glm::vec2, 4> axes = {
+		moving[1] - moving[0], moving[3] - moving[0],
+		target[1] - target[0], target[3] - target[0]
+	};
+	glm::vec2 centerOffset = 0.25f * (moving[0] + moving[1] + moving[2] + moving[3] - target[0] - target[1] - target[2] - target[3]);
+
+	float tEnter = -std::numeric_limits<float>::infinity();
+	float tExit = std::numeric_limits<float>::infinity();
+	glm::vec2 enterNormal(0.0f);
+	float minPenetration = std::numeric_limits<float>::infinity();
+	glm::vec2 penetrationNormal(0.0f, 1.0f);
+
+	for (glm::vec2 axis : axes)
+	{
+		float length = glm::length(axis);
+		if (length == 0.0f) continue; // Degenerate shape
+		axis /= length;
+
+		auto [minMoving, maxMoving] = axisProjectionMinMax(axis, moving);
+		auto [minTarget, maxTarget] = axisProjectionMinMax(axis, target);
+
+		float penetration = std::min(maxMoving - minTarget, maxTarget - minMoving);
+		if (penetration < minPenetration)
+		{
+			minPenetration = penetration;
+			penetrationNormal = (glm::dot(centerOffset, axis) < 0.0f) ? -axis : axis;
+		}
+
+		float velocity = glm::dot(displacement, axis);
+		if (velocity == 0.0f)
+		{
+			if (maxMoving < minTarget || maxTarget < minMoving) return false;
+			continue;
+		}
+
+		float t0 = (minTarget - maxMoving) / velocity;
+		float t1 = (maxTarget - minMoving) / velocity;
+		if (t0 > t1) std::swap(t0, t1);
+
+		if (t0 > tEnter)
+		{
+			tEnter = t0;
+			enterNormal = (velocity > 0.0f) ? -axis : axis;
+		}
+		tExit = std::min(tExit, t1);
+
+		if (tEnter > tExit || tEnter > 1.0f || tExit < 0.0f) return false;
+	}
+
+	if (tEnter <= 0.0f)
+	{
+		toi = 0.0f;
+		normal = penetrationNormal;
+	}
+	else
+	{
+		toi = tEnter;
+		normal = enterNormal;
+	}
+	return true;
+}
+
+bool sweep(const AABB& moving, glm::vec2 displacement, const AABB& target, float& toi, glm::vec2& normal)
+{
+	float tEnter, tExit;
+	int enterAxis;
+	if (!sweepInterval(moving, displacement, target, tEnter, tExit, enterAxis))
+		return false;
+
+	if (tEnter > 0.0f)
+	{
+		toi = tEnter;
+		normal = axisNormal(enterAxis, displacement);
+		return true;
+	}
+
+	// Overlapping from the start, push out along the axis of least penetration
+	glm::vec2 penetration = glm::min(moving.Max - target.Min, target.Max - moving.Min);
+	glm::vec2 centerOffset = (moving.Min + moving.Max) - (target.Min + target.Max);
+	int axis = (penetration.x < penetration.y) ? 0 : 1;
+	normal = glm::vec2(0.0f);
+	normal[axis] = (centerOffset[axis] < 0.0f) ? -1.0f : 1.0f;
+	toi = 0.0f;
+	return true;
+}
+
+bool sweep(const AABB& moving, glm::vec2 displacement, const OBB& target, float& toi, glm::vec2& normal)
+{
+	return sweepPolygons(moving.getCorners(), displacement, target.getCorners(), toi, normal);
+}
+
+bool sweep(const OBB& moving, glm::vec2 displacement, const AABB& target, float& toi, glm::vec2& normal)
+{
+	return sweepPolygons(moving.getCorners(), displacement, target.getCorners(), toi, normal);
+}
+
+bool sweep(const OBB& moving, glm::vec2 displacement, const OBB& target, float& toi, glm::vec2& normal)
+{
+	return sweepPolygons(moving.getCorners(), displacement, target.getCorners(), toi, normal);
+}
+
+bool sweep(const Circle& moving, glm::vec2 displacement, const Circle& target, float& toi, glm::vec2& normal)
+{
+	glm::vec2 offset = moving.Center - target.Center;
+	float radius = moving.Radius + target.Radius;
+	float c = glm::dot(offset, offset) - radius * radius;
+
+	if (c <= 0.0f)
+	{
+		// Overlapping from the start
+		float distance = glm::length(offset);
+		if (distance > 0.0f) normal = offset / distance;
+		else if (displacement != glm::vec2(0.0f)) normal = -glm::normalize(displacement);
+		else normal = glm::vec2(0.0f, 1.0f);
+		toi = 0.0f;
+		return true;
+	}
+
+	// Solve |offset + t * displacement| = radius for the first t
+	float a = glm::dot(displacement, displacement);
+	float b = glm::dot(offset, displacement);
+	if (a == 0.0f || b >= 0.0f) return false; // Not moving or moving apart
+
+	float discriminant = b * b - a * c;
+	if (discriminant < 0.0f) return false;
+
+	float t = (-b - std::sqrt(discriminant)) / a;
+	if (t > 1.0f) return false;
+
+	toi = std::max(t, 0.0f);
+	normal = glm::normalize(offset + displacement * toi);
+	return true;
+}
+
+bool sweep(const Circle& moving, glm::vec2 displacement, const AABB& target, float& toi, glm::vec2& normal)
+{
+	glm::vec2 closest = glm::clamp(moving.Center, target.Min, target.Max);
+	glm::vec2 offset = moving.Center - closest;
+	float distance2 = glm::dot(offset, offset);
+
+	if (distance2 <= moving.Radius * moving.Radius)
+	{
+		// Overlapping from the start, a center inside the box is pushed out of the closest face
+		toi = 0.0f;
+		if (distance2 > 0.0f)
+		{
+			normal = offset / std::sqrt(distance2);
+			return true;
+		}
+
+		float left = moving.Center.x - target.Min.x, right = target.Max.x - moving.Center.x;
+		float bottom = moving.Center.y - target.Min.y, top = target.Max.y - moving.Center.y;
+		float closestFace = std::min({ left, right, bottom, top });
+		if (closestFace == left) normal = glm::vec2(-1.0f, 0.0f);
+		else if (closestFace == right) normal = glm::vec2(1.0f, 0.0f);
+		else if (closestFace == bottom) normal = glm::vec2(0.0f, -1.0f);
+		else normal = glm::vec2(0.0f, 1.0f);
+		return true;
+	}
+
+	// Path of the center against the box grown by the radius (Real-Time Collision Detection 5.5.7)
+	AABB expanded(target.Min - moving.Radius, target.Max + moving.Radius);
+	float tEnter, tExit;
+	int enterAxis;
+	if (!sweepInterval(AABB(moving.Center, moving.Center), displacement, expanded, tEnter, tExit, enterAxis))
+		return false;
+
+	float t = std::max(tEnter, 0.0f);
+	glm::vec2 point = moving.Center + displacement * t;
+	bool outsideX = point.x < target.Min.x || point.x > target.Max.x;
+	bool outsideY = point.y < target.Min.y || point.y > target.Max.y;
+
+	// In a corner region of the grown box the contact is with the rounded corner
+	if (outsideX && outsideY)
+	{
+		glm::vec2 corner(
+			(point.x < target.Min.x) ? target.Min.x : target.Max.x,
+			(point.y < target.Min.y) ? target.Min.y : target.Max.y
+		);
+		return sweep(moving, displacement, Circle(corner, 0.0f), toi, normal);
+	}
+
+	if (enterAxis < 0) return false;
+	toi = t;
+	normal = axisNormal(enterAxis, displacement);
+	return true;
+}
+
+// Rotates v by the angle given as cosine and sine
+static glm::vec2 rotate(glm::vec2 v, float c, float s)
+{
+	return glm::vec2(v.x * c - v.y * s, v.x * s + v.y * c);
+}
+
+bool sweep(const Circle& moving, glm::vec2 displacement, const OBB& target, float& toi, glm::vec2& normal)
+{
+	// In the OBB local space the OBB is an AABB centered at the origin
+	float c = simCos(-target.Rotation);
+	float s = simSin(-target.Rotation);
+	Circle localCircle(rotate(moving.Center - target.Center, c, s), moving.Radius);
+	glm::vec2 halfExtents = 0.5f * target.Size;
+
+	if (!sweep(localCircle, rotate(displacement, c, s), AABB(-halfExtents, halfExtents), toi, normal))
+		return false;
+
+	normal = rotate(normal, c, -s);
+	return true;
+}
+
+// A box moving against a static circle is the circle moving the other way against the box
+bool sweep(const AABB& moving, glm::vec2 displacement, const Circle& target, float& toi, glm::vec2& normal)
+{
+	if (!sweep(target, -displacement, moving, toi, normal)) return false;
+	normal = -normal;
+	return true;
+}
+
+bool sweep(const OBB& moving, glm::vec2 displacement, const Circle& target, float& toi, glm::vec2& normal)
+{
+	if (!sweep(target, -displacement, moving, toi, normal)) return false;
+	normal = -normal;
+	return true;
+}
+
+// Conservative advancement: the distance between convex shapes along a straight path is convex, so moving the
+// shape by the gap over the closing speed never goes past the first contact
+bool sweep(const ConvexShape& moving, glm::vec2 displacement, const ConvexShape& target, float& toi, glm::vec2& normal)
+{
+	constexpr uint32_t MaxIterations = 32;
+	constexpr float GapTolerance = 4.0f * CoreContactTolerance;
+	float radius = moving.Radius + target.Radius;
+
+	float t = 0.0f;
+	for (uint32_t iteration = 0; iteration < MaxIterations; iteration++)
+	{
+		DistanceOutput distance = gjkDistance(target, moving.translated(t * displacement));
+		if (distance.Distance <= CoreContactTolerance)
+		{
+			// Cores reached by the last step keep its normal, cores overlapping from the start are pushed out along the EPA normal
+			toi = t;
+			if (t > 0.0f) return true;
+
+			PenetrationOutput penetration;
+			if (epaPenetration(target, moving, penetration)) normal = penetration.Normal;
+			else if (displacement != glm::vec2(0.0f)) normal = -glm::normalize(displacement);
+			else normal = glm::vec2(0.0f, 1.0f);
+			return true;
+		}
+
+		normal = (distance.PointB - distance.PointA) / distance.Distance;
+		float gap = distance.Distance - radius;
+		if (gap <= GapTolerance)
+		{
+			toi = t;
+			return true;
+		}
+
+		float closingSpeed = -glm::dot(displacement, normal);
+		if (closingSpeed <= 0.0f) return false;
+
+		t += gap / closingSpeed;
+		if (t > 1.0f) return false;
+	}
+
+	toi = t;
+	return true;
+}
+
+// Polygons and capsules have no test of their own against other types, they go through GJK
+static bool hasSpecializedTests(const Collider& collider)
+{
+	return collider.Type == Collider::ColliderType::AABB ||
+		collider.Type == Collider::ColliderType::OBB ||
+		collider.Type == Collider::ColliderType::Circle;
+}
+
+template<typename MovingT>
+static bool sweepAgainst(const MovingT& moving, glm::vec2 displacement, const Collider& target, float& toi, glm::vec2& normal)
+{
+	switch (target.Type) {
+	case Collider::ColliderType::AABB:   return sweep(moving, displacement, target.AABBCollider, toi, normal);
+	case Collider::ColliderType::OBB:    return sweep(moving, displacement, target.OBBCollider, toi, normal);
+	case Collider::ColliderType::Circle: return sweep(moving, displacement, target.CircleCollider, toi, normal);
+	default: ASSERT_FALSE("Unknown collider type");
+	}
+	return false;
+}
+
+bool sweep(const Collider& moving, glm::vec2 displacement, const Collider& target, float& toi, glm::vec2& normal)
+{
+	if (!hasSpecializedTests(moving) || !hasSpecializedTests(target))
+		return sweep(ConvexShape(moving), displacement, ConvexShape(target), toi, normal);
+
+	switch (moving.Type) {
+	case Collider::ColliderType::AABB:   return sweepAgainst(moving.AABBCollider, displacement, target, toi, normal);
+	case Collider::ColliderType::OBB:    return sweepAgainst(moving.OBBCollider, displacement, target, toi, normal);
+	case Collider::ColliderType::Circle: return sweepAgainst(moving.CircleCollider, displacement, target, toi, normal);
+	default: ASSERT_FALSE("Unknown collider type");
+	}
+	return false;
+}
+
+// ==========================================
+// Contact manifolds
+
+// Outward normal of the edge from start to end of a counter clockwise polygon, 0 for a degenerate edge
+static glm::vec2 edgeNormal(glm::vec2 start, glm::vec2 end)
+{
+	glm::vec2 edge = end - start;
+	float length = glm::length(edge);
+	return (length > 0.0f) ? glm::vec2(edge.y, -edge.x) / length : glm::vec2(0.0f);
+}
+
+// Box corners in counter clockwise order with the outward normal of the edge starting at each corner
+struct BoxPolygon {
+	std::array<glm::vec2, 4> Vertices;
+	std::array<glm::vec2, 4> Normals;
+
+	explicit BoxPolygon(const std::array<glm::vec2, 4>& corners)
+		: Vertices(corners)
+	{
+		for (uint32_t i = 0; i < 4; i++)
+			Normals[i] = edgeNormal(Vertices[i], Vertices[(i + 1) % 4]);
+	}
+
+	static constexpr uint32_t size() { return 4; }
+};
+
+// Same as BoxPolygon for the core of any shape (a segment has two edges facing opposite ways)
+struct ClipPolygon {
+	std::array<glm::vec2, Polygon::MaxVertices> Vertices;
+	std::array<glm::vec2, Polygon::MaxVertices> Normals;
+	uint32_t Count;
+
+	explicit ClipPolygon(const ConvexShape& shape)
+		: Vertices(shape.Vertices), Count(shape.Count)
+	{
+		for (uint32_t i = 0; i < Count; i++)
+			Normals[i] = edgeNormal(Vertices[i], Vertices[(i + 1) % Count]);
+	}
+
+	uint32_t size() const { return Count; }
+};
+
+// Largest separation of polygon2 from the edges of polygon1, negative when overlapping on every edge
+template<typename PolygonT>
+static float findMaxSeparation(const PolygonT& polygon1, const PolygonT& polygon2, uint32_t& bestEdge)
+{
+	float maxSeparation = -std::numeric_limits<float>::infinity();
+	bestEdge = 0;
+	for (uint32_t i = 0; i < polygon1.size(); i++)
+	{
+		float separation = std::numeric_limits<float>::infinity();
+		for (uint32_t j = 0; j < polygon2.size(); j++)
+			separation = std::min(separation, glm::dot(polygon1.Normals[i], polygon2.Vertices[j] - polygon1.Vertices[i]));
+
+		if (separation > maxSeparation)
+		{
+			maxSeparation = separation;
+			bestEdge = i;
+		}
+	}
+	return maxSeparation;
+}
+
+struct ClipVertex {
+	glm::vec2 Position;
+	uint32_t ID;
+};
+
+// Keeps the part of the segment with dot(normal, p) <= offset, the clipped end gets clipID
+static uint32_t clipSegment(const ClipVertex in[2], ClipVertex out[2], glm::vec2 normal, float offset, uint32_t clipID)
+{
+	uint32_t count = 0;
+	float distance0 = glm::dot(normal, in[0].Position) - offset;
+	float distance1 = glm::dot(normal, in[1].Position) - offset;
+
+	if (distance0 <= 0.0f) out[count++] = in[0];
+	if (distance1 <= 0.0f) out[count++] = in[1];
+
+	if (distance0 * distance1 < 0.0f)
+	{
+		float t = distance0 / (distance0 - distance1);
+		out[count].Position = in[0].Position + t * (in[1].Position - in[0].Position);
+		out[count].ID = clipID;
+		count++;
+	}
+	return count;
+}
+
+// Clips the incident edge to the sides of the reference edge, whose outward normal points at the incident shape.
+// Points within the radii of both shapes from the reference edge become contacts, halfway between the surfaces.
+static bool clipIncidentEdge(glm::vec2 referenceStart, glm::vec2 referenceEnd, glm::vec2 normal, const ClipVertex incidentSegment[2],
+	float referenceRadius, float incidentRadius, uint32_t featureID, ContactManifold& manifold)
+{
+	// Clipped ends are told apart from the vertices of any polygon
+	constexpr uint32_t ClipStartID = Polygon::MaxVertices;
+	constexpr uint32_t ClipEndID = Polygon::MaxVertices + 1;
+
+	glm::vec2 tangent = referenceEnd - referenceStart;
+	float referenceLength = glm::length(tangent);
+	if (referenceLength == 0.0f) return false;
+	tangent /= referenceLength;
+
+	ClipVertex clipped1[2], clipped2[2];
+	if (clipSegment(incidentSegment, clipped1, -tangent, -glm::dot(tangent, referenceStart), ClipStartID) < 2) return false;
+	if (clipSegment(clipped1, clipped2, tangent, glm::dot(tangent, referenceEnd), ClipEndID) < 2) return false;
+
+	float radius = referenceRadius + incidentRadius;
+	manifold.PointCount = 0;
+	for (const ClipVertex& vertex : clipped2)
+	{
+		float separation = glm::dot(normal, vertex.Position - referenceStart);
+		if (separation > radius) continue;
+
+		ContactPoint& point = manifold.Points[manifold.PointCount++];
+		point = ContactPoint{};
+		point.Position = vertex.Position + 0.5f * (referenceRadius - separation - incidentRadius) * normal;
+		point.Penetration = radius - separation;
+		point.FeatureID = featureID | (vertex.ID << 16);
+	}
+	return manifold.PointCount > 0;
+}
+
+// Reference / incident edge clipping for polygons (radius 0), boxes are the 4 vertex case
+template<typename PolygonT>
+static bool computePolygonManifold(const PolygonT& a, const PolygonT& b, ContactManifold& manifold)
+{
+	uint32_t edgeA, edgeB;
+	float separationA = findMaxSeparation(a, b, edgeA);
+	if (separationA > 0.0f) return false;
+	float separationB = findMaxSeparation(b, a, edgeB);
+	if (separationB > 0.0f) return false;
+
+	// Prefer A as reference so that the choice doesn't flicker between steps on equal separations
+	constexpr float ReferenceTolerance = 0.0005f;
+	bool flip = separationB > separationA + ReferenceTolerance;
+	const PolygonT& reference = flip ? b : a;
+	const PolygonT& incident = flip ? a : b;
+	uint32_t referenceEdge = flip ? edgeB : edgeA;
+	glm::vec2 normal = reference.Normals[referenceEdge];
+
+	// Incident edge is the one facing the reference edge the most
+	uint32_t incidentEdge = 0;
+	float minDot = std::numeric_limits<float>::infinity();
+	for (uint32_t i = 0; i < incident.size(); i++)
+	{
+		float d = glm::dot(normal, incident.Normals[i]);
+		if (d < minDot)
+		{
+			minDot = d;
+			incidentEdge = i;
+		}
+	}
+
+	ClipVertex incidentSegment[2] = {
+		{ incident.Vertices[incidentEdge], incidentEdge },
+		{ incident.Vertices[(incidentEdge + 1) % incident.size()], (incidentEdge + 1) % incident.size() }
+	};
+	manifold.Normal = flip ? -normal : normal;
+	return clipIncidentEdge(reference.Vertices[referenceEdge], reference.Vertices[(referenceEdge + 1) % reference.size()], normal,
+		incidentSegment, 0.0f, 0.0f, referenceEdge | (incidentEdge << 8) | (uint32_t(flip) << 24), manifold);
+}
+
+// Circle against a box given by its center, half extents and rotation, the normal points from the circle to the box
+static bool computeCircleBoxManifold(const Circle& circle, glm::vec2 boxCenter, glm::vec2 halfExtents, float boxRotation, ContactManifold& manifold)
+{
+	float c = simCos(-boxRotation);
+	float s = simSin(-boxRotation);
+	glm::vec2 local = rotate(circle.Center - boxCenter, c, s);
+	glm::vec2 closest = glm::clamp(local, -halfExtents, halfExtents);
+
+	glm::vec2 boxToCircle; // In box space
+	float penetration;
+	glm::vec2 surfacePoint = closest;
+	if (closest == local)
+	{
+		// Center inside the box, pushed out through the closest face
+		glm::vec2 faceDistances = halfExtents - glm::abs(local);
+		int axis = (faceDistances.x < faceDistances.y) ? 0 : 1;
+		boxToCircle = glm::vec2(0.0f);
+		boxToCircle[axis] = (local[axis] < 0.0f) ? -1.0f : 1.0f;
+		surfacePoint[axis] = boxToCircle[axis] * halfExtents[axis];
+		penetration = circle.Radius + faceDistances[axis];
+	}
+	else
+	{
+		glm::vec2 offset = local - closest;
+		float distance2 = glm::dot(offset, offset);
+		if (distance2 > circle.Radius * circle.Radius) return false;
+
+		float distance = std::sqrt(distance2);
+		boxToCircle = offset / distance;
+		penetration = circle.Radius - distance;
+	}
+
+	glm::vec2 normal = rotate(boxToCircle, c, -s);
+	glm::vec2 worldSurfacePoint = boxCenter + rotate(surfacePoint, c, -s);
+
+	manifold.Normal = -normal;
+	manifold.PointCount = 1;
+	manifold.Points[0] = ContactPoint{};
+	manifold.Points[0].Position = worldSurfacePoint - 0.5f * penetration * normal;
+	manifold.Points[0].Penetration = penetration;
+	manifold.Points[0].FeatureID = 0;
+	return true;
+}
+
+static bool computeCircleManifold(const Circle& a, const Circle& b, ContactManifold& manifold)
+{
+	glm::vec2 offset = b.Center - a.Center;
+	float distance2 = glm::dot(offset, offset);
+	float radius = a.Radius + b.Radius;
+	if (distance2 > radius * radius) return false;
+
+	float distance = std::sqrt(distance2);
+	manifold.Normal = (distance > 0.0f) ? offset / distance : glm::vec2(0.0f, 1.0f);
+	manifold.PointCount = 1;
+	manifold.Points[0] = ContactPoint{};
+	manifold.Points[0].Penetration = radius - distance;
+	manifold.Points[0].Position = a.Center + manifold.Normal * (a.Radius - 0.5f * manifold.Points[0].Penetration);
+	manifold.Points[0].FeatureID = 0;
+	return true;
+}
+
+// Circle manifold against the box of a collider
+static bool computeCircleManifold(const Circle& circle, const Collider& box, ContactManifold& manifold)
+{
+	if (box.Type == Collider::ColliderType::AABB)
+	{
+		const AABB& aabb = box.AABBCollider;
+		return computeCircleBoxManifold(circle, 0.5f * (aabb.Min + aabb.Max), 0.5f * (aabb.Max - aabb.Min), 0.0f, manifold);
+	}
+	const OBB& obb = box.OBBCollider;
+	return computeCircleBoxManifold(circle, obb.Center, 0.5f * obb.Size, obb.Rotation, manifold);
+}
+
+// Edge whose outward normal is the closest to direction
+static uint32_t findFacingEdge(const ClipPolygon& polygon, glm::vec2 direction)
+{
+	uint32_t bestEdge = 0;
+	float maxDot = -std::numeric_limits<float>::infinity();
+	for (uint32_t i = 0; i < polygon.size(); i++)
+	{
+		float d = glm::dot(polygon.Normals[i], direction);
+		if (d > maxDot)
+		{
+			maxDot = d;
+			bestEdge = i;
+		}
+	}
+	return bestEdge;
+}
+
+// Manifold of any two shapes through GJK / EPA. Polygons (radius 0) are clipped like boxes, shapes with a radius
+// touch on the closest points of their cores, or along a segment when the closest features are parallel edges
+// (eg: a capsule lying on a box). Cores overlapping each other are pushed apart along the EPA normal.
+static bool computeConvexManifold(const ConvexShape& a, const ConvexShape& b, ContactManifold& manifold)
+{
+	float radius = a.Radius + b.Radius;
+	if (radius == 0.0f)
+		return computePolygonManifold(ClipPolygon(a), ClipPolygon(b), manifold);
+
+	DistanceOutput distance = gjkDistance(a, b);
+	if (distance.Distance > radius) return false;
+
+	glm::vec2 normal, pointA, pointB;
+	float penetration;
+	if (distance.Distance > CoreContactTolerance)
+	{
+		normal = (distance.PointB - distance.PointA) / distance.Distance;
+
+		// Within a degree of parallel
+		constexpr float ParallelTolerance = 0.99985f;
+		if (a.Count >= 2 && b.Count >= 2)
+		{
+			ClipPolygon polygonA(a), polygonB(b);
+			uint32_t edgeA = findFacingEdge(polygonA, normal);
+			uint32_t edgeB = findFacingEdge(polygonB, -normal);
+			if (glm::dot(polygonA.Normals[edgeA], normal) >= ParallelTolerance && glm::dot(polygonB.Normals[edgeB], -normal) >= ParallelTolerance)
+			{
+				ClipVertex incidentSegment[2] = {
+					{ polygonB.Vertices[edgeB], edgeB },
+					{ polygonB.Vertices[(edgeB + 1) % polygonB.size()], (edgeB + 1) % polygonB.size() }
+				};
+				manifold.Normal = polygonA.Normals[edgeA];
+				if (clipIncidentEdge(polygonA.Vertices[edgeA], polygonA.Vertices[(edgeA + 1) % polygonA.size()], manifold.Normal,
+					incidentSegment, a.Radius, b.Radius, edgeA | (edgeB << 8), manifold))
+					return true;
+			}
+		}
+
+		pointA = distance.PointA;
+		pointB = distance.PointB;
+		penetration = radius - distance.Distance;
+	}
+	else
+	{
+		PenetrationOutput output;
+		if (!epaPenetration(a, b, output))
+		{
+			// Degenerate cores (eg: collinear segments) are pushed apart along any direction
+			output.Normal = glm::vec2(0.0f, 1.0f);
+			output.Depth = radius;
+			output.PointA = output.PointB = distance.PointA;
+		}
+		normal = output.Normal;
+		pointA = output.PointA;
+		pointB = output.PointB;
+		penetration = output.Depth;
+	}
+
+	manifold.Normal = normal;
+	manifold.PointCount = 1;
+	manifold.Points[0] = ContactPoint{};
+	manifold.Points[0].Position = 0.5f * (pointA + a.Radius * normal + pointB - b.Radius * normal);
+	manifold.Points[0].Penetration = penetration;
+	manifold.Points[0].FeatureID = 0;
+	return true;
+}
+
+static std::array<glm::vec2, 4> getBoxCorners(const Collider& box)
+{
+	return (box.Type == Collider::ColliderType::AABB) ? box.AABBCollider.getCorners() : box.OBBCollider.getCorners();
+}
+
+bool computeManifold(const Collider& a, const Collider& b, ContactManifold& manifold)
+{
+	if (!hasSpecializedTests(a) || !hasSpecializedTests(b))
+		return computeConvexManifold(ConvexShape(a), ConvexShape(b), manifold);
+
+	bool circleA = a.Type == Collider::ColliderType::Circle;
+	bool circleB = b.Type == Collider::ColliderType::Circle;
+
+	if (circleA && circleB)
+		return computeCircleManifold(a.CircleCollider, b.CircleCollider, manifold);
+
+	if (circleA)
+		return computeCircleManifold(a.CircleCollider, b, manifold);
+
+	if (circleB)
+	{
+		if (!computeCircleManifold(b.CircleCollider, a, manifold)) return false;
+		manifold.Normal = -manifold.Normal;
+		return true;
+	}
+
+	return computePolygonManifold(BoxPolygon(getBoxCorners(a)), BoxPolygon(getBoxCorners(b)), manifold);
+}
+
+float distance(const Collider& collider, glm::vec2 point)
+{
+	switch (collider.Type)
+	{
+	case Collider::ColliderType::AABB:
+		return collider.AABBCollider.distance(point);
+	case Collider::ColliderType::OBB: {
+		// In the OBB local space the OBB is an AABB centered at the origin
+		const OBB& obb = collider.OBBCollider;
+		glm::vec2 local = rotate(point - obb.Center, simCos(-obb.Rotation), simSin(-obb.Rotation));
+		glm::vec2 halfExtents = 0.5f * obb.Size;
+		return AABB(-halfExtents, halfExtents).distance(local);
+	}
+	case Collider::ColliderType::Circle: {
+		const Circle& circle = collider.CircleCollider;
+		return std::max(glm::length(point - circle.Center) - circle.Radius, 0.0f);
+	}
+	case Collider::ColliderType::Polygon:
+	case Collider::ColliderType::Capsule: {
+		ConvexShape shape(collider);
+		DistanceOutput output = gjkDistance(shape, ConvexShape(Circle(point, 0.0f)));
+		return std::max(output.Distance - shape.Radius, 0.0f);
+	}
+	default:
+		ASSERT_FALSE("Unknown collider type");
+		return 0.0f;
+	}
+}
+
 } // CollisionUtilities
 } // TileBite
\ No newline at end of file
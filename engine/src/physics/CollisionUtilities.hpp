@@ -6,14 +6,19 @@
 #include "physics/AABB.hpp"
 #include "physics/OBB.hpp"
 #include "physics/Collider.hpp"
+#include "physics/ContactManifold.hpp"
 
 namespace TileBite {
+
+struct ConvexShape;
+
 namespace CollisionUtilities {
 
 // TODO: could use macro for symetric functions
 
 // ====================================================
 // Intersection tests between different collider types
+// Polygons and capsules are tested against every type with GJK (see physics/GJK.hpp), the rest have specialized tests.
 
 bool intersects(const AABB& a, const OBB& b);
 bool intersects(const OBB& a, const AABB& b);
@@ -32,6 +37,44 @@ bool intersects(const Circle& a, const Collider& b);
 bool SATTest(const std::array<glm::vec2, 4>& points1, const std::array<glm::vec2, 4>& points2);
 bool SATTest(const AABB& aabb, const std::array<glm::vec2, 4>& points2);
 
+// ====================================================
+// Swept tests, moving is translated by displacement against a static target.
+// On contact toi is the fraction of displacement [0, 1] at first contact and normal the unit normal
+// of target at the contact point (pointing towards moving).
+// Shapes overlapping from the start report a toi of 0 and the direction of least penetration.
+
+bool sweep(const AABB& moving, glm::vec2 displacement, const AABB& target, float& toi, glm::vec2& normal);
+bool sweep(const AABB& moving, glm::vec2 displacement, const OBB& target, float& toi, glm::vec2& normal);
+bool sweep(const AABB& moving, glm::vec2 displacement, const Circle& target, float& toi, glm::vec2& normal);
+bool sweep(const OBB& moving, glm::vec2 displacement, const AABB& target, float& toi, glm::vec2& normal);
+bool sweep(const OBB& moving, glm::vec2 displacement, const OBB& target, float& toi, glm::vec2& normal);
+bool sweep(const OBB& moving, glm::vec2 displacement, const Circle& target, float& toi, glm::vec2& normal);
+bool sweep(const Circle& moving, glm::vec2 displacement, const AABB& target, float& toi, glm::vec2& normal);
+bool sweep(const Circle& moving, glm::vec2 displacement, const OBB& target, float& toi, glm::vec2& normal);
+bool sweep(const Circle& moving, glm::vec2 displacement, const Circle& target, float& toi, glm::vec2& normal);
+bool sweep(const Collider& moving, glm::vec2 displacement, const Collider& target, float& toi, glm::vec2& normal);
+
+// Generic sweep of any two shapes by conservative advancement on GJK distances, used for polygons and capsules
+bool sweep(const ConvexShape& moving, glm::vec2 displacement, const ConvexShape& target, float& toi, glm::vec2& normal);
+
+// Times (fractions of displacement) between which moving overlaps target, false if they don't overlap within [0, 1]
+bool sweepInterval(const AABB& moving, glm::vec2 displacement, const AABB& target, float& tEnter, float& tExit);
+
+// ====================================================
+// Contact manifolds, false if the shapes don't touch. The normal points from a to b.
+// Boxes (AABB and OBB) get up to two points by clipping the incident edge against the reference edge.
+// Pairs with a polygon or capsule go through GJK / EPA, polygons and parallel edges get clipped the same way.
+
+bool computeManifold(const Collider& a, const Collider& b, ContactManifold& manifold);
+
+// ====================================================
+// Point tests, boundaries count as inside
+
+// Distance from point to the closest point of collider, 0 if point is inside
+float distance(const Collider& collider, glm::vec2 point);
+
+inline bool contains(const Collider& collider, glm::vec2 point) { return distance(collider, point) <= 0.0f; }
+
 } // CollisionUtilities
 } // TileBite
 
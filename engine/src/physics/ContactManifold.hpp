@@ -0,0 +1,30 @@
+#ifndef CONTACT_MANIFOLD_HPP
+#define CONTACT_MANIFOLD_HPP
+
+#include "core/pch.hpp"
+#include <glm/glm.hpp>
+
+namespace TileBite {
+
+struct ContactPoint {
+	glm::vec2 Position; // World space, halfway between the two surfaces
+	float Penetration; // Depth along the manifold normal
+	uint32_t FeatureID; // Same for the same pair of edges / vertices across steps
+
+	// Accumulated by the contact solver, carried over to the next step for warm starting
+	float NormalImpulse = 0.0f;
+	float TangentImpulse = 0.0f;
+};
+
+// Touching points of two shapes A and B, Normal is a unit vector pointing from A to B.
+struct ContactManifold {
+	static constexpr uint32_t MaxPoints = 2;
+
+	glm::vec2 Normal = glm::vec2(0.0f);
+	uint32_t PointCount = 0;
+	ContactPoint Points[MaxPoints];
+};
+
+} // TileBite
+
+#endif // !CONTACT_MANIFOLD_HPP
@@ -0,0 +1,248 @@
+#include "physics/ContactSolver.hpp"
+
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+namespace {
+
+constexpr uint32_t NoIsland = UINT32_MAX;
+
+inline float cross(glm::vec2 a, glm::vec2 b) { return a.x * b.y - a.y * b.x; }
+
+// Velocity of a point at r from the center of a body rotating at angularVelocity
+inline glm::vec2 cross(float angularVelocity, glm::vec2 r) { return glm::vec2(-angularVelocity * r.y, angularVelocity * r.x); }
+
+// Body whose island the contact belongs to, static bodies don't join islands
+inline uint32_t getIslandBody(const RigidBodyData& bodies, const BodyContact& contact)
+{
+	if (contact.BodyA != BodyContact::NoBody && bodies.isDynamic(contact.BodyA)) return contact.BodyA;
+	if (contact.BodyB != BodyContact::NoBody && bodies.isDynamic(contact.BodyB)) return contact.BodyB;
+	return BodyContact::NoBody;
+}
+
+} // namespace
+
+void ContactSolver::solve(RigidBodyData& bodies, std::vector<BodyContact>& contacts, float deltaTime, ThreadPool* threadPool)
+{
+	if (contacts.empty() || deltaTime <= 0.0f)
+	{
+		m_cachedContacts.clear();
+		return;
+	}
+
+	warmStartFromCache(contacts);
+	buildIslands(bodies, contacts);
+	m_pointConstraints.resize(contacts.size() * ContactManifold::MaxPoints);
+
+	// Islands only share static bodies, which are read but never written
+	uint32_t islandCount = getIslandCount();
+	auto solveIslands = [&](uint32_t begin, uint32_t end) {
+		for (uint32_t island = begin; island < end; island++)
+		{
+			uint32_t first = m_islandOffsets[island];
+			uint32_t count = m_islandOffsets[island + 1] - first;
+			solveIsland(bodies, contacts, std::span<const uint32_t>(m_islandContacts.data() + first, count), deltaTime);
+		}
+	};
+
+	if (threadPool && islandCount > 1)
+		threadPool->parallelFor(islandCount, IslandChunkSize, solveIslands);
+	else
+		solveIslands(0, islandCount);
+
+	cacheContacts(contacts);
+}
+
+void ContactSolver::warmStartFromCache(std::vector<BodyContact>& contacts) const
+{
+	for (BodyContact& contact : contacts)
+	{
+		auto it = std::lower_bound(m_cachedContacts.begin(), m_cachedContacts.end(), contact.Key, [](const CachedContact& cached, const ContactKey& key) {
+			return cached.Key < key;
+		});
+		if (it == m_cachedContacts.end() || it->Key != contact.Key) continue;
+
+		// Points are matched by the features in contact, new features start from 0
+		for (uint32_t i = 0; i < contact.Manifold.PointCount; i++)
+		{
+			ContactPoint& point = contact.Manifold.Points[i];
+			for (uint32_t j = 0; j < it->Manifold.PointCount; j++)
+			{
+				const ContactPoint& cachedPoint = it->Manifold.Points[j];
+				if (cachedPoint.FeatureID == point.FeatureID)
+				{
+					point.NormalImpulse = cachedPoint.NormalImpulse;
+					point.TangentImpulse = cachedPoint.TangentImpulse;
+					break;
+				}
+			}
+		}
+	}
+}
+
+uint32_t ContactSolver::findIslandRoot(uint32_t body)
+{
+	while (m_islandParents[body] != body)
+	{
+		m_islandParents[body] = m_islandParents[m_islandParents[body]]; // Path halving
+		body = m_islandParents[body];
+	}
+	return body;
+}
+
+void ContactSolver::buildIslands(const RigidBodyData& bodies, const std::vector<BodyContact>& contacts)
+{
+	uint32_t bodyCount = bodies.size();
+	m_islandParents.resize(bodyCount);
+	std::iota(m_islandParents.begin(), m_islandParents.end(), 0u);
+
+	for (const BodyContact& contact : contacts)
+	{
+		if (contact.BodyA == BodyContact::NoBody || contact.BodyB == BodyContact::NoBody) continue;
+		if (!bodies.isDynamic(contact.BodyA) || !bodies.isDynamic(contact.BodyB)) continue;
+
+		uint32_t rootA = findIslandRoot(contact.BodyA);
+		uint32_t rootB = findIslandRoot(contact.BodyB);
+		if (rootA != rootB) m_islandParents[rootA] = rootB;
+	}
+
+	// Counting sort of the contacts by island, islands are numbered in order of their first contact
+	m_islandOfRoot.assign(bodyCount, NoIsland);
+	m_islandOffsets.assign(1, 0);
+	for (const BodyContact& contact : contacts)
+	{
+		uint32_t body = getIslandBody(bodies, contact);
+		if (body == BodyContact::NoBody) continue;
+
+		uint32_t root = findIslandRoot(body);
+		if (m_islandOfRoot[root] == NoIsland)
+		{
+			m_islandOfRoot[root] = static_cast<uint32_t>(m_islandOffsets.size()) - 1;
+			m_islandOffsets.push_back(0);
+		}
+		m_islandOffsets[m_islandOfRoot[root] + 1]++;
+	}
+
+	for (uint32_t i = 1; i < m_islandOffsets.size(); i++)
+		m_islandOffsets[i] += m_islandOffsets[i - 1];
+
+	// Offsets are used as insertion cursors, which moves each of them to the start of the next island
+	m_islandContacts.resize(m_islandOffsets.back());
+	for (uint32_t i = 0; i < contacts.size(); i++)
+	{
+		uint32_t body = getIslandBody(bodies, contacts[i]);
+		if (body == BodyContact::NoBody) continue;
+
+		uint32_t island = m_islandOfRoot[findIslandRoot(body)];
+		m_islandContacts[m_islandOffsets[island]++] = i;
+	}
+
+	for (uint32_t i = static_cast<uint32_t>(m_islandOffsets.size()) - 1; i > 0; i--)
+		m_islandOffsets[i] = m_islandOffsets[i - 1];
+	m_islandOffsets[0] = 0;
+}
+
+void ContactSolver::solveIsland(RigidBodyData& bodies, std::vector<BodyContact>& contacts, std::span<const uint32_t> islandContacts, float deltaTime)
+{
+	auto inverseMass = [&](uint32_t body) {
+		return (body != BodyContact::NoBody) ? bodies.InverseMasses[body] : 0.0f;
+	};
+	auto inverseInertia = [&](uint32_t body) {
+		return (body != BodyContact::NoBody && bodies.isDynamic(body)) ? bodies.InverseInertias[body] : 0.0f;
+	};
+	auto pointVelocity = [&](uint32_t body, glm::vec2 r) {
+		if (body == BodyContact::NoBody) return glm::vec2(0.0f);
+		return bodies.LinearVelocities[body] + cross(bodies.AngularVelocities[body], r);
+	};
+	auto applyImpulse = [&](uint32_t body, glm::vec2 impulse, glm::vec2 r) {
+		if (body == BodyContact::NoBody || !bodies.isDynamic(body)) return;
+		bodies.LinearVelocities[body] += bodies.InverseMasses[body] * impulse;
+		bodies.AngularVelocities[body] += bodies.InverseInertias[body] * cross(r, impulse);
+	};
+
+	// Effective masses, biases and warm starting
+	for (uint32_t contactIndex : islandContacts)
+	{
+		BodyContact& contact = contacts[contactIndex];
+		uint32_t bodyA = contact.BodyA;
+		uint32_t bodyB = contact.BodyB;
+		float inverseMassA = inverseMass(bodyA), inverseMassB = inverseMass(bodyB);
+		float inverseInertiaA = inverseInertia(bodyA), inverseInertiaB = inverseInertia(bodyB);
+		glm::vec2 normal = contact.Manifold.Normal;
+		glm::vec2 tangent(normal.y, -normal.x);
+
+		for (uint32_t i = 0; i < contact.Manifold.PointCount; i++)
+		{
+			ContactPoint& point = contact.Manifold.Points[i];
+			PointConstraint& constraint = m_pointConstraints[contactIndex * ContactManifold::MaxPoints + i];
+			constraint.RA = (bodyA != BodyContact::NoBody) ? point.Position - bodies.Positions[bodyA] : glm::vec2(0.0f);
+			constraint.RB = (bodyB != BodyContact::NoBody) ? point.Position - bodies.Positions[bodyB] : glm::vec2(0.0f);
+
+			float rnA = cross(constraint.RA, normal), rnB = cross(constraint.RB, normal);
+			float normalMass = inverseMassA + inverseMassB + inverseInertiaA * rnA * rnA + inverseInertiaB * rnB * rnB;
+			constraint.NormalMass = (normalMass > 0.0f) ? 1.0f / normalMass : 0.0f;
+
+			float rtA = cross(constraint.RA, tangent), rtB = cross(constraint.RB, tangent);
+			float tangentMass = inverseMassA + inverseMassB + inverseInertiaA * rtA * rtA + inverseInertiaB * rtB * rtB;
+			constraint.TangentMass = (tangentMass > 0.0f) ? 1.0f / tangentMass : 0.0f;
+
+			// Penetration past the slop is pushed out over a few steps, fast impacts bounce
+			constraint.VelocityBias = m_settings.Baumgarte / deltaTime * std::max(0.0f, point.Penetration - m_settings.LinearSlop);
+			float approachVelocity = glm::dot(pointVelocity(bodyB, constraint.RB) - pointVelocity(bodyA, constraint.RA), normal);
+			if (approachVelocity < -m_settings.RestitutionThreshold)
+				constraint.VelocityBias = std::max(constraint.VelocityBias, -contact.Restitution * approachVelocity);
+
+			glm::vec2 impulse = point.NormalImpulse * normal + point.TangentImpulse * tangent;
+			applyImpulse(bodyA, -impulse, constraint.RA);
+			applyImpulse(bodyB, impulse, constraint.RB);
+		}
+	}
+
+	for (uint32_t iteration = 0; iteration < m_settings.VelocityIterations; iteration++)
+	{
+		for (uint32_t contactIndex : islandContacts)
+		{
+			BodyContact& contact = contacts[contactIndex];
+			glm::vec2 normal = contact.Manifold.Normal;
+			glm::vec2 tangent(normal.y, -normal.x);
+
+			for (uint32_t i = 0; i < contact.Manifold.PointCount; i++)
+			{
+				ContactPoint& point = contact.Manifold.Points[i];
+				const PointConstraint& constraint = m_pointConstraints[contactIndex * ContactManifold::MaxPoints + i];
+
+				// Friction, bounded by the normal impulse of the last iteration
+				glm::vec2 relativeVelocity = pointVelocity(contact.BodyB, constraint.RB) - pointVelocity(contact.BodyA, constraint.RA);
+				float maxFriction = contact.Friction * point.NormalImpulse;
+				float tangentImpulse = std::clamp(point.TangentImpulse - constraint.TangentMass * glm::dot(relativeVelocity, tangent), -maxFriction, maxFriction);
+				glm::vec2 impulse = (tangentImpulse - point.TangentImpulse) * tangent;
+				point.TangentImpulse = tangentImpulse;
+				applyImpulse(contact.BodyA, -impulse, constraint.RA);
+				applyImpulse(contact.BodyB, impulse, constraint.RB);
+
+				// Non penetration, the accumulated impulse can only push
+				relativeVelocity = pointVelocity(contact.BodyB, constraint.RB) - pointVelocity(contact.BodyA, constraint.RA);
+				float normalVelocity = glm::dot(relativeVelocity, normal);
+				float normalImpulse = std::max(point.NormalImpulse - constraint.NormalMass * (normalVelocity - constraint.VelocityBias), 0.0f);
+				impulse = (normalImpulse - point.NormalImpulse) * normal;
+				point.NormalImpulse = normalImpulse;
+				applyImpulse(contact.BodyA, -impulse, constraint.RA);
+				applyImpulse(contact.BodyB, impulse, constraint.RB);
+			}
+		}
+	}
+}
+
+void ContactSolver::cacheContacts(const std::vector<BodyContact>& contacts)
+{
+	m_cachedContacts.clear();
+	for (const BodyContact& contact : contacts)
+		m_cachedContacts.push_back(CachedContact{ contact.Key, contact.Manifold });
+
+	std::sort(m_cachedContacts.begin(), m_cachedContacts.end(), [](const CachedContact& a, const CachedContact& b) {
+		return a.Key < b.Key;
+	});
+}
+
+} // TileBite
@@ -0,0 +1,95 @@
+#ifndef CONTACT_SOLVER_HPP
+#define CONTACT_SOLVER_HPP
+
+#include "core/pch.hpp"
+#include "core/Types.hpp"
+#include "physics/ContactManifold.hpp"
+#include "physics/RigidBodyData.hpp"
+#include "utilities/ThreadPool.hpp"
+
+namespace TileBite {
+
+// Identifies a contact across steps: a pair of colliders (idA < idB), or a collider and a tile of a tilemap.
+struct ContactKey {
+	static constexpr uint32_t NoTile = UINT32_MAX;
+
+	ID IDA;
+	ID IDB;
+	uint32_t XTile = NoTile;
+	uint32_t YTile = NoTile;
+
+	auto operator<=>(const ContactKey& other) const = default;
+};
+
+// Contact of a physics step between bodies A and B, the normal of the manifold points from A to B.
+// A body index of NoBody stands for a static collider or tile.
+struct BodyContact {
+	static constexpr uint32_t NoBody = UINT32_MAX;
+
+	uint32_t BodyA;
+	uint32_t BodyB;
+	ContactKey Key;
+	float Friction;
+	float Restitution;
+	ContactManifold Manifold;
+};
+
+// Sequential impulse contact solver (https://box2d.org/files/ErinCatto_SequentialImpulses_GDC2006.pdf).
+// Impulses of the last step are matched by contact key and feature ID to warm start the next one.
+// Dynamic bodies connected by contacts form islands, which share no dynamic body and are solved in parallel.
+class ContactSolver {
+public:
+	struct Settings {
+		uint32_t VelocityIterations = 8;
+		float Baumgarte = 0.2f; // Fraction of the penetration corrected per step
+		float LinearSlop = 0.005f; // Penetration allowed to keep contacts stable
+		float RestitutionThreshold = 1.0f; // Slower impacts don't bounce
+	};
+
+	Settings& getSettings() { return m_settings; }
+
+	// Changes the velocities of bodies so that the contacts don't approach (or separate penetrating bodies).
+	// Islands are split across the workers of threadPool when given.
+	void solve(RigidBodyData& bodies, std::vector<BodyContact>& contacts, float deltaTime, ThreadPool* threadPool = nullptr);
+
+	uint32_t getIslandCount() const { return static_cast<uint32_t>(m_islandOffsets.empty() ? 0 : m_islandOffsets.size() - 1); }
+
+private:
+	// Islands per thread pool chunk
+	constexpr static uint32_t IslandChunkSize = 1;
+
+	Settings m_settings;
+
+	// Contacts of the last step, sorted by key
+	struct CachedContact {
+		ContactKey Key;
+		ContactManifold Manifold;
+	};
+	std::vector<CachedContact> m_cachedContacts;
+
+	// Step data of every contact point (contact index * MaxPoints + point index)
+	struct PointConstraint {
+		glm::vec2 RA; // From the center of mass of A to the contact
+		glm::vec2 RB;
+		float NormalMass;
+		float TangentMass;
+		float VelocityBias;
+	};
+	std::vector<PointConstraint> m_pointConstraints;
+
+	// Islands, the contacts of island i are m_islandContacts[m_islandOffsets[i], m_islandOffsets[i + 1])
+	std::vector<uint32_t> m_islandParents; // Union find over the bodies
+	std::vector<uint32_t> m_islandOfRoot;
+	std::vector<uint32_t> m_islandOffsets;
+	std::vector<uint32_t> m_islandContacts;
+
+	void warmStartFromCache(std::vector<BodyContact>& contacts) const;
+	void buildIslands(const RigidBodyData& bodies, const std::vector<BodyContact>& contacts);
+	uint32_t findIslandRoot(uint32_t body);
+	void solveIsland(RigidBodyData& bodies, std::vector<BodyContact>& contacts, std::span<const uint32_t> islandContacts, float deltaTime);
+	void cacheContacts(const std::vector<BodyContact>& contacts);
+};
+
+} // TileBite
+
+#endif // !CONTACT_SOLVER_HPP
@@ -0,0 +1,414 @@
+#include "physics/GJK.hpp"
+
+#include "physics/Collider.hpp"
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+ConvexShape::ConvexShape(const AABB& aabb)
+	: Count(4), Radius(0.0f)
+{
+	auto corners = aabb.getCorners();
+	std::copy(corners.begin(), corners.end(), Vertices.begin());
+}
+
+ConvexShape::ConvexShape(const OBB& obb)
+	: Count(4), Radius(0.0f)
+{
+	auto corners = obb.getCorners();
+	std::copy(corners.begin(), corners.end(), Vertices.begin());
+}
+
+ConvexShape::ConvexShape(const Circle& circle)
+	: Count(1), Radius(circle.Radius)
+{
+	Vertices[0] = circle.Center;
+}
+
+ConvexShape::ConvexShape(const Polygon& polygon)
+	: Vertices(polygon.Vertices), Count(polygon.Count), Radius(0.0f)
+{}
+
+ConvexShape::ConvexShape(const Capsule& capsule)
+	: Count(2), Radius(capsule.Radius)
+{
+	Vertices[0] = capsule.PointA;
+	Vertices[1] = capsule.PointB;
+}
+
+ConvexShape::ConvexShape(const Collider& collider)
+	: Count(0), Radius(0.0f)
+{
+	switch (collider.Type) {
+	case Collider::ColliderType::AABB:    *this = ConvexShape(collider.AABBCollider); break;
+	case Collider::ColliderType::OBB:     *this = ConvexShape(collider.OBBCollider); break;
+	case Collider::ColliderType::Circle:  *this = ConvexShape(collider.CircleCollider); break;
+	case Collider::ColliderType::Polygon: *this = ConvexShape(collider.PolygonCollider); break;
+	case Collider::ColliderType::Capsule: *this = ConvexShape(collider.CapsuleCollider); break;
+	default: ASSERT_FALSE("Unknown collider type");
+	}
+}
+
+ConvexShape ConvexShape::translated(glm::vec2 offset) const
+{
+	ConvexShape result = *this;
+	for (uint32_t i = 0; i < Count; i++)
+		result.Vertices[i] += offset;
+	return result;
+}
+
+namespace CollisionUtilities {
+
+namespace {
+
+constexpr uint32_t MaxGJKIterations = 20;
+constexpr uint32_t MaxEPAIterations = 32;
+constexpr float EPATolerance = 1e-4f; // Relative to the depth
+
+inline float cross(glm::vec2 a, glm::vec2 b) { return a.x * b.y - a.y * b.x; }
+
+// Point of the Minkowski difference b - a made of the support points of both shapes
+struct SimplexVertex {
+	glm::vec2 WA;
+	glm::vec2 WB;
+	glm::vec2 W; // WB - WA
+	float Weight; // Barycentric coordinate of the closest point to the origin
+	uint32_t IndexA;
+	uint32_t IndexB;
+};
+
+inline SimplexVertex makeVertex(const ConvexShape& a, const ConvexShape& b, uint32_t indexA, uint32_t indexB)
+{
+	SimplexVertex vertex;
+	vertex.IndexA = indexA;
+	vertex.IndexB = indexB;
+	vertex.WA = a.Vertices[indexA];
+	vertex.WB = b.Vertices[indexB];
+	vertex.W = vertex.WB - vertex.WA;
+	vertex.Weight = 1.0f;
+	return vertex;
+}
+
+// Support point of the Minkowski difference along direction
+inline SimplexVertex getSupport(const ConvexShape& a, const ConvexShape& b, glm::vec2 direction)
+{
+	return makeVertex(a, b, a.getSupportIndex(-direction), b.getSupportIndex(direction));
+}
+
+struct Simplex {
+	SimplexVertex V[3];
+	uint32_t Count = 0;
+
+	// Closest point of the segment to the origin, keeps the vertices of the closest feature
+	void solve2()
+	{
+		glm::vec2 w1 = V[0].W, w2 = V[1].W;
+		glm::vec2 e12 = w2 - w1;
+
+		float d12_2 = -glm::dot(w1, e12);
+		if (d12_2 <= 0.0f)
+		{
+			V[0].Weight = 1.0f;
+			Count = 1;
+			return;
+		}
+
+		float d12_1 = glm::dot(w2, e12);
+		if (d12_1 <= 0.0f)
+		{
+			V[1].Weight = 1.0f;
+			V[0] = V[1];
+			Count = 1;
+			return;
+		}
+
+		float inverse = 1.0f / (d12_1 + d12_2);
+		V[0].Weight = d12_1 * inverse;
+		V[1].Weight = d12_2 * inverse;
+		Count = 2;
+	}
+
+	// Closest point of the triangle to the origin through its Voronoi regions
+	void solve3()
+	{
+		glm::vec2 w1 = V[0].W, w2 = V[1].W, w3 = V[2].W;
+
+		glm::vec2 e12 = w2 - w1;
+		float d12_1 = glm::dot(w2, e12);
+		float d12_2 = -glm::dot(w1, e12);
+
+		glm::vec2 e13 = w3 - w1;
+		float d13_1 = glm::dot(w3, e13);
+		float d13_2 = -glm::dot(w1, e13);
+
+		glm::vec2 e23 = w3 - w2;
+		float d23_1 = glm::dot(w3, e23);
+		float d23_2 = -glm::dot(w2, e23);
+
+		float n123 = cross(e12, e13);
+		float d123_1 = n123 * cross(w2, w3);
+		float d123_2 = n123 * cross(w3, w1);
+		float d123_3 = n123 * cross(w1, w2);
+
+		if (d12_2 <= 0.0f && d13_2 <= 0.0f)
+		{
+			V[0].Weight = 1.0f;
+			Count = 1;
+			return;
+		}
+
+		if (d12_1 > 0.0f && d12_2 > 0.0f && d123_3 <= 0.0f)
+		{
+			float inverse = 1.0f / (d12_1 + d12_2);
+			V[0].Weight = d12_1 * inverse;
+			V[1].Weight = d12_2 * inverse;
+			Count = 2;
+			return;
+		}
+
+		if (d13_1 > 0.0f && d13_2 > 0.0f && d123_2 <= 0.0f)
+		{
+			float inverse = 1.0f / (d13_1 + d13_2);
+			V[0].Weight = d13_1 * inverse;
+			V[2].Weight = d13_2 * inverse;
+			V[1] = V[2];
+			Count = 2;
+			return;
+		}
+
+		if (d12_1 <= 0.0f && d23_2 <= 0.0f)
+		{
+			V[1].Weight = 1.0f;
+			V[0] = V[1];
+			Count = 1;
+			return;
+		}
+
+		if (d13_1 <= 0.0f && d23_1 <= 0.0f)
+		{
+			V[2].Weight = 1.0f;
+			V[0] = V[2];
+			Count = 1;
+			return;
+		}
+
+		if (d23_1 > 0.0f && d23_2 > 0.0f && d123_1 <= 0.0f)
+		{
+			float inverse = 1.0f / (d23_1 + d23_2);
+			V[1].Weight = d23_1 * inverse;
+			V[2].Weight = d23_2 * inverse;
+			V[0] = V[2];
+			Count = 2;
+			return;
+		}
+
+		// Origin inside the triangle
+		float inverse = 1.0f / (d123_1 + d123_2 + d123_3);
+		V[0].Weight = d123_1 * inverse;
+		V[1].Weight = d123_2 * inverse;
+		V[2].Weight = d123_3 * inverse;
+		Count = 3;
+	}
+
+	// Towards the origin from the closest feature
+	glm::vec2 getSearchDirection() const
+	{
+		if (Count == 1) return -V[0].W;
+
+		glm::vec2 e12 = V[1].W - V[0].W;
+		if (cross(e12, -V[0].W) > 0.0f) return glm::vec2(-e12.y, e12.x); // Origin left of e12
+		return glm::vec2(e12.y, -e12.x);
+	}
+
+	void getWitnessPoints(glm::vec2& pointA, glm::vec2& pointB) const
+	{
+		pointA = glm::vec2(0.0f);
+		pointB = glm::vec2(0.0f);
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			pointA += V[i].Weight * V[i].WA;
+			pointB += V[i].Weight * V[i].WB;
+		}
+		if (Count == 3) pointB = pointA;
+	}
+};
+
+// Runs GJK until the simplex holds the closest feature of the Minkowski difference to the origin,
+// or encloses the origin (Count == 3)
+uint32_t runGJK(const ConvexShape& a, const ConvexShape& b, Simplex& simplex)
+{
+	ASSERT(a.Count > 0 && b.Count > 0, "GJK needs shapes with vertices");
+
+	simplex.V[0] = makeVertex(a, b, 0, 0);
+	simplex.Count = 1;
+
+	uint32_t iterations = 0;
+	while (iterations < MaxGJKIterations)
+	{
+		// Support points already in the simplex mean no more progress can be made
+		uint32_t savedIndicesA[3], savedIndicesB[3];
+		uint32_t savedCount = simplex.Count;
+		for (uint32_t i = 0; i < savedCount; i++)
+		{
+			savedIndicesA[i] = simplex.V[i].IndexA;
+			savedIndicesB[i] = simplex.V[i].IndexB;
+		}
+
+		if (simplex.Count == 2) simplex.solve2();
+		else if (simplex.Count == 3) simplex.solve3();
+		if (simplex.Count == 3) break;
+
+		glm::vec2 direction = simplex.getSearchDirection();
+		if (glm::dot(direction, direction) < FLT_EPSILON * FLT_EPSILON) break; // Origin on the simplex
+
+		SimplexVertex vertex = getSupport(a, b, direction);
+		iterations++;
+
+		bool duplicate = false;
+		for (uint32_t i = 0; i < savedCount; i++)
+		{
+			if (vertex.IndexA == savedIndicesA[i] && vertex.IndexB == savedIndicesB[i])
+			{
+				duplicate = true;
+				break;
+			}
+		}
+		if (duplicate) break;
+
+		simplex.V[simplex.Count++] = vertex;
+	}
+
+	// Out of iterations, the last support point still has to be solved for
+	if (iterations == MaxGJKIterations)
+	{
+		if (simplex.Count == 2) simplex.solve2();
+		else if (simplex.Count == 3) simplex.solve3();
+	}
+
+	return iterations;
+}
+
+} // namespace
+
+DistanceOutput gjkDistance(const ConvexShape& a, const ConvexShape& b)
+{
+	Simplex simplex;
+	DistanceOutput output;
+	output.Iterations = runGJK(a, b, simplex);
+	simplex.getWitnessPoints(output.PointA, output.PointB);
+	output.Distance = (simplex.Count == 3) ? 0.0f : glm::length(output.PointB - output.PointA);
+	return output;
+}
+
+bool gjkIntersects(const ConvexShape& a, const ConvexShape& b)
+{
+	return gjkDistance(a, b).Distance <= a.Radius + b.Radius;
+}
+
+bool epaPenetration(const ConvexShape& a, const ConvexShape& b, PenetrationOutput& output)
+{
+	Simplex simplex;
+	runGJK(a, b, simplex);
+
+	glm::vec2 pointA, pointB;
+	simplex.getWitnessPoints(pointA, pointB);
+	if (simplex.Count < 3 && glm::length(pointB - pointA) > CoreContactTolerance) return false;
+
+	std::array<SimplexVertex, 3 + MaxEPAIterations> polytope;
+	uint32_t count = simplex.Count;
+	std::copy_n(simplex.V, count, polytope.begin());
+
+	// Cores touching on a point or edge leave a smaller simplex, it's grown into a triangle with
+	// the origin on its boundary
+	auto tryAdd = [&](glm::vec2 direction) {
+		SimplexVertex vertex = getSupport(a, b, direction);
+		for (uint32_t i = 0; i < count; i++)
+			if (glm::dot(vertex.W - polytope[i].W, vertex.W - polytope[i].W) < FLT_EPSILON) return;
+		if (count == 2 && std::abs(cross(polytope[1].W - polytope[0].W, vertex.W - polytope[0].W)) < FLT_EPSILON) return;
+		polytope[count++] = vertex;
+	};
+	const glm::vec2 Axes[4] = { { 1.0f, 0.0f }, { -1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, -1.0f } };
+	for (uint32_t i = 0; i < 4 && count < 2; i++)
+		tryAdd(Axes[i]);
+	if (count == 2)
+	{
+		glm::vec2 edge = polytope[1].W - polytope[0].W;
+		tryAdd(glm::vec2(-edge.y, edge.x));
+		if (count == 2) tryAdd(glm::vec2(edge.y, -edge.x));
+	}
+	if (count < 3) return false;
+
+	// Counter clockwise, edge normals (e.y, -e.x) point out of the polytope
+	float area = cross(polytope[1].W - polytope[0].W, polytope[2].W - polytope[0].W);
+	if (std::abs(area) < FLT_EPSILON) return false;
+	if (area < 0.0f) std::swap(polytope[0], polytope[1]);
+
+	uint32_t closestEdge = 0;
+	glm::vec2 normal(0.0f);
+	float distance = 0.0f;
+	for (uint32_t iteration = 0; ; iteration++)
+	{
+		distance = std::numeric_limits<float>::infinity();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			glm::vec2 edge = polytope[(i + 1) % count].W - polytope[i].W;
+			float length = glm::length(edge);
+			if (length < FLT_EPSILON) continue;
+
+			glm::vec2 edgeNormal = glm::vec2(edge.y, -edge.x) / length;
+			float edgeDistance = glm::dot(edgeNormal, polytope[i].W);
+			if (edgeDistance < distance)
+			{
+				distance = edgeDistance;
+				normal = edgeNormal;
+				closestEdge = i;
+			}
+		}
+		if (distance == std::numeric_limits<float>::infinity()) return false;
+
+		if (iteration == MaxEPAIterations || count == polytope.size()) break;
+
+		// Done once the Minkowski difference doesn't reach further than the closest edge
+		SimplexVertex vertex = getSupport(a, b, normal);
+		if (glm::dot(vertex.W, normal) - distance <= EPATolerance * std::max(1.0f, distance)) break;
+
+		uint32_t insertAt = closestEdge + 1;
+		std::copy_backward(polytope.begin() + insertAt, polytope.begin() + count, polytope.begin() + count + 1);
+		polytope[insertAt] = vertex;
+		count++;
+
+		// The GJK simplex can start from points inside the Minkowski difference, the new vertex may then
+		// see more than the closest edge. Neighbours it makes concave are dropped to keep the polytope convex,
+		// it only grows so the origin stays inside.
+		auto isConcave = [&](uint32_t i) {
+			const glm::vec2& previous = polytope[(i + count - 1) % count].W;
+			const glm::vec2& next = polytope[(i + 1) % count].W;
+			return cross(polytope[i].W - previous, next - polytope[i].W) <= 0.0f;
+		};
+		auto eraseIfConcave = [&](uint32_t i) {
+			if (count <= 3 || !isConcave(i)) return false;
+			std::copy(polytope.begin() + i + 1, polytope.begin() + count, polytope.begin() + i);
+			count--;
+			if (i < insertAt) insertAt--;
+			return true;
+		};
+		while (eraseIfConcave((insertAt + 1) % count));
+		while (eraseIfConcave((insertAt + count - 1) % count));
+	}
+
+	// Deepest points from the projection of the origin on the closest edge
+	const SimplexVertex& start = polytope[closestEdge];
+	const SimplexVertex& end = polytope[(closestEdge + 1) % count];
+	glm::vec2 edge = end.W - start.W;
+	float t = std::clamp(-glm::dot(start.W, edge) / glm::dot(edge, edge), 0.0f, 1.0f);
+
+	// The origin leaves the Minkowski difference b - a through the closest edge when b moves against its normal
+	output.Normal = -normal;
+	output.Depth = std::max(distance, 0.0f) + a.Radius + b.Radius;
+	output.PointA = start.WA + t * (end.WA - start.WA);
+	output.PointB = start.WB + t * (end.WB - start.WB);
+	return true;
+}
+
+} // CollisionUtilities
+} // TileBite
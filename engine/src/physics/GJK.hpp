@@ -0,0 +1,87 @@
+#ifndef GJK_HPP
+#define GJK_HPP
+
+#include "core/pch.hpp"
+#include <glm/glm.hpp>
+
+#include "physics/AABB.hpp"
+#include "physics/OBB.hpp"
+#include "physics/Circle.hpp"
+#include "physics/Polygon.hpp"
+#include "physics/Capsule.hpp"
+
+namespace TileBite {
+
+struct Collider;
+
+// A shape seen through its support function: the convex hull of Count vertices (the core) grown by Radius.
+// A circle is a single vertex and a capsule a segment, so every collider type maps to one of these and
+// GJK / EPA work on any pair of them without a test per pair of types.
+struct ConvexShape {
+	std::array<glm::vec2, Polygon::MaxVertices> Vertices;
+	uint32_t Count;
+	float Radius;
+
+	explicit ConvexShape(const AABB& aabb);
+	explicit ConvexShape(const OBB& obb);
+	explicit ConvexShape(const Circle& circle);
+	explicit ConvexShape(const Polygon& polygon);
+	explicit ConvexShape(const Capsule& capsule);
+	explicit ConvexShape(const Collider& collider);
+
+	// Index of the core vertex furthest along direction
+	inline uint32_t getSupportIndex(glm::vec2 direction) const
+	{
+		uint32_t bestIndex = 0;
+		float bestProjection = glm::dot(Vertices[0], direction);
+		for (uint32_t i = 1; i < Count; i++)
+		{
+			float projection = glm::dot(Vertices[i], direction);
+			if (projection > bestProjection)
+			{
+				bestIndex = i;
+				bestProjection = projection;
+			}
+		}
+		return bestIndex;
+	}
+
+	ConvexShape translated(glm::vec2 offset) const;
+};
+
+namespace CollisionUtilities {
+
+// Cores closer than this are treated as overlapping, their closest points are too close to give a direction
+constexpr float CoreContactTolerance = 1e-4f;
+
+// Closest points of the cores of a and b (radii left out), Distance is 0 when the cores overlap.
+struct DistanceOutput {
+	glm::vec2 PointA;
+	glm::vec2 PointB;
+	float Distance;
+	uint32_t Iterations;
+};
+
+// Penetration of a and b (radii included). Normal is the unit direction that moves b out of a, by Depth.
+// PointA and PointB are the deepest points of each core.
+struct PenetrationOutput {
+	glm::vec2 Normal;
+	float Depth;
+	glm::vec2 PointA;
+	glm::vec2 PointB;
+};
+
+// GJK on the Minkowski difference of the cores (https://box2d.org/files/ErinCatto_GJK_GDC2010.pdf)
+DistanceOutput gjkDistance(const ConvexShape& a, const ConvexShape& b);
+
+// True if the shapes touch, radii included
+bool gjkIntersects(const ConvexShape& a, const ConvexShape& b);
+
+// EPA for shapes whose cores overlap, expands the GJK simplex towards the closest edge of the Minkowski difference.
+// False if the cores are further than CoreContactTolerance apart or too degenerate to enclose the origin (eg: two collinear segments).
+bool epaPenetration(const ConvexShape& a, const ConvexShape& b, PenetrationOutput& output);
+
+} // CollisionUtilities
+} // TileBite
+
+#endif // !GJK_HPP
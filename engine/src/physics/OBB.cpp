@@ -3,13 +3,15 @@
 #include "physics/AABB.hpp"
 #include "physics/Collider.hpp"
 #include "physics/CollisionUtilities.hpp"
+#include "physics/GJK.hpp"
+#include "utilities/DeterministicMath.hpp"
 
 namespace TileBite {
 
 OBB OBB::toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) const {
     // TODO: rotation utility math func
-    float c = cos(radians);
-    float s = sin(radians);
+    float c = simCos(radians);
+    float s = simSin(radians);
 
     glm::vec2 localCenter = Center * size;
     glm::vec2 rotatedCenter(
@@ -31,8 +33,8 @@ std::array<glm::vec2, 4> OBB::getCorners() const
     glm::vec2 half = Size * 0.5f;
 
     // Precompute rotation matrix components
-    float cosR = cos(Rotation);
-    float sinR = sin(Rotation);
+    float cosR = simCos(Rotation);
+    float sinR = simSin(Rotation);
 
     // Local-space corners relative to center (CCW order)
     std::array<glm::vec2, 4> corners = {
@@ -85,4 +87,14 @@ bool OBB::intersects(const OBB& other) const
     return CollisionUtilities::SATTest(getCorners(), other.getCorners());
 }
 
+bool OBB::intersects(const Polygon& other) const
+{
+    return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool OBB::intersects(const Capsule& other) const
+{
+    return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
 } // TileBite
\ No newline at end of file
@@ -10,6 +10,8 @@ namespace TileBite {
 struct AABB; // Forward declaration to avoid circular dependency
 struct Collider;
 struct Circle;
+struct Polygon;
+struct Capsule;
 
 struct OBB {
 	glm::vec2 Center; // Center of the OBB
@@ -37,6 +39,8 @@ struct OBB {
     bool intersects(const Collider& other) const;
     bool intersects(const OBB& other) const;
     bool intersects(const Circle& other) const;
+    bool intersects(const Polygon& other) const;
+    bool intersects(const Capsule& other) const;
 
     std::array<glm::vec2, 4> getCorners() const;
 
@@ -3,49 +3,120 @@
 
 namespace TileBite {
 
-std::vector<RayHitData> PhysicsEngine::raycastAll(const Ray2D& ray, ID excludeID) const
+PhysicsEngine::PhysicsEngine()
 {
-	auto rayHits = m_coreTree.raycastAll(ray, excludeID);
-	auto tilemapHits = m_tilemapColliderTree.raycastAll(ray, excludeID);
+	m_coreTree.setRebuildThreshold(CoreTreeRebuildCostRatio, CoreTreeRebuildCheckInterval);
+}
+
+void PhysicsEngine::setBroadphase(BroadphaseType type, float cellSize)
+{
+	m_hashGrid.setCellSize(cellSize);
+	if (type == m_broadphaseType) return;
 
-	rayHits.reserve(rayHits.size() + tilemapHits.size());
-	for (const RayHitData& tilemapHit : tilemapHits)
+	std::vector<ColliderInfo> colliders = withBroadphase([](const auto& broadphase) { return broadphase.getColliderInfos(); });
+	if (type == BroadphaseType::SpatialHashGrid)
 	{
-		auto it = m_tilemapColliderGroups.find(tilemapHit.Generic.id);
-		ASSERT(it != m_tilemapColliderGroups.end(), "Tilemap collider group not found in the map");
-		const TilemapColliderGroup& group = it->second;
-		auto groupRayHits = group.raycastAll(ray);
-		rayHits.insert(rayHits.end(), groupRayHits.begin(), groupRayHits.end());
+		for (const ColliderInfo& info : colliders)
+		{
+			m_hashGrid.insert(info);
+			m_coreTree.remove(info.id);
+		}
+	}
+	else
+	{
+		for (const ColliderInfo& info : colliders)
+			m_coreTree.insert(info);
+		m_hashGrid.clear();
 	}
 
+	// The tree reports every collider as moved the next time it computes pairs
+	m_coreTree.setMoveTracking(false);
+	m_proxyPairs.clear();
+	m_broadphaseType = type;
+}
+
+std::vector<RayHitData> PhysicsEngine::raycastAll(const Ray2D& ray, const QueryFilter& filter) const
+{
+	PHYSICS_PROFILE_ADD(Raycasts, 1);
+	PHYSICS_PROFILE_SCOPE(Raycasts);
+	auto rayHits = withBroadphase([&](const auto& broadphase) { return broadphase.raycastAll(ray, filter); });
+	m_staticTree.raycastAll(ray, filter, [&](const ColliderInfo& info, float tmin, float tmax) {
+		rayHits.push_back(RayHitData(GenericCollisionData(info.id, info), tmin, tmax));
+		return true;
+	});
+
+	m_tilemapColliderTree.raycast(ray, [&](const ColliderInfo& tilemapInfo, float, float) {
+		if (!filter.accepts(tilemapInfo.id, tilemapInfo.Filter.CategoryBits)) return true;
+
+		const TilemapColliderGroup& group = getTilemapColliderGroup(tilemapInfo.id);
+		group.raycast(ray, [&](const RayHit& hit) {
+			rayHits.push_back(RayHitData(group.toCollisionData(hit), hit.tmin, hit.tmax));
+			return true;
+		});
+		return true;
+	});
+
 	return rayHits;
 }
 
-std::optional<RayHitData> PhysicsEngine::raycastClosest(const Ray2D& ray, ID excludeID) const
+void PhysicsEngine::raycastAll(const Ray2D& ray, const QueryFilter& filter, std::vector<RayHit>& results) const
+{
+	raycastAll(ray, filter, [&](const RayHit& hit) {
+		results.push_back(hit);
+		return true;
+	});
+}
+
+void PhysicsEngine::queryPoint(glm::vec2 point, const QueryFilter& filter, std::vector<CollisionHit>& results) const
 {
-	auto rayHit = m_coreTree.raycastClosest(ray, excludeID);
+	queryPoint(point, filter, [&](const CollisionHit& hit) {
+		results.push_back(hit);
+		return true;
+	});
+}
+
+void PhysicsEngine::nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const
+{
+	PHYSICS_PROFILE_ADD(Queries, 1);
+	PHYSICS_PROFILE_SCOPE(Queries);
+	withBroadphase([&](const auto& broadphase) { broadphase.nearest(k, point, maxDistance, filter, results); });
+
+	// Static colliders closer than the k-th moving one replace the furthest ones
+	m_staticTree.mergeNearest(k, point, maxDistance, filter, results);
+}
 
-	// For tilemaps we iterate all intersectins chunks with the ray and find the cloest one that has
-	// a intersected internal tile. This can be improved if we somehow use raycastClosest more efficiently.
+std::vector<NearestHit> PhysicsEngine::nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter) const
+{
+	std::vector<NearestHit> results;
+	nearest(k, point, maxDistance, filter, results);
+	return results;
+}
+
+std::optional<RayHitData> PhysicsEngine::raycastClosest(const Ray2D& ray, const QueryFilter& filter) const
+{
+	PHYSICS_PROFILE_ADD(Raycasts, 1);
+	PHYSICS_PROFILE_SCOPE(Raycasts);
+	auto rayHit = withBroadphase([&](const auto& broadphase) { return broadphase.raycastClosest(ray, filter); });
+	auto staticHit = m_staticTree.raycastClosest(ray, filter);
+	if (staticHit.has_value() && (!rayHit.has_value() || staticHit->tmin < rayHit->tmin))
+		rayHit = staticHit;
+
+	// Tilemaps are visited closest first. A tilemap whose bounds are entered after the closest
+	// tile hit found so far can not contain a closer tile, so it is skipped.
 	std::optional<RayHitData> closestTileHit;
 	float tmin = std::numeric_limits<float>::max();
-	auto tilemapHits = m_tilemapColliderTree.raycastAll(ray);
-
-	for (const auto& hit : tilemapHits)
-	{
-		auto it = m_tilemapColliderGroups.find(hit.Generic.id);
-		ASSERT(it != m_tilemapColliderGroups.end(), "Tilemap collider group not found in the map");
-		const TilemapColliderGroup& group = it->second;
 
-		auto groupRayHit = group.raycastClosest(ray);
-		if (!groupRayHit.has_value()) continue;
+	m_tilemapColliderTree.raycast(ray, [&](const ColliderInfo& tilemapInfo, float boundsTmin, float) {
+		if (boundsTmin > tmin || !filter.accepts(tilemapInfo.id, tilemapInfo.Filter.CategoryBits)) return true;
 
-		if (groupRayHit->tmin < tmin)
+		auto groupRayHit = getTilemapColliderGroup(tilemapInfo.id).raycastClosest(ray);
+		if (groupRayHit.has_value() && groupRayHit->tmin < tmin)
 		{
 			closestTileHit = groupRayHit;
 			tmin = groupRayHit->tmin;
 		}
-	}
+		return true;
+	});
 
 	if (rayHit.has_value() && closestTileHit.has_value())
 		return (rayHit->tmin < closestTileHit->tmin) ? rayHit : closestTileHit;
@@ -53,27 +124,341 @@ std::optional<RayHitData> PhysicsEngine::raycastClosest(const Ray2D& ray, ID exc
 		return rayHit.has_value() ? rayHit : closestTileHit;
 }
 
+std::optional<ShapeCastHit> PhysicsEngine::shapeCast(const Collider& shape, glm::vec2 displacement, const QueryFilter& filter) const
+{
+	PHYSICS_PROFILE_ADD(Queries, 1);
+	PHYSICS_PROFILE_SCOPE(Queries);
+	std::optional<ShapeCastHit> closestHit;
+	float bestToi = 1.0f;
+	AABB bounds = shape.getAABBBounds();
+
+	// The trees skip colliders whose bounds are reached after the closest hit found so far
+	forEachColliderStructure([&](const auto& colliders) {
+		colliders.sweep(bounds, displacement, filter, [&](const ColliderInfo& info) {
+			float toi;
+			glm::vec2 normal;
+			if (CollisionUtilities::sweep(shape, displacement, info, toi, normal) &&
+				(toi < bestToi || (!closestHit && toi <= bestToi)))
+			{
+				bestToi = toi;
+				closestHit = ShapeCastHit(CollisionHit(info.id), toi, normal);
+			}
+			return bestToi;
+		});
+	});
+
+	AABB sweptBounds = AABB::getUnion(bounds, AABB(bounds.Min + displacement, bounds.Max + displacement));
+	forEachTilemapGroup(sweptBounds, filter, [&](const TilemapColliderGroup& group) {
+		auto tileHit = group.shapeCast(shape, displacement, bestToi);
+		if (tileHit.has_value() && (!closestHit || tileHit->toi < bestToi))
+		{
+			bestToi = tileHit->toi;
+			closestHit = tileHit;
+		}
+		return true;
+	});
+
+	return closestHit;
+}
+
+void PhysicsEngine::raycastBatch(std::span<const Ray2D> rays, std::span<std::optional<RayHitData>> results, ThreadPool& threadPool, const QueryFilter& filter) const
+{
+	ASSERT(rays.size() == results.size(), "raycastBatch needs one result per ray");
+
+	threadPool.parallelFor(static_cast<uint32_t>(rays.size()), RaycastBatchChunkSize, [&](uint32_t begin, uint32_t end) {
+		for (uint32_t i = begin; i < end; i++)
+			results[i] = raycastClosest(rays[i], filter);
+	});
+}
+
+void PhysicsEngine::raycastTilemapsFirstHit(std::span<const Ray2D> rays, std::span<float> hitDistances, const QueryFilter& filter) const
+{
+	PHYSICS_PROFILE_ADD(Raycasts, rays.size());
+	PHYSICS_PROFILE_SCOPE(Raycasts);
+	ASSERT(rays.size() == hitDistances.size(), "raycastTilemapsFirstHit needs one distance per ray");
+
+	// Every group lowers the distances of the rays that hit it, rays missing a group skip it in its setup
+	std::fill(hitDistances.begin(), hitDistances.end(), TilemapColliderGroup::NoHit);
+	for (const auto& [id, group] : m_tilemapColliderGroups)
+	{
+		if (!filter.accepts(id, group.getFilter().CategoryBits)) continue;
+		group.raycastFirstHits(rays, hitDistances);
+	}
+}
+
+const TilemapColliderGroup& PhysicsEngine::getTilemapColliderGroup(ID id) const
+{
+	auto it = m_tilemapColliderGroups.find(id);
+	ASSERT(it != m_tilemapColliderGroups.end(), "Tilemap collider group not found in the map");
+	return it->second;
+}
+
+const ColliderInfo* PhysicsEngine::getCollider(ID id) const
+{
+	const ColliderInfo* collider = withBroadphase([&](const auto& broadphase) { return broadphase.getCollider(id); });
+	return collider ? collider : m_staticTree.getCollider(id);
+}
+
+const std::vector<Collider> PhysicsEngine::getCoreTreeColliders() const
+{
+	std::vector<Collider> colliders = withBroadphase([](const auto& broadphase) { return broadphase.getLeafColliders(); });
+	std::vector<Collider> staticColliders = m_staticTree.getLeafColliders();
+	colliders.insert(colliders.end(), staticColliders.begin(), staticColliders.end());
+	return colliders;
+}
+
+void PhysicsEngine::buildColliders(std::span<const ColliderInfo> colliders, std::span<const ColliderInfo> staticColliders, ThreadPool* threadPool)
+{
+	m_isBuilt = true;
+	m_staticTree.build(staticColliders, threadPool);
+
+	if (m_broadphaseType == BroadphaseType::SpatialHashGrid)
+	{
+		m_hashGrid.clear();
+		for (const ColliderInfo& info : colliders)
+			m_hashGrid.insert(info);
+		return;
+	}
+
+	m_coreTree.build(colliders, threadPool);
+}
+
+uint32_t PhysicsEngine::getColliderCount() const
+{
+	return withBroadphase([](const auto& broadphase) { return broadphase.size(); }) + m_staticTree.size();
+}
+
 void PhysicsEngine::removeCollider(ID id)
 {
-	m_coreTree.remove(id);
+	if (m_tilemapColliderGroups.erase(id) > 0)
+	{
+		rebuildTilemapColliderTree();
+		return;
+	}
+
+	if (!m_staticTree.remove(id))
+		withBroadphase([&](auto& broadphase) { broadphase.remove(id); });
 }
 
-void PhysicsEngine::updateTilemapColliderGroup(ID id, TransformComponent* transform, glm::vec2 tilemapSize, glm::vec2 tileSize, Bitset solidTiles)
+const std::vector<CollisionPair>& PhysicsEngine::computePairs()
 {
-	glm::vec2 min = transform->getPosition();
-	glm::vec2 max = glm::vec2(tilemapSize.x * tileSize.x, tilemapSize.y * tileSize.y) * transform->getSize() + transform->getPosition();
-	auto bounds = AABB(min, max);
-	ColliderInfo info(id, bounds);
-	bool updated = m_tilemapColliderTree.update(info);
-	if (!updated)
+	PHYSICS_PROFILE_SCOPE(Pairs);
+
+	// Static colliders only pair with moving ones, their moves are tracked to find their pairs again
+	if (!m_staticTree.isTrackingMoves())
+		m_staticTree.setMoveTracking(true);
+
+	m_movedStaticIDs.assign(m_staticTree.getMovedIDs().begin(), m_staticTree.getMovedIDs().end());
+	m_staticTree.clearMovedIDs();
+
+	if (m_broadphaseType == BroadphaseType::SpatialHashGrid)
 	{
-		m_tilemapColliderTree.insert(info);
-		m_tilemapColliderGroups.emplace(id, TilemapColliderGroup(id, bounds, tilemapSize, tileSize, solidTiles));
+		m_hashGrid.computePairs(m_collisionPairs);
+
+		// The grid finds every pair again, each of its colliders looks for the static ones it overlaps
+		for (const ColliderInfo& info : m_hashGrid.getColliderInfos())
+		{
+			m_staticTree.query(static_cast<const Collider&>(info), QueryFilter(info.id, info.Filter.MaskBits), [&](const ColliderInfo& other) {
+				if (other.Filter.accepts(info.Filter.CategoryBits))
+					m_collisionPairs.push_back(CollisionPair{ std::min(info.id, other.id), std::max(info.id, other.id) });
+				return true;
+			});
+		}
+		return m_collisionPairs;
 	}
-	else
+
+	// First call, every collider is reported as moved
+	if (!m_coreTree.isTrackingMoves())
+		m_coreTree.setMoveTracking(true);
+
+	// Moved IDs of both trees are kept sorted for lookups
+	m_movedIDs.assign(m_coreTree.getMovedIDs().begin(), m_coreTree.getMovedIDs().end());
+	m_movedIDs.insert(m_movedIDs.end(), m_movedStaticIDs.begin(), m_movedStaticIDs.end());
+	std::sort(m_movedIDs.begin(), m_movedIDs.end());
+	m_movedIDs.erase(std::unique(m_movedIDs.begin(), m_movedIDs.end()), m_movedIDs.end());
+	m_coreTree.clearMovedIDs();
+
+	auto isMoved = [this](ID id) {
+		return std::binary_search(m_movedIDs.begin(), m_movedIDs.end(), id);
+	};
+
+	// Pairs of moved (or removed) colliders are found again below
+	std::erase_if(m_proxyPairs, [&](const CollisionPair& pair) {
+		return isMoved(pair.idA) || isMoved(pair.idB);
+	});
+
+	for (ID movedID : m_movedIDs)
 	{
-		m_tilemapColliderGroups[id] = TilemapColliderGroup(id, bounds, tilemapSize, tileSize, solidTiles);
+		const ColliderInfo* moved = m_coreTree.getCollider(movedID);
+		bool isStatic = moved == nullptr;
+		const AABB* fatBounds = nullptr;
+		if (!isStatic)
+			fatBounds = &m_coreTree.getFatBounds(movedID);
+		else if ((moved = m_staticTree.getCollider(movedID)) != nullptr)
+			fatBounds = &m_staticTree.getFatBounds(movedID);
+		else
+			continue; // Removed
+
+		// Only colliders in the mask of the moved one are visited, the other direction is checked per pair
+		const CollisionFilter& movedFilter = moved->Filter;
+		auto addPair = [&](const ColliderInfo& other) {
+			// When both colliders moved the pair is added by the one with the smaller ID
+			if (other.id == movedID || (other.id < movedID && isMoved(other.id)) || !other.Filter.accepts(movedFilter.CategoryBits))
+				return true;
+
+			m_proxyPairs.push_back(CollisionPair{ std::min(movedID, other.id), std::max(movedID, other.id) });
+			return true;
+		};
+
+		m_coreTree.queryFatBounds(*fatBounds, movedFilter.MaskBits, addPair);
+		if (!isStatic)
+			m_staticTree.queryFatBounds(*fatBounds, movedFilter.MaskBits, addPair);
 	}
+
+	// Colliders may move inside their fat bounds so the narrow phase runs on every pair
+	m_collisionPairs.clear();
+	for (const CollisionPair& pair : m_proxyPairs)
+	{
+		const ColliderInfo* a = getCollider(pair.idA);
+		const ColliderInfo* b = getCollider(pair.idB);
+		ASSERT(a && b, "Collision pair with a collider that is not in the tree");
+		if (a->intersects(static_cast<const Collider&>(*b)))
+			m_collisionPairs.push_back(pair);
+	}
+
+	return m_collisionPairs;
+}
+
+void PhysicsEngine::stepBodies(RigidBodyData& bodies, float deltaTime, ThreadPool* threadPool)
+{
+	PHYSICS_PROFILE_SCOPE(Step);
+	if (bodies.size() == 0 || deltaTime <= 0.0f) return;
+
+	for (uint32_t i = 0; i < bodies.size(); i++)
+	{
+		if (bodies.isDynamic(i))
+			bodies.LinearVelocities[i] += m_gravity * bodies.GravityScales[i] * deltaTime;
+	}
+
+	findBodyContacts(bodies);
+	m_contactSolver.solve(bodies, m_bodyContacts, deltaTime, threadPool);
+
+	for (uint32_t i = 0; i < bodies.size(); i++)
+	{
+		bodies.Positions[i] += bodies.LinearVelocities[i] * deltaTime;
+		bodies.Rotations[i] += bodies.AngularVelocities[i] * deltaTime;
+	}
+}
+
+void PhysicsEngine::findBodyContacts(const RigidBodyData& bodies)
+{
+	m_bodyIndices.clear();
+	for (uint32_t i = 0; i < bodies.size(); i++)
+		m_bodyIndices[bodies.IDs[i]] = i;
+
+	auto getBodyIndex = [&](ID id) {
+		auto it = m_bodyIndices.find(id);
+		return it != m_bodyIndices.end() ? it->second : BodyContact::NoBody;
+	};
+	auto isDynamic = [&](uint32_t body) {
+		return body != BodyContact::NoBody && bodies.isDynamic(body);
+	};
+
+	// Static colliders and tiles have no material, the body's own friction and restitution are used
+	auto friction = [&](uint32_t bodyA, uint32_t bodyB) {
+		if (bodyA == BodyContact::NoBody) return bodies.Frictions[bodyB];
+		if (bodyB == BodyContact::NoBody) return bodies.Frictions[bodyA];
+		return std::sqrt(bodies.Frictions[bodyA] * bodies.Frictions[bodyB]);
+	};
+	auto restitution = [&](uint32_t bodyA, uint32_t bodyB) {
+		if (bodyA == BodyContact::NoBody) return bodies.Restitutions[bodyB];
+		if (bodyB == BodyContact::NoBody) return bodies.Restitutions[bodyA];
+		return std::max(bodies.Restitutions[bodyA], bodies.Restitutions[bodyB]);
+	};
+
+	m_bodyContacts.clear();
+
+	// Collider pairs with at least one dynamic body
+	for (const CollisionPair& pair : computePairs())
+	{
+		uint32_t bodyA = getBodyIndex(pair.idA);
+		uint32_t bodyB = getBodyIndex(pair.idB);
+		if (!isDynamic(bodyA) && !isDynamic(bodyB)) continue;
+
+		ContactManifold manifold;
+		if (!CollisionUtilities::computeManifold(*getCollider(pair.idA), *getCollider(pair.idB), manifold))
+			continue;
+
+		m_bodyContacts.push_back(BodyContact{ bodyA, bodyB, ContactKey{ pair.idA, pair.idB }, friction(bodyA, bodyB), restitution(bodyA, bodyB), manifold });
+	}
+
+	// Solid tiles (or merged rectangles) touching dynamic bodies
+	for (uint32_t body = 0; body < bodies.size(); body++)
+	{
+		if (!bodies.isDynamic(body)) continue;
+
+		const ColliderInfo* collider = getCollider(bodies.IDs[body]);
+		if (collider == nullptr) continue;
+
+		auto addTileContacts = [&](const auto& shape) {
+			forEachTilemapGroup(shape.getBoundingBox(), QueryFilter(INVALID_ID, collider->Filter.MaskBits), [&](const TilemapColliderGroup& group) {
+				if (!group.getFilter().accepts(collider->Filter.CategoryBits)) return true;
+
+				group.query(shape, [&](const CollisionHit& hit) {
+					ContactManifold manifold;
+					if (CollisionUtilities::computeManifold(*collider, Collider(group.getHitBounds(hit)), manifold))
+					{
+						ContactKey key{ collider->id, hit.id, hit.XTilemapIndex, hit.YTilemapIndex };
+						m_bodyContacts.push_back(BodyContact{ body, BodyContact::NoBody, key, friction(body, BodyContact::NoBody), restitution(body, BodyContact::NoBody), manifold });
+					}
+					return true;
+				});
+				return true;
+			});
+		};
+
+		switch (collider->Type) {
+		case Collider::ColliderType::AABB:   addTileContacts(collider->AABBCollider); break;
+		case Collider::ColliderType::OBB:    addTileContacts(collider->OBBCollider); break;
+		case Collider::ColliderType::Circle: addTileContacts(collider->CircleCollider); break;
+		case Collider::ColliderType::Polygon: addTileContacts(collider->PolygonCollider); break;
+		case Collider::ColliderType::Capsule: addTileContacts(collider->CapsuleCollider); break;
+		default: ASSERT_FALSE("Unknown collider type");
+		}
+	}
+}
+
+void PhysicsEngine::updateTilemapColliderGroup(ID id, TransformComponent* transform, glm::vec2 tilemapSize, glm::vec2 tileSize,
+	const Bitset* solidTiles, const OccupancyPyramid* solidOccupancy, const TileRectMesh* solidRects, const CollisionFilter& filter)
+{
+	glm::vec2 min = transform->getPosition();
+	glm::vec2 max = glm::vec2(tilemapSize.x * tileSize.x, tilemapSize.y * tileSize.y) * transform->getSize() + transform->getPosition();
+	auto bounds = AABB(min, max);
+
+	auto it = m_tilemapColliderGroups.find(id);
+	bool boundsChanged = it == m_tilemapColliderGroups.end() ||
+		it->second.getBounds().Min != bounds.Min ||
+		it->second.getBounds().Max != bounds.Max ||
+		it->second.getFilter() != filter; // The tree keeps the filters to skip tilemaps without reading their groups
+
+	// The group only references the solid tiles, replacing it copies a few fields
+	m_tilemapColliderGroups.insert_or_assign(id, TilemapColliderGroup(id, bounds, tilemapSize, tileSize, solidTiles, solidOccupancy, solidRects, filter));
+
+	// Tile edits keep the same bounds, the static tree only needs a rebuild when a tilemap moves, is added or changes filter
+	if (boundsChanged)
+		rebuildTilemapColliderTree();
+}
+
+void PhysicsEngine::rebuildTilemapColliderTree()
+{
+	std::vector<ColliderInfo> tilemapBounds;
+	tilemapBounds.reserve(m_tilemapColliderGroups.size());
+	for (const auto& [id, group] : m_tilemapColliderGroups)
+		tilemapBounds.emplace_back(id, group.getBounds(), group.getFilter());
+
+	// Sorted so the tree doesn't depend on the iteration order of the map
+	std::sort(tilemapBounds.begin(), tilemapBounds.end(), [](const ColliderInfo& a, const ColliderInfo& b) { return a.id < b.id; });
+	m_tilemapColliderTree.build(std::move(tilemapBounds));
 }
 
 } // TileBite
\ No newline at end of file
@@ -4,77 +4,352 @@
 #include "core/pch.hpp"
 #include "utilities/Identifiable.hpp"
 #include "physics/AABBTree.hpp"
+#include "physics/SpatialHashGrid.hpp"
+#include "physics/WideBVH.hpp"
 #include "physics/TilemapColliderGroup.hpp"
 #include "physics/CollisionData.hpp"
+#include "physics/CollisionFilter.hpp"
 #include "physics/Ray2D.hpp"
 #include "physics/Collider.hpp"
+#include "physics/BodyType.hpp"
+#include "physics/ContactSolver.hpp"
+#include "physics/RigidBodyData.hpp"
+#include "physics/PhysicsProfiler.hpp"
+#include "utilities/ThreadPool.hpp"
 
 namespace TileBite {
 
-// TODO: layers mask, for filtering collisions.
-// TODO: add remove for tilemaps
-
+// Queries take a QueryFilter (or just the ID to exclude), only colliders and tilemaps with a category
+// in its mask are reported. Subtrees of the collider tree without such a category are skipped.
+//
+// Moving colliders (not tilemaps) are kept in the broad phase selected with setBroadphase(): an AABBTree by default,
+// or a SpatialHashGrid for many similar colliders that all move every frame. Static colliders are kept in a tree
+// of their own that moving colliders don't churn, and pairs between two static colliders are never computed.
+//
+// Concurrency: the const functions (queries and raycasts) keep no shared scratch state and can be called
+// from any number of threads at once, as long as no thread modifies the engine at the same time
+// (collider and tilemap updates, removals, computePairs).
 class PhysicsEngine {
 public:
+	enum class BroadphaseType {
+		AABBTree,
+		SpatialHashGrid
+	};
+
+	PhysicsEngine();
+
+	// Moves every collider to the given broad phase. cellSize is the grid cell size (0 picks one from the
+	// collider sizes), unused by the tree.
+	void setBroadphase(BroadphaseType type, float cellSize = 0.0f);
+	BroadphaseType getBroadphase() const { return m_broadphaseType; }
+
 	// Return CollisionData for each overlapping collider with ColliderT
 	// (Assumes ColliderT is supported by TilemapColliderGroup and AABBTree)
 	template<typename ColliderT>
-	std::vector<CollisionData> query(const ColliderT& collider, ID excludeID = INVALID_ID) const
+	std::vector<CollisionData> query(const ColliderT& collider, const QueryFilter& filter = QueryFilter()) const
 	{
-		// TODO: maybe use a different tree for static colliders
-		// tilemaps could be simpified to 
-
+		PHYSICS_PROFILE_ADD(Queries, 1);
+		PHYSICS_PROFILE_SCOPE(Queries);
 		// Need to exclude the ID to avoid self-collision
-		auto collisionData = m_coreTree.query(collider, excludeID);
-		auto tilemapChunksCollisionData = m_tilemapColliderTree.query(collider, excludeID);
+		auto collisionData = withBroadphase([&](const auto& broadphase) { return broadphase.query(collider, filter); });
+		m_staticTree.query(collider, filter, [&](const ColliderInfo& info) {
+			collisionData.push_back(CollisionData(GenericCollisionData(info.id, info)));
+			return true;
+		});
 
-		collisionData.reserve(collisionData.size() + tilemapChunksCollisionData.size());
-		for (const CollisionData& tilemapCollisionData : tilemapChunksCollisionData)
-		{
-			auto it = m_tilemapColliderGroups.find(tilemapCollisionData.Generic.id);
-			ASSERT(it != m_tilemapColliderGroups.end(), "Tilemap collider group not found in the map");
-
-			const TilemapColliderGroup& group = it->second;
-			auto groupColliderData = group.query(collider);
-			collisionData.insert(collisionData.end(), groupColliderData.begin(), groupColliderData.end());
-		}
+		forEachTilemapGroup(collider.getBoundingBox(), filter, [&](const TilemapColliderGroup& group) {
+			group.query(collider, [&](const CollisionHit& hit) {
+				collisionData.push_back(CollisionData(group.toCollisionData(hit)));
+				return true;
+			});
+			return true;
+		});
 
 		return collisionData;
 	}
 
-	std::vector<RayHitData> raycastAll(const Ray2D& ray, ID excludeID = INVALID_ID) const;
-	std::optional<RayHitData> raycastClosest(const Ray2D& ray, ID excludeID = INVALID_ID) const;
+	// Calls visitor(const CollisionHit&) for each overlapping collider and tile, stops early if it returns false.
+	// Does not allocate, the visitor must not query the physics engine.
+	template<typename ColliderT, typename Visitor>
+	requires HitVisitor<Visitor, const CollisionHit&>
+	void query(const ColliderT& collider, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		PHYSICS_PROFILE_ADD(Queries, 1);
+		PHYSICS_PROFILE_SCOPE(Queries);
+		bool stopped = false;
+		forEachColliderStructure([&](const auto& colliders) {
+			if (stopped) return;
+			colliders.query(collider, filter, [&](const ColliderInfo& info) {
+				stopped = !visitor(CollisionHit(info.id));
+				return !stopped;
+			});
+		});
+		if (stopped) return;
+
+		forEachTilemapGroup(collider.getBoundingBox(), filter, [&](const TilemapColliderGroup& group) {
+			group.query(collider, [&](const CollisionHit& hit) {
+				stopped = !visitor(hit);
+				return !stopped;
+			});
+			return !stopped;
+		});
+	}
+
+	// Appends a hit for each overlapping collider and tile to results.
+	// Reusing the same buffer (cleared by the caller) keeps per frame queries allocation free.
+	template<typename ColliderT>
+	void query(const ColliderT& collider, const QueryFilter& filter, std::vector<CollisionHit>& results) const
+	{
+		query(collider, filter, [&](const CollisionHit& hit) {
+			results.push_back(hit);
+			return true;
+		});
+	}
+
+	std::vector<RayHitData> raycastAll(const Ray2D& ray, const QueryFilter& filter = QueryFilter()) const;
+	std::optional<RayHitData> raycastClosest(const Ray2D& ray, const QueryFilter& filter = QueryFilter()) const;
+
+	// Calls visitor(const RayHit&) for each collider and tile hit by the ray, stops early if it returns false.
+	// Colliders are reported first (unordered), then the tiles of each tilemap closest first.
+	template<typename Visitor>
+	requires HitVisitor<Visitor, const RayHit&>
+	void raycastAll(const Ray2D& ray, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		PHYSICS_PROFILE_ADD(Raycasts, 1);
+		PHYSICS_PROFILE_SCOPE(Raycasts);
+		bool stopped = false;
+		forEachColliderStructure([&](const auto& colliders) {
+			if (stopped) return;
+			colliders.raycastAll(ray, filter, [&](const ColliderInfo& info, float tmin, float tmax) {
+				stopped = !visitor(RayHit(CollisionHit(info.id), tmin, tmax));
+				return !stopped;
+			});
+		});
+		if (stopped) return;
+
+		m_tilemapColliderTree.raycast(ray, [&](const ColliderInfo& tilemapInfo, float, float) {
+			if (!filter.accepts(tilemapInfo.id, tilemapInfo.Filter.CategoryBits)) return true;
+
+			getTilemapColliderGroup(tilemapInfo.id).raycast(ray, [&](const RayHit& hit) {
+				stopped = !visitor(hit);
+				return !stopped;
+			});
+			return !stopped;
+		});
+	}
+
+	// Appends a hit for each collider and tile hit by the ray to results
+	void raycastAll(const Ray2D& ray, const QueryFilter& filter, std::vector<RayHit>& results) const;
+
+	// Calls visitor(const CollisionHit&) for each collider (not tiles) containing point, stops early if it returns false.
+	// Meant for picking, does not allocate.
+	template<typename Visitor>
+	requires HitVisitor<Visitor, const CollisionHit&>
+	void queryPoint(glm::vec2 point, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		PHYSICS_PROFILE_ADD(Queries, 1);
+		PHYSICS_PROFILE_SCOPE(Queries);
+		bool stopped = false;
+		forEachColliderStructure([&](const auto& colliders) {
+			if (stopped) return;
+			colliders.queryPoint(point, filter, [&](const ColliderInfo& info) {
+				stopped = !visitor(CollisionHit(info.id));
+				return !stopped;
+			});
+		});
+	}
+
+	// Appends a hit for each collider (not tiles) containing point to results
+	void queryPoint(glm::vec2 point, const QueryFilter& filter, std::vector<CollisionHit>& results) const;
 
-	// NOTE: updates also used for additions
-	void updateTilemapColliderGroup(ID id, TransformComponent* transform, glm::vec2 tilemapSize, glm::vec2 tileSize, Bitset solidTiles);
-	void addTilemapColliderGroup(ID id, TransformComponent* transform, glm::vec2 tilemapSize, glm::vec2 tileSize, Bitset solidTiles);
+	// Replaces results with the k colliders (not tiles) closest to point no further than maxDistance, closest first.
+	// Distances are to the collider shapes, 0 for colliders containing point.
+	void nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const;
+	std::vector<NearestHit> nearest(uint32_t k, glm::vec2 point, float maxDistance = std::numeric_limits<float>::infinity(),
+		const QueryFilter& filter = QueryFilter()) const;
+
+	// First collider or tile touched by shape when it moves along displacement (continuous collision detection).
+	// ShapeCastHit::toi is the fraction of displacement travelled before the contact, shapes touched from the
+	// start are hit at toi 0. Colliders are swept through the tree by their bounds, tilemaps with a swept DDA.
+	std::optional<ShapeCastHit> shapeCast(const Collider& shape, glm::vec2 displacement, const QueryFilter& filter = QueryFilter()) const;
+
+	// Closest hit of every ray (results[i] for rays[i]), rays are split across the workers of threadPool.
+	void raycastBatch(std::span<const Ray2D> rays, std::span<std::optional<RayHitData>> results, ThreadPool& threadPool, const QueryFilter& filter = QueryFilter()) const;
+
+	// Distance to the first solid tile of any tilemap along each ray (hitDistances[i] for rays[i]),
+	// TilemapColliderGroup::NoHit when nothing is hit. Colliders are ignored, meant for the many rays
+	// of lighting and visibility against level geometry.
+	void raycastTilemapsFirstHit(std::span<const Ray2D> rays, std::span<float> hitDistances, const QueryFilter& filter = QueryFilter()) const;
+
+	// NOTE: updates also used for additions.
+	// The group keeps pointers to solidTiles, solidOccupancy and solidRects (owned by the tilemap resource), tile edits
+	// are seen by queries right away. Only a change of the tilemap bounds rebuilds the tilemap tree.
+	// Without solidRects every solid tile is reported as its own collider.
+	void updateTilemapColliderGroup(ID id, TransformComponent* transform, glm::vec2 tilemapSize, glm::vec2 tileSize,
+		const Bitset* solidTiles, const OccupancyPyramid* solidOccupancy, const TileRectMesh* solidRects = nullptr,
+		const CollisionFilter& filter = CollisionFilter());
 	
+	// Static colliders go to the static tree, a collider changing body type moves across
 	template<typename ColliderT>
-	void updateCollider(ID id, const ColliderT* collider, TransformComponent* transform)
+	void updateCollider(ID id, const ColliderT* collider, TransformComponent* transform, const CollisionFilter& filter = CollisionFilter(),
+		BodyType bodyType = BodyType::Dynamic)
 	{
-		ColliderT worldSpaceAABB = collider->toWorldSpace(
+		ColliderInfo info = makeColliderInfo(id, collider, transform, filter);
+		if (bodyType == BodyType::Static)
+		{
+			withBroadphase([&](auto& broadphase) { broadphase.remove(id); });
+			if (!m_staticTree.update(info)) m_staticTree.insert(info);
+			return;
+		}
+
+		m_staticTree.remove(id);
+		withBroadphase([&](auto& broadphase) {
+			bool updated = broadphase.update(info);
+			if (!updated) broadphase.insert(info);
+		});
+	}
+
+	// Collider of the broad phase for a collider component, in world space
+	template<typename ColliderT>
+	static ColliderInfo makeColliderInfo(ID id, const ColliderT* collider, TransformComponent* transform, const CollisionFilter& filter = CollisionFilter())
+	{
+		ColliderT worldSpaceCollider = collider->toWorldSpace(
 			transform->getPosition(),
 			transform->getSize(),
 			transform->getRotation()
 		);
 
-		ColliderInfo info(id, worldSpaceAABB);
-		bool updated = m_coreTree.update(info);
-		if (!updated) m_coreTree.insert(info);
+		return ColliderInfo(id, worldSpaceCollider, filter);
 	}
 
+	// Replaces every collider (not tilemaps) with colliders and staticColliders, built at once instead of inserted
+	// one by one. Meant for the first population of a scene, the trees are built on threadPool when given.
+	void buildColliders(std::span<const ColliderInfo> colliders, std::span<const ColliderInfo> staticColliders = {}, ThreadPool* threadPool = nullptr);
+	// True once buildColliders() ran, even with no colliders
+	bool isBuilt() const { return m_isBuilt; }
+
+	// Entities of sleeping colliders that changed since the last fixed update, filled by the watched components
+	// (see SleepWatch) and emptied by ColliderUpdateSystem
+	std::vector<ID>& getWokenColliders() { return m_wokenColliders; }
+
+	uint32_t getColliderCount() const;
+
+	// Removes the collider or tilemap collider group with this ID
 	void removeCollider(ID id);
 
-	const std::vector<Collider> getCoreTreeColliders() { return m_coreTree.getLeafColliders(); }
-	const std::vector<AABB> getCoreTreeInternalBounds() const { return m_coreTree.getInternalBounds(); }
+	// Returns every pair of overlapping colliders (tilemaps are not included) whose collision filters accept each other.
+	// With the tree only colliders that moved out of their fat bounds since the last call query it, pairs
+	// between the rest are kept from the previous call. The grid finds every pair again after its rebuild.
+	// Meant to be called once per frame, the returned buffer is reused by the next call.
+	const std::vector<CollisionPair>& computePairs();
+
+	// Advances bodies by deltaTime: gravity, contacts against colliders and solid tiles, contact solving
+	// and integration of positions. The colliders of bodies must be up to date in the engine, bodies are
+	// matched to them by ID. Colliders that are not bodies act as static geometry.
+	// Contact islands are solved in parallel on threadPool when given.
+	void stepBodies(RigidBodyData& bodies, float deltaTime, ThreadPool* threadPool = nullptr);
+
+	void setGravity(glm::vec2 gravity) { m_gravity = gravity; }
+	glm::vec2 getGravity() const { return m_gravity; }
+	ContactSolver::Settings& getSolverSettings() { return m_contactSolver.getSettings(); }
+	const std::vector<BodyContact>& getBodyContacts() const { return m_bodyContacts; }
+
+	// Counters and timers of the last frame (all physics engines together), zeroed unless the engine is compiled
+	// with PHYSICS_PROFILING. Timers nest (the step includes the queries it runs) and add up across threads.
+	static PhysicsFrameStats getProfilingStats() { return PhysicsProfiler::getLastFrame(); }
+
+	const std::vector<Collider> getCoreTreeColliders() const;
+	// Internal node bounds of the tree, or occupied cell bounds of the grid
+	const std::vector<AABB> getCoreTreeInternalBounds() const
+	{
+		return (m_broadphaseType == BroadphaseType::SpatialHashGrid) ? m_hashGrid.getCellBounds() : m_coreTree.getInternalBounds();
+	}
+	// Tree depth of each bound of getCoreTreeInternalBounds() (0 for the root and every grid cell)
+	const std::vector<uint32_t> getCoreTreeInternalDepths() const
+	{
+		if (m_broadphaseType == BroadphaseType::SpatialHashGrid) return std::vector<uint32_t>(m_hashGrid.getCellBounds().size(), 0);
+		return m_coreTree.getInternalDepths();
+	}
+	const std::vector<AABB> getStaticTreeInternalBounds() const { return m_staticTree.getInternalBounds(); }
 	const std::vector<AABB> getTilemapTreeInternalBounds() const { return m_tilemapColliderTree.getInternalBounds(); }
-	const std::vector<Collider> getTilemapTreeColliders() { return m_tilemapColliderTree.getLeafColliders(); }
+	const std::vector<Collider> getTilemapTreeColliders() const { return m_tilemapColliderTree.getLeafColliders(); }
+	AABBTree::Metrics getCoreTreeMetrics() const { return m_coreTree.getMetrics(); }
 
 private:
+	// The core tree is rebuilt when its SAH cost per leaf grows 50% over the last rebuild,
+	// checked every 1024 reinsertions, so that query cost stays bounded in long sessions.
+	constexpr static float CoreTreeRebuildCostRatio = 1.5f;
+	constexpr static uint32_t CoreTreeRebuildCheckInterval = 1024;
+
+	// Rays per thread pool chunk in raycastBatch
+	constexpr static uint32_t RaycastBatchChunkSize = 64;
+
+	BroadphaseType m_broadphaseType = BroadphaseType::AABBTree;
+	bool m_isBuilt = false;
+	std::vector<ID> m_wokenColliders;
 	AABBTree m_coreTree;
+	SpatialHashGrid m_hashGrid;
+	AABBTree m_staticTree;
 
+	// Calls func with the selected broad phase (m_coreTree or m_hashGrid) and returns its result
+	template<typename Func>
+	decltype(auto) withBroadphase(Func&& func) const
+	{
+		if (m_broadphaseType == BroadphaseType::SpatialHashGrid) return func(m_hashGrid);
+		return func(m_coreTree);
+	}
+
+	template<typename Func>
+	decltype(auto) withBroadphase(Func&& func)
+	{
+		if (m_broadphaseType == BroadphaseType::SpatialHashGrid) return func(m_hashGrid);
+		return func(m_coreTree);
+	}
+
+	// Calls func with the selected broad phase, then with the static tree
+	template<typename Func>
+	void forEachColliderStructure(Func&& func) const
+	{
+		withBroadphase(func);
+		func(m_staticTree);
+	}
+
+	// computePairs() state
+	std::vector<CollisionPair> m_proxyPairs; // Pairs with overlapping fat bounds
+	std::vector<CollisionPair> m_collisionPairs; // Pairs with overlapping colliders
+	std::vector<ID> m_movedIDs;
+	std::vector<ID> m_movedStaticIDs;
+
+	// stepBodies() state
+	glm::vec2 m_gravity = glm::vec2(0.0f);
+	ContactSolver m_contactSolver;
+	std::vector<BodyContact> m_bodyContacts;
+	std::unordered_map<ID, uint32_t> m_bodyIndices;
+
+	void findBodyContacts(const RigidBodyData& bodies);
+
+	// nullptr if the collider is not in the broad phase
+	const ColliderInfo* getCollider(ID id) const;
+
+	// Tilemaps are few, big and rarely moving so they are kept in a separate static tree
+	// that is only rebuilt when the bounds of a tilemap change.
 	std::unordered_map<ID, TilemapColliderGroup> m_tilemapColliderGroups;
-	AABBTree m_tilemapColliderTree;
+	WideBVH m_tilemapColliderTree;
+
+	void rebuildTilemapColliderTree();
+	const TilemapColliderGroup& getTilemapColliderGroup(ID id) const;
+
+	// Calls callback(const TilemapColliderGroup&) for each tilemap whose bounds overlap bounds,
+	// stops early if it returns false.
+	template<typename Callback>
+	void forEachTilemapGroup(const AABB& bounds, const QueryFilter& filter, Callback&& callback) const
+	{
+		// Tilemap bounds only need a broad phase test, each group clamps the query to its own bounds.
+		m_tilemapColliderTree.query(bounds, [&](const ColliderInfo& tilemapInfo) {
+			if (!filter.accepts(tilemapInfo.id, tilemapInfo.Filter.CategoryBits)) return true;
+			return bool(callback(getTilemapColliderGroup(tilemapInfo.id)));
+		});
+	}
 };
 
 } // TileBite
@@ -0,0 +1,141 @@
+#ifndef PHYSICS_PROFILER_HPP
+#define PHYSICS_PROFILER_HPP
+
+#include "core/pch.hpp"
+
+namespace TileBite {
+
+// Work done by the physics engine, to tell whether slow frames come from the broad phase,
+// the narrow phase or the tilemap grid walks.
+enum class PhysicsCounter : uint32_t {
+	TreeNodesVisited,   // AABBTree nodes popped by queries, raycasts, sweeps and pair searches
+	TreeLeavesTested,   // AABBTree leaves that reached a narrow phase test
+	TreeRefits,         // AABBTree ancestors refitted after insertions and removals
+	TreeReinsertions,   // AABBTree leaves that moved out of their fat bounds
+	TileCellsScanned,   // Tiles and DDA cells read by TilemapColliderGroup queries and raycasts
+	TileSATTests,       // Narrow phase tests of non AABB shapes against tiles
+	Queries,            // PhysicsEngine overlap and point queries
+	Raycasts,           // PhysicsEngine raycasts (every ray of a batch)
+	Count
+};
+
+enum class PhysicsTimer : uint32_t {
+	Queries,
+	Raycasts,
+	Pairs,
+	Step,
+	Count
+};
+
+// Counters of the last completed frame, see PhysicsProfiler::getLastFrame()
+struct PhysicsFrameStats {
+	std::array<uint64_t, static_cast<size_t>(PhysicsCounter::Count)> Counters = {};
+	std::array<double, static_cast<size_t>(PhysicsTimer::Count)> TimersMs = {};
+
+	uint64_t get(PhysicsCounter counter) const { return Counters[static_cast<size_t>(counter)]; }
+	double getMs(PhysicsTimer timer) const { return TimersMs[static_cast<size_t>(timer)]; }
+};
+
+// Process wide physics counters, compiled in with PHYSICS_PROFILING (CMake option ENABLE_PHYSICS_PROFILING).
+// Without it the PHYSICS_PROFILE_* macros expand to nothing and getLastFrame() stays zeroed.
+// Counters are relaxed atomics so concurrent queries can count, hot loops count in a local
+// LocalCounter and add it once when it goes out of scope.
+class PhysicsProfiler {
+public:
+	static void add(PhysicsCounter counter, uint64_t amount)
+	{
+		s_counters[static_cast<size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	static void addTime(PhysicsTimer timer, uint64_t nanoseconds)
+	{
+		s_timers[static_cast<size_t>(timer)].fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+
+	// Moves the counts since the last call to the last frame stats, called once per frame by the engine loop
+	static void endFrame()
+	{
+		std::lock_guard<std::mutex> lock(s_frameMutex);
+		for (size_t i = 0; i < s_counters.size(); i++)
+			s_lastFrame.Counters[i] = s_counters[i].exchange(0, std::memory_order_relaxed);
+		for (size_t i = 0; i < s_timers.size(); i++)
+			s_lastFrame.TimersMs[i] = static_cast<double>(s_timers[i].exchange(0, std::memory_order_relaxed)) * 1e-6;
+	}
+
+	static PhysicsFrameStats getLastFrame()
+	{
+		std::lock_guard<std::mutex> lock(s_frameMutex);
+		return s_lastFrame;
+	}
+
+	static const char* getName(PhysicsCounter counter)
+	{
+		constexpr const char* Names[] = {
+			"tree nodes visited", "tree leaves tested", "tree refits", "tree reinsertions",
+			"tile cells scanned", "tile SAT tests", "queries", "raycasts"
+		};
+		static_assert(std::size(Names) == static_cast<size_t>(PhysicsCounter::Count));
+		return Names[static_cast<size_t>(counter)];
+	}
+
+	static const char* getName(PhysicsTimer timer)
+	{
+		constexpr const char* Names[] = { "queries", "raycasts", "pairs", "step" };
+		static_assert(std::size(Names) == static_cast<size_t>(PhysicsTimer::Count));
+		return Names[static_cast<size_t>(timer)];
+	}
+
+	// Counts in a plain integer and adds the total to the shared counter on destruction
+	struct LocalCounter {
+		PhysicsCounter Counter;
+		uint64_t Value = 0;
+
+		explicit LocalCounter(PhysicsCounter counter) : Counter(counter) {}
+		~LocalCounter() { if (Value) add(Counter, Value); }
+		LocalCounter(const LocalCounter&) = delete;
+		LocalCounter& operator=(const LocalCounter&) = delete;
+	};
+
+	// Adds the time from construction to destruction to a timer
+	struct ScopedTimer {
+		PhysicsTimer Timer;
+		std::chrono::high_resolution_clock::time_point Start;
+
+		explicit ScopedTimer(PhysicsTimer timer) : Timer(timer), Start(std::chrono::high_resolution_clock::now()) {}
+		~ScopedTimer()
+		{
+			auto elapsed = std::chrono::high_resolution_clock::now() - Start;
+			addTime(Timer, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		}
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+	};
+
+private:
+	static inline std::array<std::atomic<uint64_t>, static_cast<size_t>(PhysicsCounter::Count)> s_counters = {};
+	static inline std::array<std::atomic<uint64_t>, static_cast<size_t>(PhysicsTimer::Count)> s_timers = {};
+	static inline std::mutex s_frameMutex;
+	static inline PhysicsFrameStats s_lastFrame;
+};
+
+} // TileBite
+
+#ifdef PHYSICS_PROFILING
+	#define PHYSICS_PROFILE_CONCAT_IMPL(a, b) a##b
+	#define PHYSICS_PROFILE_CONCAT(a, b) PHYSICS_PROFILE_CONCAT_IMPL(a, b)
+
+	// Adds amount to a counter
+	#define PHYSICS_PROFILE_ADD(counter, amount) ::TileBite::PhysicsProfiler::add(::TileBite::PhysicsCounter::counter, (amount))
+	// Declares a local counter named var, added to the shared counter when it goes out of scope
+	#define PHYSICS_PROFILE_LOCAL(var, counter) ::TileBite::PhysicsProfiler::LocalCounter var(::TileBite::PhysicsCounter::counter)
+	#define PHYSICS_PROFILE_INC(var) (++(var).Value)
+	// Times the rest of the enclosing scope
+	#define PHYSICS_PROFILE_SCOPE(timer) ::TileBite::PhysicsProfiler::ScopedTimer PHYSICS_PROFILE_CONCAT(physicsScopedTimer, __LINE__)(::TileBite::PhysicsTimer::timer)
+#else
+	#define PHYSICS_PROFILE_ADD(counter, amount) ((void)0)
+	#define PHYSICS_PROFILE_LOCAL(var, counter) ((void)0)
+	#define PHYSICS_PROFILE_INC(var) ((void)0)
+	#define PHYSICS_PROFILE_SCOPE(timer) ((void)0)
+#endif
+
+#endif // !PHYSICS_PROFILER_HPP
@@ -0,0 +1,130 @@
+#include "physics/Polygon.hpp"
+
+#include "physics/AABB.hpp"
+#include "physics/Collider.hpp"
+#include "physics/GJK.hpp"
+#include "utilities/assertions.hpp"
+#include "utilities/DeterministicMath.hpp"
+
+namespace TileBite {
+
+Polygon::Polygon()
+	: Count(4)
+{
+	Vertices[0] = glm::vec2(-0.5f, -0.5f);
+	Vertices[1] = glm::vec2(0.5f, -0.5f);
+	Vertices[2] = glm::vec2(0.5f, 0.5f);
+	Vertices[3] = glm::vec2(-0.5f, 0.5f);
+}
+
+Polygon::Polygon(std::span<const glm::vec2> vertices)
+	: Count(static_cast<uint32_t>(std::min<size_t>(vertices.size(), MaxVertices)))
+{
+	ASSERT(vertices.size() >= 3, "Polygon needs at least 3 vertices");
+	ASSERT(vertices.size() <= MaxVertices, "Polygon has too many vertices");
+	std::copy_n(vertices.begin(), Count, Vertices.begin());
+
+	// Signed area decides the winding
+	float doubleArea = 0.0f;
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		glm::vec2 a = Vertices[i], b = Vertices[(i + 1) % Count];
+		doubleArea += a.x * b.y - a.y * b.x;
+	}
+	if (doubleArea < 0.0f)
+		std::reverse(Vertices.begin(), Vertices.begin() + Count);
+}
+
+Polygon Polygon::toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) const
+{
+	float c = simCos(radians);
+	float s = simSin(radians);
+
+	Polygon worldSpacePolygon = *this;
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		glm::vec2 scaled = Vertices[i] * size;
+		worldSpacePolygon.Vertices[i] = glm::vec2(
+			scaled.x * c - scaled.y * s,
+			scaled.x * s + scaled.y * c
+		) + position;
+	}
+
+	// Mirroring by a negative size flips the winding
+	if (size.x * size.y < 0.0f)
+		std::reverse(worldSpacePolygon.Vertices.begin(), worldSpacePolygon.Vertices.begin() + Count);
+
+	return worldSpacePolygon;
+}
+
+float Polygon::getArea() const
+{
+	float doubleArea = 0.0f;
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		glm::vec2 a = Vertices[i], b = Vertices[(i + 1) % Count];
+		doubleArea += a.x * b.y - a.y * b.x;
+	}
+	return 0.5f * doubleArea;
+}
+
+glm::vec2 Polygon::getCentroid() const
+{
+	// Area weighted centroids of the triangle fan around the first vertex
+	glm::vec2 origin = Vertices[0];
+	glm::vec2 weightedSum(0.0f);
+	float doubleArea = 0.0f;
+	for (uint32_t i = 1; i + 1 < Count; i++)
+	{
+		glm::vec2 e1 = Vertices[i] - origin, e2 = Vertices[i + 1] - origin;
+		float triangleArea = e1.x * e2.y - e1.y * e2.x;
+		weightedSum += triangleArea * (e1 + e2) / 3.0f;
+		doubleArea += triangleArea;
+	}
+	return (doubleArea > 0.0f) ? origin + weightedSum / doubleArea : origin;
+}
+
+AABB Polygon::getBoundingBox() const
+{
+	glm::vec2 minPt(FLT_MAX), maxPt(-FLT_MAX);
+
+	for (uint32_t i = 0; i < Count; i++)
+	{
+		minPt = glm::min(minPt, Vertices[i]);
+		maxPt = glm::max(maxPt, Vertices[i]);
+	}
+
+	return AABB(minPt, maxPt);
+}
+
+bool Polygon::intersects(const AABB& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Polygon::intersects(const Collider& other) const
+{
+	return other.intersects(*this);
+}
+
+bool Polygon::intersects(const OBB& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Polygon::intersects(const Circle& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Polygon::intersects(const Polygon& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+bool Polygon::intersects(const Capsule& other) const
+{
+	return CollisionUtilities::gjkIntersects(ConvexShape(*this), ConvexShape(other));
+}
+
+} // TileBite
@@ -0,0 +1,49 @@
+#ifndef POLYGON_HPP
+#define POLYGON_HPP
+
+#include "core/pch.hpp"
+#include <glm/glm.hpp>
+
+namespace TileBite {
+
+struct AABB; // Forward declaration to avoid circular dependency
+struct Collider;
+struct OBB;
+struct Circle;
+struct Capsule;
+
+// Convex polygon of 3 to MaxVertices vertices in counter clockwise order.
+// Tested against other shapes with GJK (see physics/GJK.hpp).
+struct Polygon {
+	static constexpr uint32_t MaxVertices = 8;
+
+	std::array<glm::vec2, MaxVertices> Vertices;
+	uint32_t Count;
+
+	Polygon(); // Unit square centered at the origin
+
+	// Vertices past MaxVertices are dropped, clockwise vertices are reversed
+	Polygon(std::span<const glm::vec2> vertices);
+
+	Polygon toWorldSpace(glm::vec2 position, glm::vec2 size, float radians) const;
+
+	inline bool isValid() const noexcept {
+		return Count >= 3 && Count <= MaxVertices;
+	}
+
+	float getArea() const;
+	glm::vec2 getCentroid() const;
+
+	AABB getBoundingBox() const;
+
+	bool intersects(const AABB& other) const;
+	bool intersects(const Collider& other) const;
+	bool intersects(const OBB& other) const;
+	bool intersects(const Circle& other) const;
+	bool intersects(const Polygon& other) const;
+	bool intersects(const Capsule& other) const;
+};
+
+} // TileBite
+
+#endif // !POLYGON_HPP
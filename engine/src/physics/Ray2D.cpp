@@ -1,6 +1,7 @@
 #include "physics/Ray2D.hpp"
 
 #include "utilities/assertions.hpp"
+#include "utilities/DeterministicMath.hpp"
 
 namespace TileBite {
 
@@ -16,8 +17,8 @@ bool Ray2D::intersect(const AABB& b, float& tmin, float& tmax) const {
 }
 
 bool Ray2D::intersect(const OBB& b, float& tmin, float& tmax) const {
-    float cosR = cos(-b.Rotation);
-    float sinR = sin(-b.Rotation);
+    float cosR = simCos(-b.Rotation);
+    float sinR = simSin(-b.Rotation);
 
     glm::vec2 rotatedRayDir(
         d.x * cosR - d.y * sinR,
@@ -57,11 +58,71 @@ bool Ray2D::intersect(const Circle& b, float& tmin, float& tmax) const {
     return true;
 }
 
+bool Ray2D::intersect(const Polygon& b, float& tmin, float& tmax) const {
+    // Clip the line against the half plane of every edge (Cyrus-Beck)
+    tmin = -std::numeric_limits<float>::infinity();
+    tmax = std::numeric_limits<float>::infinity();
+    for (uint32_t i = 0; i < b.Count; i++)
+    {
+        glm::vec2 start = b.Vertices[i];
+        glm::vec2 edge = b.Vertices[(i + 1) % b.Count] - start;
+        glm::vec2 normal(edge.y, -edge.x);
+
+        float distance = glm::dot(normal, start - o);
+        float speed = glm::dot(normal, d);
+        if (speed == 0.0f)
+        {
+            // Parallel to the edge, the line is either always inside its half plane or never
+            if (distance < 0.0f) return false;
+            continue;
+        }
+
+        float t = distance / speed;
+        if (speed < 0.0f) tmin = std::max(tmin, t);
+        else tmax = std::min(tmax, t);
+        if (tmin > tmax) return false;
+    }
+    return true;
+}
+
+bool Ray2D::intersect(const Capsule& b, float& tmin, float& tmax) const {
+    // A capsule is the union of the circles at its ends and the box between them, the line crosses
+    // the capsule (convex) on a single interval covering the intervals of the parts it hits
+    tmin = std::numeric_limits<float>::infinity();
+    tmax = -std::numeric_limits<float>::infinity();
+    auto merge = [&](auto hitPart) {
+        float partMin, partMax;
+        if (!hitPart(partMin, partMax)) return;
+        tmin = std::min(tmin, partMin);
+        tmax = std::max(tmax, partMax);
+    };
+
+    merge([&](float& partMin, float& partMax) { return intersect(Circle(b.PointA, b.Radius), partMin, partMax); });
+    merge([&](float& partMin, float& partMax) { return intersect(Circle(b.PointB, b.Radius), partMin, partMax); });
+
+    glm::vec2 axis = b.PointB - b.PointA;
+    float length = glm::length(axis);
+    if (length > 0.0f)
+    {
+        // Box in the frame of the capsule axis
+        glm::vec2 u = axis / length;
+        glm::vec2 v(-u.y, u.x);
+        glm::vec2 localOrigin = o - 0.5f * (b.PointA + b.PointB);
+        Ray2D localRay(glm::vec2(glm::dot(localOrigin, u), glm::dot(localOrigin, v)), glm::vec2(glm::dot(d, u), glm::dot(d, v)), maxT);
+        glm::vec2 halfExtents(0.5f * length, b.Radius);
+        merge([&](float& partMin, float& partMax) { return localRay.intersect(AABB(-halfExtents, halfExtents), partMin, partMax); });
+    }
+
+    return tmin <= tmax;
+}
+
 bool Ray2D::intersect(const Collider& other, float& tmin, float& tmax) const {
     switch (other.Type) {
     case Collider::ColliderType::AABB: return intersect(other.AABBCollider, tmin, tmax);
     case Collider::ColliderType::OBB:  return intersect(other.OBBCollider, tmin, tmax);
     case Collider::ColliderType::Circle:  return intersect(other.CircleCollider, tmin, tmax);
+    case Collider::ColliderType::Polygon: return intersect(other.PolygonCollider, tmin, tmax);
+    case Collider::ColliderType::Capsule: return intersect(other.CapsuleCollider, tmin, tmax);
     default: ASSERT_FALSE("Unknown collider type");
     }
     return false;
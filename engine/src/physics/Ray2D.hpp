@@ -23,6 +23,8 @@ public:
     bool intersect(const AABB& b, float& tmin, float& tmax) const;
     bool intersect(const OBB& b, float& tmin, float& tmax) const;
     bool intersect(const Circle& b, float& tmin, float& tmax) const;
+    bool intersect(const Polygon& b, float& tmin, float& tmax) const;
+    bool intersect(const Capsule& b, float& tmin, float& tmax) const;
     bool intersect(const Collider& other, float& tmin, float& tmax) const;
 
     float getMaxT() const {
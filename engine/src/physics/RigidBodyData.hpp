@@ -0,0 +1,61 @@
+#ifndef RIGID_BODY_DATA_HPP
+#define RIGID_BODY_DATA_HPP
+
+#include "core/pch.hpp"
+#include "core/Types.hpp"
+#include <glm/glm.hpp>
+
+namespace TileBite {
+
+// Rigid bodies of a physics step in SoA layout, entry i of every array belongs to body i.
+// Inverse masses / inertias of 0 stand for infinite mass (static bodies, or bodies that don't rotate).
+struct RigidBodyData {
+	std::vector<ID> IDs; // Collider ID of each body
+	std::vector<glm::vec2> Positions; // Center of mass
+	std::vector<float> Rotations;
+	std::vector<glm::vec2> LinearVelocities;
+	std::vector<float> AngularVelocities;
+	std::vector<float> InverseMasses;
+	std::vector<float> InverseInertias;
+	std::vector<float> Frictions;
+	std::vector<float> Restitutions;
+	std::vector<float> GravityScales;
+
+	uint32_t size() const { return static_cast<uint32_t>(IDs.size()); }
+
+	void clear()
+	{
+		IDs.clear();
+		Positions.clear();
+		Rotations.clear();
+		LinearVelocities.clear();
+		AngularVelocities.clear();
+		InverseMasses.clear();
+		InverseInertias.clear();
+		Frictions.clear();
+		Restitutions.clear();
+		GravityScales.clear();
+	}
+
+	uint32_t add(ID id, glm::vec2 position, float rotation, glm::vec2 linearVelocity, float angularVelocity,
+		float inverseMass, float inverseInertia, float friction, float restitution, float gravityScale)
+	{
+		IDs.push_back(id);
+		Positions.push_back(position);
+		Rotations.push_back(rotation);
+		LinearVelocities.push_back(linearVelocity);
+		AngularVelocities.push_back(angularVelocity);
+		InverseMasses.push_back(inverseMass);
+		InverseInertias.push_back(inverseInertia);
+		Frictions.push_back(friction);
+		Restitutions.push_back(restitution);
+		GravityScales.push_back(gravityScale);
+		return size() - 1;
+	}
+
+	bool isDynamic(uint32_t index) const { return InverseMasses[index] > 0.0f; }
+};
+
+} // TileBite
+
+#endif // !RIGID_BODY_DATA_HPP
@@ -0,0 +1,321 @@
+#include "physics/SpatialHashGrid.hpp"
+
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+void SpatialHashGrid::setCellSize(float cellSize)
+{
+	ASSERT(cellSize >= 0.0f, "Cell size can't be negative");
+	m_cellSize = cellSize;
+	m_isDirty.store(true, std::memory_order_relaxed);
+}
+
+void SpatialHashGrid::insert(const ColliderInfo& colliderInfo)
+{
+	ASSERT(!m_indices.contains(colliderInfo.id), "Collider already in the grid");
+	m_indices.emplace(colliderInfo.id, static_cast<uint32_t>(m_colliders.size()));
+	m_colliders.push_back(colliderInfo);
+	m_bounds.push_back(colliderInfo.getAABBBounds());
+	m_isDirty.store(true, std::memory_order_relaxed);
+}
+
+bool SpatialHashGrid::update(const ColliderInfo& colliderInfo)
+{
+	auto it = m_indices.find(colliderInfo.id);
+	if (it == m_indices.end()) return false;
+
+	m_colliders[it->second] = colliderInfo;
+	m_bounds[it->second] = colliderInfo.getAABBBounds();
+	m_isDirty.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+bool SpatialHashGrid::remove(ID id)
+{
+	auto it = m_indices.find(id);
+	if (it == m_indices.end()) return false;
+
+	uint32_t index = it->second;
+	m_indices.erase(it);
+	if (index != m_colliders.size() - 1)
+	{
+		m_colliders[index] = m_colliders.back();
+		m_bounds[index] = m_bounds.back();
+		m_indices[m_colliders[index].id] = index;
+	}
+	m_colliders.pop_back();
+	m_bounds.pop_back();
+	m_isDirty.store(true, std::memory_order_relaxed);
+	return true;
+}
+
+void SpatialHashGrid::clear()
+{
+	m_colliders.clear();
+	m_bounds.clear();
+	m_indices.clear();
+	m_isDirty.store(true, std::memory_order_relaxed);
+}
+
+const ColliderInfo* SpatialHashGrid::getCollider(ID id) const
+{
+	auto it = m_indices.find(id);
+	return (it != m_indices.end()) ? &m_colliders[it->second] : nullptr;
+}
+
+void SpatialHashGrid::rebuild() const
+{
+	std::lock_guard<std::mutex> lock(m_buildMutex);
+	if (!m_isDirty.load(std::memory_order_relaxed)) return; // Built by another query
+
+	uint32_t colliderCount = static_cast<uint32_t>(m_colliders.size());
+
+	m_builtCellSize = m_cellSize;
+	if (m_builtCellSize <= 0.0f)
+	{
+		float extentSum = 0.0f;
+		for (const AABB& bounds : m_bounds)
+			extentSum += std::max(bounds.getWidth(), bounds.getHeight());
+		m_builtCellSize = (colliderCount > 0) ? 2.0f * extentSum / colliderCount : 1.0f;
+		if (m_builtCellSize <= 0.0f) m_builtCellSize = 1.0f;
+	}
+
+	uint32_t bucketCount = std::bit_ceil(std::max(MinBucketCount, 2 * colliderCount));
+	m_bucketMask = bucketCount - 1;
+	m_bucketStarts.assign(bucketCount + 1, 0);
+	m_colliderCells.resize(colliderCount);
+	m_oversized.clear();
+	m_maxHalfExtents = glm::vec2(0.0f);
+
+	// Counting sort over the buckets, first the size of each bucket
+	bool hasBounds = false;
+	for (uint32_t i = 0; i < colliderCount; i++)
+	{
+		const AABB& bounds = m_bounds[i];
+		glm::vec2 size = bounds.Max - bounds.Min;
+		if (std::max(size.x, size.y) > m_builtCellSize)
+		{
+			m_oversized.push_back(i);
+			continue;
+		}
+
+		m_maxHalfExtents = glm::max(m_maxHalfExtents, 0.5f * size);
+		m_gridBounds = hasBounds ? AABB::getUnion(m_gridBounds, bounds) : bounds;
+		hasBounds = true;
+
+		m_colliderCells[i] = getCell(0.5f * (bounds.Min + bounds.Max));
+		m_bucketStarts[getBucket(m_colliderCells[i]) + 1]++;
+	}
+
+	for (uint32_t bucket = 1; bucket <= bucketCount; bucket++)
+		m_bucketStarts[bucket] += m_bucketStarts[bucket - 1];
+
+	// Then the entries, m_bucketStarts[b] is used as the insertion cursor of bucket b - 1
+	uint32_t entryCount = colliderCount - static_cast<uint32_t>(m_oversized.size());
+	m_sortedBounds.resize(entryCount);
+	m_sortedCells.resize(entryCount);
+	m_sortedFilters.resize(entryCount);
+	m_sortedIndices.resize(entryCount);
+
+	uint32_t nextOversized = 0;
+	for (uint32_t i = 0; i < colliderCount; i++)
+	{
+		if (nextOversized < m_oversized.size() && m_oversized[nextOversized] == i)
+		{
+			nextOversized++;
+			continue;
+		}
+
+		uint32_t entry = m_bucketStarts[getBucket(m_colliderCells[i])]++;
+		m_sortedBounds[entry] = m_bounds[i];
+		m_sortedCells[entry] = m_colliderCells[i];
+		m_sortedFilters[entry] = m_colliders[i].Filter;
+		m_sortedIndices[entry] = i;
+	}
+
+	// Cursors ended at the start of the next bucket
+	for (uint32_t bucket = bucketCount; bucket > 0; bucket--)
+		m_bucketStarts[bucket] = m_bucketStarts[bucket - 1];
+	m_bucketStarts[0] = 0;
+
+	m_isDirty.store(false, std::memory_order_release);
+}
+
+std::vector<RayHitData> SpatialHashGrid::raycastAll(const Ray2D& ray, const QueryFilter& filter) const
+{
+	std::vector<RayHitData> results;
+	raycastAll(ray, filter, [&](const ColliderInfo& info, float tmin, float tmax) {
+		results.push_back(RayHitData(GenericCollisionData(info.id, info), tmin, tmax));
+		return true;
+	});
+
+	return results;
+}
+
+void SpatialHashGrid::raycastAll(const Ray2D& ray, const QueryFilter& filter, std::vector<RayHit>& results) const
+{
+	raycastAll(ray, filter, [&](const ColliderInfo& info, float tmin, float tmax) {
+		results.push_back(RayHit(CollisionHit(info.id), tmin, tmax));
+		return true;
+	});
+}
+
+std::optional<RayHitData> SpatialHashGrid::raycastClosest(const Ray2D& ray, const QueryFilter& filter) const
+{
+	ensureBuilt();
+
+	float bestT = ray.getMaxT();
+	std::optional<RayHitData> closestHit;
+	auto visitCollider = [&](uint32_t index) {
+		const ColliderInfo& info = m_colliders[index];
+		float tmin, tmax;
+		if (info.id != filter.ExcludeID &&
+			ray.intersect(info, tmin, tmax) &&
+			(tmin < bestT || (!closestHit && tmin <= bestT)))
+		{
+			bestT = tmin;
+			closestHit = RayHitData(GenericCollisionData(info.id, info), tmin, tmax);
+		}
+	};
+
+	// Cells are walked closest first, cells entered after the closest hit can't hold a closer one
+	forEachCellAlongRay(ray, filter.MaskBits, bestT, [&](uint32_t index) {
+		visitCollider(index);
+		return true;
+	});
+
+	for (uint32_t index : m_oversized)
+	{
+		if (filter.accepts(m_colliders[index].Filter.CategoryBits))
+			visitCollider(index);
+	}
+
+	return closestHit;
+}
+
+void SpatialHashGrid::queryPoint(glm::vec2 point, const QueryFilter& filter, std::vector<CollisionHit>& results) const
+{
+	queryPoint(point, filter, [&](const ColliderInfo& info) {
+		results.emplace_back(info.id);
+		return true;
+	});
+}
+
+void SpatialHashGrid::nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const
+{
+	ensureBuilt();
+	results.clear();
+	if (k == 0) return;
+
+	AABB looseBounds(m_gridBounds.Min - m_maxHalfExtents, m_gridBounds.Max + m_maxHalfExtents);
+	float radius = m_builtCellSize;
+	while (true)
+	{
+		// Colliders within radius of point overlap the square, once it covers the grid only oversized
+		// colliders are left outside and the last pass takes everything up to maxDistance
+		AABB region(point - glm::vec2(radius), point + glm::vec2(radius));
+		bool coversGrid = m_sortedIndices.empty() || region.contains(looseBounds);
+		float searchRadius = (coversGrid || radius >= maxDistance) ? maxDistance : radius;
+
+		results.clear();
+		forEachInRegion(region, filter.MaskBits, [&](uint32_t index, const AABB& bounds) {
+			const ColliderInfo& info = m_colliders[index];
+			if (info.id == filter.ExcludeID || bounds.distance(point) > searchRadius) return true;
+
+			float distance = CollisionUtilities::distance(info, point);
+			if (distance <= searchRadius)
+				results.emplace_back(CollisionHit(info.id), distance);
+			return true;
+		});
+
+		// k colliders within radius are closer than any collider outside of it
+		if (results.size() >= k || searchRadius == maxDistance) break;
+		radius *= 2.0f;
+	}
+
+	std::sort(results.begin(), results.end(), [](const NearestHit& a, const NearestHit& b) { return a.distance < b.distance; });
+	if (results.size() > k) results.erase(results.begin() + k, results.end());
+}
+
+void SpatialHashGrid::computePairs(std::vector<CollisionPair>& pairs) const
+{
+	ensureBuilt();
+	pairs.clear();
+
+	auto addPair = [&](uint32_t indexA, uint32_t indexB) {
+		const ColliderInfo& a = m_colliders[indexA];
+		const ColliderInfo& b = m_colliders[indexB];
+		if (a.intersects(static_cast<const Collider&>(b)))
+			pairs.push_back(CollisionPair{ std::min(a.id, b.id), std::max(a.id, b.id) });
+	};
+
+	// Every entry looks for the entries after it around its bounds, so each pair is found once
+	for (uint32_t entry = 0; entry < m_sortedIndices.size(); entry++)
+	{
+		const AABB& bounds = m_sortedBounds[entry];
+		const CollisionFilter& filter = m_sortedFilters[entry];
+		glm::ivec2 first = getCell(bounds.Min - m_maxHalfExtents);
+		glm::ivec2 last = getCell(bounds.Max + m_maxHalfExtents);
+
+		for (int y = first.y; y <= last.y; y++)
+		{
+			for (int x = first.x; x <= last.x; x++)
+			{
+				forEachInCell(glm::ivec2(x, y), filter.MaskBits, [&](uint32_t other) {
+					if (other > entry &&
+						m_sortedFilters[other].accepts(filter.CategoryBits) &&
+						m_sortedBounds[other].intersects(bounds))
+					{
+						addPair(m_sortedIndices[entry], m_sortedIndices[other]);
+					}
+					return true;
+				});
+			}
+		}
+	}
+
+	// Oversized colliders against the grid and against the oversized ones after them
+	for (uint32_t index : m_oversized)
+	{
+		const CollisionFilter& filter = m_colliders[index].Filter;
+		forEachInRegion(m_bounds[index], filter.MaskBits, [&](uint32_t other, const AABB& otherBounds) {
+			bool otherOversized = std::binary_search(m_oversized.begin(), m_oversized.end(), other);
+			if ((otherOversized && other <= index) ||
+				!m_colliders[other].Filter.accepts(filter.CategoryBits) ||
+				!otherBounds.intersects(m_bounds[index]))
+			{
+				return true;
+			}
+
+			addPair(index, other);
+			return true;
+		});
+	}
+}
+
+std::vector<Collider> SpatialHashGrid::getLeafColliders() const
+{
+	return std::vector<Collider>(m_colliders.begin(), m_colliders.end());
+}
+
+std::vector<AABB> SpatialHashGrid::getCellBounds() const
+{
+	ensureBuilt();
+
+	std::vector<glm::ivec2> cells(m_sortedCells.begin(), m_sortedCells.end());
+	std::sort(cells.begin(), cells.end(), [](glm::ivec2 a, glm::ivec2 b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+	cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+	std::vector<AABB> cellBounds;
+	cellBounds.reserve(cells.size());
+	for (glm::ivec2 cell : cells)
+	{
+		glm::vec2 min = glm::vec2(cell) * m_builtCellSize;
+		cellBounds.push_back(AABB(min - m_maxHalfExtents, min + glm::vec2(m_builtCellSize) + m_maxHalfExtents));
+	}
+
+	return cellBounds;
+}
+
+} // TileBite
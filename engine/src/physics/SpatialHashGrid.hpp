@@ -0,0 +1,343 @@
+#ifndef SPATIAL_HASH_GRID_HPP
+#define SPATIAL_HASH_GRID_HPP
+
+#include "core/pch.hpp"
+#include "physics/AABBTree.hpp"
+#include "physics/CollisionData.hpp"
+#include "physics/CollisionFilter.hpp"
+#include "physics/Ray2D.hpp"
+
+namespace TileBite {
+
+// Broad phase for many colliders of similar size that all move every frame, where keeping an AABBTree
+// up to date costs more than building a grid from scratch.
+//
+// Loose grid: every collider is stored once, in the cell of its center, and a cell reaches as far as the largest
+// half extent of the colliders in the grid past its edges. Cells are hashed into buckets, the entries of a
+// bucket are contiguous SoA arrays (bounds, cells, filters) built with a counting sort over the buckets.
+// Colliders larger than a cell are kept in a separate list tested one by one.
+//
+// Changes only touch the dense collider arrays, the buckets are rebuilt by the first query after them.
+// Queries of a built grid (or of a grid built by another query) can run on any number of threads at once.
+class SpatialHashGrid {
+public:
+	// A cellSize of 0 picks twice the average collider extent on each rebuild
+	explicit SpatialHashGrid(float cellSize = 0.0f) : m_cellSize(cellSize) {}
+
+	SpatialHashGrid(const SpatialHashGrid&) = delete;
+	SpatialHashGrid& operator=(const SpatialHashGrid&) = delete;
+
+	void setCellSize(float cellSize);
+	float getCellSize() const { return m_cellSize; }
+
+	void insert(const ColliderInfo& colliderInfo);
+	bool remove(ID id);
+	bool update(const ColliderInfo& colliderInfo);
+	void clear();
+
+	// nullptr if the collider is not in the grid
+	const ColliderInfo* getCollider(ID id) const;
+	uint32_t size() const { return static_cast<uint32_t>(m_colliders.size()); }
+
+	// Calls visitor(const ColliderInfo&) for every overlapping collider, stops early if it returns false.
+	template<typename ColliderT, typename Visitor>
+	requires HitVisitor<Visitor, const ColliderInfo&>
+	void query(const ColliderT& collider, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		if constexpr (std::same_as<ColliderT, Collider>) {
+			switch (collider.Type) {
+			case Collider::ColliderType::AABB:   query(collider.AABBCollider, filter, visitor); return;
+			case Collider::ColliderType::OBB:    query(collider.OBBCollider, filter, visitor); return;
+			case Collider::ColliderType::Circle: query(collider.CircleCollider, filter, visitor); return;
+			case Collider::ColliderType::Polygon: query(collider.PolygonCollider, filter, visitor); return;
+			case Collider::ColliderType::Capsule: query(collider.CapsuleCollider, filter, visitor); return;
+			default: ASSERT_FALSE("Unknown collider type"); return;
+			}
+		}
+		else {
+			ensureBuilt();
+			const AABB queryBounds = collider.getBoundingBox();
+			forEachInRegion(queryBounds, filter.MaskBits, [&](uint32_t index, const AABB& bounds) {
+				if (!bounds.intersects(queryBounds)) return true;
+
+				const ColliderInfo& info = m_colliders[index];
+				if (info.id == filter.ExcludeID || !collider.intersects(static_cast<const Collider&>(info))) return true;
+				return bool(visitor(info));
+			});
+		}
+	}
+
+	// Appends a hit for every overlapping collider to results
+	template<typename ColliderT>
+	void query(const ColliderT& collider, const QueryFilter& filter, std::vector<CollisionHit>& results) const
+	{
+		query(collider, filter, [&](const ColliderInfo& info) {
+			results.emplace_back(info.id);
+			return true;
+		});
+	}
+
+	template<typename ColliderT>
+	std::vector<CollisionData> query(const ColliderT& collider, const QueryFilter& filter) const
+	{
+		std::vector<CollisionData> results;
+		query(collider, filter, [&](const ColliderInfo& info) {
+			results.push_back(CollisionData(GenericCollisionData(info.id, info)));
+			return true;
+		});
+		return results;
+	}
+
+	// Calls visitor(const ColliderInfo&, float tmin, float tmax) for every collider hit by the ray,
+	// roughly closest first. Stops early if the visitor returns false.
+	template<typename Visitor>
+	requires HitVisitor<Visitor, const ColliderInfo&, float, float>
+	void raycastAll(const Ray2D& ray, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		ensureBuilt();
+		bool stopped = false;
+		auto visitCollider = [&](uint32_t index) {
+			const ColliderInfo& info = m_colliders[index];
+			float tmin, tmax;
+			if (info.id != filter.ExcludeID && ray.intersect(info, tmin, tmax) && ray.getMaxT() >= tmin)
+				stopped = !visitor(info, tmin, tmax);
+			return !stopped;
+		};
+
+		forEachCellAlongRay(ray, filter.MaskBits, ray.getMaxT(), [&](uint32_t index) {
+			return visitCollider(index);
+		});
+
+		for (uint32_t index : m_oversized)
+		{
+			if (stopped) return;
+			if (filter.accepts(m_colliders[index].Filter.CategoryBits))
+				visitCollider(index);
+		}
+	}
+
+	void raycastAll(const Ray2D& ray, const QueryFilter& filter, std::vector<RayHit>& results) const;
+	std::vector<RayHitData> raycastAll(const Ray2D& ray, const QueryFilter& filter = QueryFilter()) const;
+	std::optional<RayHitData> raycastClosest(const Ray2D& ray, const QueryFilter& filter = QueryFilter()) const;
+
+	// Calls visitor(const ColliderInfo&) for every collider containing point, stops early if it returns false.
+	template<typename Visitor>
+	requires HitVisitor<Visitor, const ColliderInfo&>
+	void queryPoint(glm::vec2 point, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		ensureBuilt();
+		forEachInRegion(AABB(point, point), filter.MaskBits, [&](uint32_t index, const AABB& bounds) {
+			if (!bounds.contains(point)) return true;
+
+			const ColliderInfo& info = m_colliders[index];
+			if (info.id == filter.ExcludeID || !CollisionUtilities::contains(info, point)) return true;
+			return bool(visitor(info));
+		});
+	}
+
+	void queryPoint(glm::vec2 point, const QueryFilter& filter, std::vector<CollisionHit>& results) const;
+
+	// Replaces results with the k colliders closest to point no further than maxDistance, closest first.
+	// Searches a square around point that doubles from one cell until it holds k colliders within its radius.
+	void nearest(uint32_t k, glm::vec2 point, float maxDistance, const QueryFilter& filter, std::vector<NearestHit>& results) const;
+
+	// Calls visitor(const ColliderInfo&) for every collider whose bounds are touched by bounds moving along
+	// displacement (broad phase only). The visitor returns the fraction of the displacement still of interest,
+	// colliders reached only after it are skipped. Same contract as AABBTree::sweep.
+	template<typename Visitor>
+	requires std::is_invocable_r_v<float, Visitor, const ColliderInfo&>
+	void sweep(const AABB& bounds, glm::vec2 displacement, const QueryFilter& filter, Visitor&& visitor) const
+	{
+		ensureBuilt();
+		AABB sweptBounds = AABB::getUnion(bounds, AABB(bounds.Min + displacement, bounds.Max + displacement));
+
+		float maxT = 1.0f;
+		forEachInRegion(sweptBounds, filter.MaskBits, [&](uint32_t index, const AABB& colliderBounds) {
+			const ColliderInfo& info = m_colliders[index];
+			float tEnter, tExit;
+			if (info.id != filter.ExcludeID &&
+				CollisionUtilities::sweepInterval(bounds, displacement, colliderBounds, tEnter, tExit) &&
+				tEnter <= maxT)
+			{
+				maxT = std::min(maxT, static_cast<float>(visitor(info)));
+			}
+			return true;
+		});
+	}
+
+	// Replaces pairs with every pair of overlapping colliders (narrow phase included) whose filters
+	// accept each other. Pairs are ordered by the grid layout.
+	void computePairs(std::vector<CollisionPair>& pairs) const;
+
+	std::vector<Collider> getLeafColliders() const;
+	const std::vector<ColliderInfo>& getColliderInfos() const { return m_colliders; }
+	// Loose bounds of the occupied cells, for debug drawing
+	std::vector<AABB> getCellBounds() const;
+
+	// Builds the buckets now instead of on the next query
+	void rebuild() const;
+
+private:
+	constexpr static uint32_t MinBucketCount = 64;
+
+	float m_cellSize;
+
+	// Dense collider storage, removing a collider moves the last one in its place
+	std::vector<ColliderInfo> m_colliders;
+	std::vector<AABB> m_bounds;
+	std::unordered_map<ID, uint32_t> m_indices;
+
+	// Built state, entries of bucket b are [m_bucketStarts[b], m_bucketStarts[b + 1])
+	mutable std::atomic<bool> m_isDirty = false;
+	mutable std::mutex m_buildMutex;
+	mutable float m_builtCellSize = 1.0f;
+	mutable glm::vec2 m_maxHalfExtents = glm::vec2(0.0f);
+	mutable AABB m_gridBounds; // Bounds of every collider in the grid (not oversized ones)
+	mutable uint32_t m_bucketMask = 0;
+	mutable std::vector<uint32_t> m_bucketStarts;
+	mutable std::vector<AABB> m_sortedBounds;
+	mutable std::vector<glm::ivec2> m_sortedCells;
+	mutable std::vector<CollisionFilter> m_sortedFilters;
+	mutable std::vector<uint32_t> m_sortedIndices; // Dense index of each entry
+	mutable std::vector<uint32_t> m_oversized; // Dense indices of colliders larger than a cell
+	mutable std::vector<glm::ivec2> m_colliderCells; // Build scratch, cell of each dense collider
+
+	inline void ensureBuilt() const
+	{
+		if (m_isDirty.load(std::memory_order_acquire))
+			rebuild();
+	}
+
+	inline glm::ivec2 getCell(glm::vec2 position) const
+	{
+		return glm::ivec2(static_cast<int>(std::floor(position.x / m_builtCellSize)), static_cast<int>(std::floor(position.y / m_builtCellSize)));
+	}
+
+	inline uint32_t getBucket(glm::ivec2 cell) const
+	{
+		return ((static_cast<uint32_t>(cell.x) * 73856093u) ^ (static_cast<uint32_t>(cell.y) * 19349663u)) & m_bucketMask;
+	}
+
+	// Calls func(uint32_t entry) for the entries stored in cell with a category in maskBits,
+	// stops and returns false if func returns false
+	template<typename Func>
+	bool forEachInCell(glm::ivec2 cell, uint16_t maskBits, Func&& func) const
+	{
+		uint32_t bucket = getBucket(cell);
+		for (uint32_t entry = m_bucketStarts[bucket]; entry < m_bucketStarts[bucket + 1]; entry++)
+		{
+			// Other cells can share the bucket
+			if (m_sortedCells[entry] != cell || (m_sortedFilters[entry].CategoryBits & maskBits) == 0) continue;
+			if (!func(entry)) return false;
+		}
+		return true;
+	}
+
+	// Calls func(uint32_t index, const AABB& bounds) for every collider (dense index) with a category in maskBits
+	// that may overlap region, oversized ones included. Stops early if func returns false.
+	template<typename Func>
+	void forEachInRegion(const AABB& region, uint16_t maskBits, Func&& func) const
+	{
+		if (!m_sortedIndices.empty() && region.intersects(m_gridBounds))
+		{
+			// Colliders of a cell reach m_maxHalfExtents past it
+			AABB clamped = AABB::intersectionBound(AABB(region.Min - m_maxHalfExtents, region.Max + m_maxHalfExtents),
+				AABB(m_gridBounds.Min - m_maxHalfExtents, m_gridBounds.Max + m_maxHalfExtents));
+			glm::ivec2 first = getCell(clamped.Min);
+			glm::ivec2 last = getCell(clamped.Max);
+
+			uint64_t cellCount = uint64_t(last.x - first.x + 1) * uint64_t(last.y - first.y + 1);
+			if (cellCount > m_sortedIndices.size())
+			{
+				// Regions spanning more cells than entries read the entries directly
+				for (uint32_t entry = 0; entry < m_sortedIndices.size(); entry++)
+				{
+					if ((m_sortedFilters[entry].CategoryBits & maskBits) == 0) continue;
+					if (!func(m_sortedIndices[entry], m_sortedBounds[entry])) return;
+				}
+			}
+			else
+			{
+				for (int y = first.y; y <= last.y; y++)
+				{
+					for (int x = first.x; x <= last.x; x++)
+					{
+						bool keepGoing = forEachInCell(glm::ivec2(x, y), maskBits, [&](uint32_t entry) {
+							return bool(func(m_sortedIndices[entry], m_sortedBounds[entry]));
+						});
+						if (!keepGoing) return;
+					}
+				}
+			}
+		}
+
+		for (uint32_t index : m_oversized)
+		{
+			if ((m_colliders[index].Filter.CategoryBits & maskBits) == 0) continue;
+			if (!func(index, m_bounds[index])) return;
+		}
+	}
+
+	// Walks the cells crossed by the ray in order (DDA) and calls visit(uint32_t index) for the colliders
+	// in and around them (oversized ones excluded), each one once, stops early if visit returns false.
+	// Cells entered past maxT are skipped, visit may lower it.
+	template<typename Visit>
+	void forEachCellAlongRay(const Ray2D& ray, uint16_t maskBits, const float& maxT, Visit&& visit) const
+	{
+		if (m_sortedIndices.empty()) return;
+
+		// Only the part of the ray over the loose grid bounds is walked
+		float tStart, tEnd;
+		AABB looseBounds(m_gridBounds.Min - m_maxHalfExtents, m_gridBounds.Max + m_maxHalfExtents);
+		if (!ray.intersect(looseBounds, tStart, tEnd) || tStart > ray.getMaxT()) return;
+
+		glm::vec2 direction = ray.getDirection();
+		glm::ivec2 cell = getCell(ray.at(tStart));
+		glm::ivec2 step(direction.x > 0.0f ? 1 : -1, direction.y > 0.0f ? 1 : -1);
+
+		// Ray distance to the next vertical and horizontal cell borders, and between two of them
+		constexpr float Infinity = std::numeric_limits<float>::infinity();
+		glm::vec2 origin = ray.getOrigin();
+		glm::vec2 tNextBorder(Infinity), tBorderDelta(Infinity);
+		for (int axis = 0; axis < 2; axis++)
+		{
+			if (direction[axis] == 0.0f) continue;
+			float border = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * m_builtCellSize;
+			tNextBorder[axis] = (border - origin[axis]) / direction[axis];
+			tBorderDelta[axis] = m_builtCellSize / std::abs(direction[axis]);
+		}
+
+		// Colliders hit at a point belong to its cell or a neighbour (half extents are at most half a cell).
+		// Neighbourhoods of cells along the walk overlap, a cell is only visited the first time it appears,
+		// it can't come back once it left the neighbourhood since the walk is monotonic on both axes.
+		bool hasPrevious = false;
+		glm::ivec2 previous(0);
+		while (true)
+		{
+			for (int y = cell.y - 1; y <= cell.y + 1; y++)
+			{
+				for (int x = cell.x - 1; x <= cell.x + 1; x++)
+				{
+					if (hasPrevious && std::abs(x - previous.x) <= 1 && std::abs(y - previous.y) <= 1) continue;
+
+					bool keepGoing = forEachInCell(glm::ivec2(x, y), maskBits, [&](uint32_t entry) {
+						return bool(visit(m_sortedIndices[entry]));
+					});
+					if (!keepGoing) return;
+				}
+			}
+
+			int axis = (tNextBorder.x < tNextBorder.y) ? 0 : 1;
+			if (tNextBorder[axis] > std::min(maxT, tEnd)) return;
+
+			previous = cell;
+			hasPrevious = true;
+			cell[axis] += step[axis];
+			tNextBorder[axis] += tBorderDelta[axis];
+		}
+	}
+};
+
+} // TileBite
+
+#endif // !SPATIAL_HASH_GRID_HPP
@@ -0,0 +1,117 @@
+#include "physics/TileRectMesh.hpp"
+
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+TileRectMesh::TileRectMesh(uint32_t width, uint32_t height)
+	: m_width(width), m_height(height), m_owners(width * height, NoRect)
+{
+	ASSERT(width <= UINT16_MAX && height <= UINT16_MAX, "Grid too large for tile rects");
+}
+
+void TileRectMesh::build(const Bitset& cells)
+{
+	ASSERT(cells.getSize() == size_t(m_width) * m_height, "Cells don't match the mesh size");
+
+	m_rects.clear();
+	m_freeRects.clear();
+	std::fill(m_owners.begin(), m_owners.end(), NoRect);
+
+	if (m_width > 0 && m_height > 0)
+		meshRegion(cells, 0, 0, m_width - 1, m_height - 1);
+}
+
+void TileRectMesh::update(const Bitset& cells, uint32_t x, uint32_t y)
+{
+	ASSERT(x < m_width && y < m_height, "Cell out of range");
+
+	// The rectangles touching the cell are removed and their cells meshed again together with the edited cell.
+	// A cleared cell splits its rectangle, a new solid cell can merge with its neighbours.
+	uint32_t minX = x, minY = y, maxX = x, maxY = y;
+	auto removeOwner = [&](uint32_t cellX, uint32_t cellY) {
+		uint32_t index = getRectIndex(cellX, cellY);
+		if (index == NoRect) return;
+
+		const Rect& rect = m_rects[index];
+		minX = std::min<uint32_t>(minX, rect.X);
+		minY = std::min<uint32_t>(minY, rect.Y);
+		maxX = std::max<uint32_t>(maxX, rect.X + rect.Width - 1);
+		maxY = std::max<uint32_t>(maxY, rect.Y + rect.Height - 1);
+		removeRect(index);
+	};
+
+	removeOwner(x, y);
+	if (cells.isSet(x + y * m_width))
+	{
+		if (x > 0) removeOwner(x - 1, y);
+		if (x + 1 < m_width) removeOwner(x + 1, y);
+		if (y > 0) removeOwner(x, y - 1);
+		if (y + 1 < m_height) removeOwner(x, y + 1);
+	}
+
+	meshRegion(cells, minX, minY, maxX, maxY);
+}
+
+void TileRectMesh::meshRegion(const Bitset& cells, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+{
+	for (uint32_t y = minY; y <= maxY; y++)
+	{
+		for (uint32_t x = minX; x <= maxX; x++)
+		{
+			if (!isFree(cells, x, y))
+				continue;
+
+			// Grow right as far as possible, then down while the whole row span is free
+			uint32_t endX = x + 1;
+			while (endX <= maxX && isFree(cells, endX, y))
+				endX++;
+
+			uint32_t endY = y + 1;
+			while (endY <= maxY)
+			{
+				bool rowFree = true;
+				for (uint32_t spanX = x; spanX < endX && rowFree; spanX++)
+					rowFree = isFree(cells, spanX, endY);
+				if (!rowFree) break;
+				endY++;
+			}
+
+			addRect(Rect{ uint16_t(x), uint16_t(y), uint16_t(endX - x), uint16_t(endY - y) });
+			x = endX - 1;
+		}
+	}
+}
+
+void TileRectMesh::addRect(const Rect& rect)
+{
+	uint32_t index;
+	if (!m_freeRects.empty())
+	{
+		index = m_freeRects.back();
+		m_freeRects.pop_back();
+		m_rects[index] = rect;
+	}
+	else
+	{
+		index = static_cast<uint32_t>(m_rects.size());
+		m_rects.push_back(rect);
+	}
+
+	for (uint32_t y = rect.Y; y < uint32_t(rect.Y + rect.Height); y++)
+		std::fill_n(m_owners.begin() + (rect.X + y * m_width), rect.Width, index);
+}
+
+void TileRectMesh::removeRect(uint32_t index)
+{
+	Rect& rect = m_rects[index];
+	ASSERT(rect.Width > 0, "Removing a free tile rect");
+
+	for (uint32_t y = rect.Y; y < uint32_t(rect.Y + rect.Height); y++)
+		std::fill_n(m_owners.begin() + (rect.X + y * m_width), rect.Width, NoRect);
+
+	rect = Rect{};
+	m_freeRects.push_back(index);
+}
+
+} // TileBite
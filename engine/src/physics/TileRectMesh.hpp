@@ -0,0 +1,64 @@
+#ifndef TILE_RECT_MESH_HPP
+#define TILE_RECT_MESH_HPP
+
+#include "core/pch.hpp"
+#include "utilities/Bitset.hpp"
+
+namespace TileBite {
+
+// Covers the solid cells of a grid with non overlapping rectangles (greedy meshing), so that large
+// solid regions are reported as a few big colliders instead of one per tile.
+// Every solid cell is owned by exactly one rectangle. Single cell edits only re-mesh the rectangles
+// around the edited cell.
+class TileRectMesh {
+public:
+	static constexpr uint32_t NoRect = UINT32_MAX;
+
+	// In cells, Width == 0 marks a free slot
+	struct Rect {
+		uint16_t X = 0;
+		uint16_t Y = 0;
+		uint16_t Width = 0;
+		uint16_t Height = 0;
+	};
+
+	TileRectMesh() = default;
+	TileRectMesh(uint32_t width, uint32_t height);
+
+	// Meshes every solid cell (bit x + y * width)
+	void build(const Bitset& cells);
+
+	// Call after cell (x, y) of cells changed between empty and solid
+	void update(const Bitset& cells, uint32_t x, uint32_t y);
+
+	// Rectangle owning the cell, NoRect for empty cells
+	inline uint32_t getRectIndex(uint32_t x, uint32_t y) const { return m_owners[x + y * m_width]; }
+	inline const Rect& getRect(uint32_t index) const { return m_rects[index]; }
+	uint32_t getRectCount() const { return static_cast<uint32_t>(m_rects.size() - m_freeRects.size()); }
+
+	uint32_t getWidth() const { return m_width; }
+	uint32_t getHeight() const { return m_height; }
+
+private:
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+
+	std::vector<Rect> m_rects;
+	std::vector<uint32_t> m_freeRects;
+	std::vector<uint32_t> m_owners; // Rect index of each cell
+
+	// Greedy meshing of the solid cells without an owner in [minX, maxX] x [minY, maxY]
+	void meshRegion(const Bitset& cells, uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY);
+	void addRect(const Rect& rect);
+	void removeRect(uint32_t index);
+
+	inline bool isFree(const Bitset& cells, uint32_t x, uint32_t y) const
+	{
+		uint32_t idx = x + y * m_width;
+		return m_owners[idx] == NoRect && cells.isSet(idx);
+	}
+};
+
+} // TileBite
+
+#endif // !TILE_RECT_MESH_HPP
@@ -1,9 +1,58 @@
 #include "physics/TilemapColliderGroup.hpp"
 
 #include "core/pch.hpp"
+#include "utilities/SIMD.hpp"
 
 namespace TileBite {
 
+namespace {
+
+// Float lanes used by the packet DDA. Tile coordinates are kept as floats (exact for any tilemap size
+// that fits in memory) so the walk only needs float arithmetic, which AVX has without AVX2.
+#if defined(TILEBITE_SIMD_AVX)
+struct AVXLanes {
+    using Float = __m256;
+    static constexpr uint32_t Width = 8;
+
+    static Float load(const float* p) { return _mm256_load_ps(p); }
+    static void store(float* p, Float a) { _mm256_store_ps(p, a); }
+    static Float set1(float a) { return _mm256_set1_ps(a); }
+    static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+    static Float bitAnd(Float a, Float b) { return _mm256_and_ps(a, b); }
+    static Float bitAndNot(Float mask, Float a) { return _mm256_andnot_ps(mask, a); }
+    static Float bitOr(Float a, Float b) { return _mm256_or_ps(a, b); }
+    static Float lt(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static Float le(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    static Float ge(Float a, Float b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Float select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+    static uint32_t moveMask(Float a) { return uint32_t(_mm256_movemask_ps(a)); }
+};
+using PacketLanes = AVXLanes;
+#elif defined(TILEBITE_SIMD_SSE)
+struct SSELanes {
+    using Float = __m128;
+    static constexpr uint32_t Width = 4;
+
+    static Float load(const float* p) { return _mm_load_ps(p); }
+    static void store(float* p, Float a) { _mm_store_ps(p, a); }
+    static Float set1(float a) { return _mm_set1_ps(a); }
+    static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+    static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+    static Float bitAnd(Float a, Float b) { return _mm_and_ps(a, b); }
+    static Float bitAndNot(Float mask, Float a) { return _mm_andnot_ps(mask, a); }
+    static Float bitOr(Float a, Float b) { return _mm_or_ps(a, b); }
+    static Float lt(Float a, Float b) { return _mm_cmplt_ps(a, b); }
+    static Float le(Float a, Float b) { return _mm_cmple_ps(a, b); }
+    static Float ge(Float a, Float b) { return _mm_cmpge_ps(a, b); }
+    static Float select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    static uint32_t moveMask(Float a) { return uint32_t(_mm_movemask_ps(a)); }
+};
+using PacketLanes = SSELanes;
+#endif
+
+} // anonymous namespace
+
 glm::ivec2 TilemapColliderGroup::worldPositionToTileIndices(glm::vec2 position, float epsilon) const
 {
     // NOTE: Using epsilon avoids adding tiles at edges ([start, end] exclusive)
@@ -86,7 +135,7 @@ std::vector<CollisionData> TilemapColliderGroup::queryScanline(const OBB& collid
             int startXFixed = startX;
             while (startXFixed < endX)
             {
-                if (m_tiles.isSet(startXFixed + y * static_cast<uint32_t>(tilemapSize.x)))
+                if (m_tiles->isSet(startXFixed + y * static_cast<uint32_t>(tilemapSize.x)))
                 {
                     glm::vec2 tileMin = m_bounds.Min + glm::vec2(startXFixed, y) * tileSize;
                     glm::vec2 tileMax = tileMin + tileSize;
@@ -101,7 +150,7 @@ std::vector<CollisionData> TilemapColliderGroup::queryScanline(const OBB& collid
             int endXFixed = endX - 1;
             while (endXFixed >= startXFixed)
             {
-                if (m_tiles.isSet(endXFixed + y * static_cast<uint32_t>(tilemapSize.x)))
+                if (m_tiles->isSet(endXFixed + y * static_cast<uint32_t>(tilemapSize.x)))
                 {
                     glm::vec2 tileMin = m_bounds.Min + glm::vec2(endXFixed, y) * tileSize;
                     glm::vec2 tileMax = tileMin + tileSize;
@@ -115,7 +164,7 @@ std::vector<CollisionData> TilemapColliderGroup::queryScanline(const OBB& collid
 
             for (int x = startXFixed; x <= endXFixed; x++)
             {
-                if (m_tiles.isSet(x + y * static_cast<uint32_t>(tilemapSize.x))) {
+                if (m_tiles->isSet(x + y * static_cast<uint32_t>(tilemapSize.x))) {
                     glm::vec2 tileMin = m_bounds.Min + glm::vec2(x, y) * tileSize;
                     glm::vec2 tileMax = tileMin + tileSize;
 
@@ -137,77 +186,338 @@ std::vector<CollisionData> TilemapColliderGroup::queryScanline(const OBB& collid
     return results;
 }
 
-std::vector<CollisionData> TilemapColliderGroup::query(const AABB& collider) const
-{
-	ASSERT(!m_bounds.isEmpty(), "TilemapColliderGroup bounds cannot be empty");
+std::vector<RayHitData> TilemapColliderGroup::raycastAll(const Ray2D& ray) const {
+    std::vector<RayHitData> results;
+    raycast(ray, [&](const RayHit& hit) {
+        results.push_back(RayHitData(
+            toCollisionData(hit),
+            hit.tmin, hit.tmax)
+        );
+        return true;
+    });
 
-    std::vector<CollisionData> results;
+    return results;
+}
 
-    // Compute intersection with tilemap bounds
-    AABB intersectionArea = AABB::intersectionBound(collider, m_bounds);
-    if (intersectionArea.isEmpty()) return results;
+void TilemapColliderGroup::raycastAll(const Ray2D& ray, std::vector<RayHit>& results) const {
+    raycast(ray, [&](const RayHit& hit) {
+        results.push_back(hit);
+        return true;
+    });
+}
+
+std::optional<RayHitData> TilemapColliderGroup::raycastClosest(const Ray2D& ray) const {
+    std::optional<RayHitData> result;
+    raycast(ray, [&](const RayHit& hit) {
+        result = RayHitData(
+            toCollisionData(hit),
+            hit.tmin, hit.tmax
+        );
+        return false;
+    });
+
+    return result;
+}
 
-	glm::vec2 startIndices = worldPositionToTileIndices(intersectionArea.Min);
-	glm::vec2 endIndices = worldPositionToTileIndices(intersectionArea.Max, -1e-4f);
+void TilemapColliderGroup::raycastFirstHits(std::span<const Ray2D> rays, std::span<float> hitDistances) const {
+    ASSERT(rays.size() == hitDistances.size(), "raycastFirstHits needs one distance per ray");
 
-	// TODO: this for loop can be optimized by using bitset operations
-    results.reserve((endIndices.x - startIndices.x + 1) * (endIndices.y - startIndices.y + 1));
-    for (uint32_t y = startIndices.y; y <= endIndices.y; y++)
+#if defined(TILEBITE_SIMD_AVX) || defined(TILEBITE_SIMD_SSE)
+    for (uint32_t first = 0; first < rays.size(); first += PacketLanes::Width)
+        raycastPacket<PacketLanes>(rays, first, hitDistances);
+#else
+    for (size_t i = 0; i < rays.size(); i++)
     {
-        for (uint32_t x = startIndices.x; x <= endIndices.x; x++)
-        {
-            uint32_t index = x + y * static_cast<uint32_t>(tilemapSize.x);
-            if (!m_tiles.isSet(index)) continue;
+        raycast(rays[i], [&](const RayHit& hit) {
+            hitDistances[i] = std::min(hitDistances[i], hit.tmin);
+            return false;
+        });
+    }
+#endif
+}
+
+std::optional<ShapeCastHit> TilemapColliderGroup::shapeCast(const Collider& shape, glm::vec2 displacement, float maxToi) const {
+    AABB shapeBounds = shape.getAABBBounds();
+
+    // Only the part of the displacement where the shape bounds overlap the tilemap is walked
+    float tEnter, tExit;
+    if (!CollisionUtilities::sweepInterval(shapeBounds, displacement, m_bounds, tEnter, tExit))
+        return std::nullopt;
+    tEnter = std::max(tEnter, 0.0f);
+    tExit = std::min(tExit, 1.0f);
+    if (tEnter > maxToi)
+        return std::nullopt;
+
+    // Tiles around the one holding the center that the shape bounds can touch
+    glm::vec2 center = 0.5f * (shapeBounds.Min + shapeBounds.Max);
+    glm::vec2 halfExtents = 0.5f * (shapeBounds.Max - shapeBounds.Min);
+    glm::ivec2 window = glm::ivec2(glm::floor(halfExtents / tileSize)) + 1;
+
+    std::optional<ShapeCastHit> closestHit;
+    float bestToi = maxToi;
+    uint32_t lastRectIndex = TileRectMesh::NoRect;
+
+    auto testTiles = [&](glm::ivec2 min, glm::ivec2 max) {
+        min = glm::max(min, glm::ivec2(0));
+        max = glm::min(max, glm::ivec2(tilemapSize) - 1);
+        for (int32_t y = min.y; y <= max.y; y++) {
+            for (int32_t x = min.x; x <= max.x; x++) {
+                if (!m_tiles->isSet(x + y * static_cast<uint32_t>(tilemapSize.x)))
+                    continue;
+
+                CollisionHit hit(m_id, x, y);
+                if (m_rects) {
+                    // Merged rectangles have no inner edges to catch on, test the whole rectangle once
+                    uint32_t rectIndex = m_rects->getRectIndex(x, y);
+                    if (rectIndex == lastRectIndex)
+                        continue;
+                    lastRectIndex = rectIndex;
 
-            glm::vec2 tileMin = m_bounds.Min + glm::vec2(x, y) * tileSize;
-            glm::vec2 tileMax = tileMin + tileSize;
-            results.emplace_back(CollisionData(TilemapCollisionData(m_id, AABB(tileMin, tileMax), x, y)));
+                    const TileRectMesh::Rect& rect = m_rects->getRect(rectIndex);
+                    hit = CollisionHit(m_id, rect.X, rect.Y, rect.Width, rect.Height);
+                }
+
+                float toi;
+                glm::vec2 normal;
+                if (CollisionUtilities::sweep(shape, displacement, Collider(getHitBounds(hit)), toi, normal) &&
+                    (toi < bestToi || (!closestHit && toi <= bestToi))) {
+                    bestToi = toi;
+                    closestHit = ShapeCastHit(hit, toi, normal);
+                }
+            }
         }
+    };
+
+    glm::vec2 start = center + displacement * tEnter;
+    glm::vec2 end = center + displacement * tExit;
+    if (start == end) {
+        glm::ivec2 tile = glm::floor((start - m_bounds.Min) / tileSize);
+        testTiles(tile - window, tile + window);
+        return closestHit;
     }
 
-    return results;
-}
+    GridWalk walk = beginGridWalk(start, end);
+    float invLength = 1.0f / glm::length(displacement);
+    testTiles(walk.Tile - window, walk.Tile + window);
 
-std::vector<RayHitData> TilemapColliderGroup::raycastAll(const Ray2D& ray) const {
-    return ADDSearch(ray, false);
-}
+    while (true) {
+        // Tiles entering the window in the next tile can't be touched before the center gets there
+        float crossingToi = tEnter + std::min(walk.SideDist.x, walk.SideDist.y) * invLength;
+        if (crossingToi > bestToi)
+            break;
 
-std::optional<RayHitData> TilemapColliderGroup::raycastClosest(const Ray2D& ray) const {
-    auto result = ADDSearch(ray, true);
-    return result.size() > 0 ? std::optional(result.back()) : std::nullopt;
+        glm::ivec2 previousTile = walk.Tile;
+        if (!stepGridWalk(walk))
+            break;
+
+        // Only the leading column or row of the window is new
+        if (walk.Tile.x != previousTile.x) {
+            int32_t x = walk.Tile.x + walk.Step.x * window.x;
+            testTiles(glm::ivec2(x, walk.Tile.y - window.y), glm::ivec2(x, walk.Tile.y + window.y));
+        }
+        else {
+            int32_t y = walk.Tile.y + walk.Step.y * window.y;
+            testTiles(glm::ivec2(walk.Tile.x - window.x, y), glm::ivec2(walk.Tile.x + window.x, y));
+        }
+    }
+
+    return closestHit;
 }
 
-std::vector<RayHitData> TilemapColliderGroup::ADDSearch(const Ray2D& ray, bool stopAtFirst) const {
-    std::vector<RayHitData> results;
-    
-    float tmin, tmax;
-    if (!ray.intersect(m_bounds, tmin, tmax))
-        return results;
+template<typename Lanes>
+void TilemapColliderGroup::raycastPacket(std::span<const Ray2D> rays, uint32_t first, std::span<float> hitDistances) const {
+    // Same walk as ADDWalker<true>, one ray per lane. Lanes are active while their ray is within its length.
+    // Stepping is done on all lanes at once, skipping empty blocks and testing the Bitset words is done per lane.
+    using Float = typename Lanes::Float;
+    constexpr uint32_t Width = Lanes::Width;
 
-	float startingT = std::max(0.0f, tmin); // If tmin is negative we are inside the tilemap so we start at 0
-    glm::vec2 rayStart = ray.at(startingT - 0.01f); // Slightly offset to avoid missing first tile
-    glm::vec2 rayEnd = ray.at(ray.getMaxT());
+    alignas(32) float tileX[Width], tileY[Width], stepX[Width], stepY[Width], stepCountX[Width], stepCountY[Width];
+    alignas(32) float sideDistX[Width], sideDistY[Width], startSideDistX[Width], startSideDistY[Width];
+    alignas(32) float deltaDistX[Width], deltaDistY[Width], maxLength[Width], active[Width];
+
+    const float activeLane = std::bit_cast<float>(~0u);
+    uint32_t laneCount = std::min<uint32_t>(Width, uint32_t(rays.size()) - first);
+    for (uint32_t lane = 0; lane < Width; lane++)
+    {
+        glm::vec2 rayStart, rayEnd;
+        bool walking = lane < laneCount && getRayWalkSegment(rays[first + lane], rayStart, rayEnd);
+        GridWalk walk = walking ? beginGridWalk(rayStart, rayEnd)
+            : GridWalk{ glm::ivec2(0), glm::ivec2(0), glm::ivec2(0), glm::vec2(0.0f), glm::vec2(0.0f), glm::vec2(0.0f), 0.0f };
+
+        tileX[lane] = float(walk.Tile.x);
+        tileY[lane] = float(walk.Tile.y);
+        stepX[lane] = float(walk.Step.x);
+        stepY[lane] = float(walk.Step.y);
+        stepCountX[lane] = 0.0f;
+        stepCountY[lane] = 0.0f;
+        sideDistX[lane] = walk.SideDist.x;
+        sideDistY[lane] = walk.SideDist.y;
+        startSideDistX[lane] = walk.StartSideDist.x;
+        startSideDistY[lane] = walk.StartSideDist.y;
+        deltaDistX[lane] = walk.DeltaDist.x;
+        deltaDistY[lane] = walk.DeltaDist.y;
+        maxLength[lane] = walk.MaxLength;
+        active[lane] = walking ? activeLane : 0.0f;
+    }
+
+    Float tileXs = Lanes::load(tileX), tileYs = Lanes::load(tileY);
+    Float stepCountXs = Lanes::load(stepCountX), stepCountYs = Lanes::load(stepCountY);
+    Float sideDistXs = Lanes::load(sideDistX), sideDistYs = Lanes::load(sideDistY);
+    Float activeMask = Lanes::load(active);
+    const Float stepXs = Lanes::load(stepX), stepYs = Lanes::load(stepY);
+    const Float startSideDistXs = Lanes::load(startSideDistX), startSideDistYs = Lanes::load(startSideDistY);
+    const Float deltaDistXs = Lanes::load(deltaDistX), deltaDistYs = Lanes::load(deltaDistY);
+    const Float maxLengths = Lanes::load(maxLength);
+
+    const Float zero = Lanes::set1(0.0f);
+    const Float one = Lanes::set1(1.0f);
+    const Float width = Lanes::set1(tilemapSize.x);
+    const Float height = Lanes::set1(tilemapSize.y);
+    const uint32_t rowStride = uint32_t(tilemapSize.x);
+    std::span<const Bitset::WordType> words = m_tiles->getWords();
+
+    PHYSICS_PROFILE_LOCAL(cellsScanned, TileCellsScanned);
+    while (Lanes::moveMask(activeMask))
+    {
+        // Each lane steps on the axis with the closest grid line, lanes past their length stop
+        Float stepsX = Lanes::lt(sideDistXs, sideDistYs);
+        Float tileDistances = Lanes::select(stepsX, sideDistXs, sideDistYs);
+        activeMask = Lanes::bitAnd(activeMask, Lanes::le(tileDistances, maxLengths));
+
+        stepCountXs = Lanes::add(stepCountXs, Lanes::bitAnd(stepsX, one));
+        stepCountYs = Lanes::add(stepCountYs, Lanes::bitAndNot(stepsX, one));
+        sideDistXs = Lanes::select(stepsX, Lanes::add(startSideDistXs, Lanes::mul(stepCountXs, deltaDistXs)), sideDistXs);
+        sideDistYs = Lanes::select(stepsX, sideDistYs, Lanes::add(startSideDistYs, Lanes::mul(stepCountYs, deltaDistYs)));
+        tileXs = Lanes::add(tileXs, Lanes::bitAnd(stepsX, stepXs));
+        tileYs = Lanes::add(tileYs, Lanes::bitAndNot(stepsX, stepYs));
+
+        // Lanes outside the grid and moving away from it can't hit anything anymore
+        Float leaving = Lanes::bitOr(
+            Lanes::bitOr(Lanes::bitAnd(Lanes::lt(tileXs, zero), Lanes::lt(stepXs, zero)),
+                Lanes::bitAnd(Lanes::ge(tileXs, width), Lanes::lt(zero, stepXs))),
+            Lanes::bitOr(Lanes::bitAnd(Lanes::lt(tileYs, zero), Lanes::lt(stepYs, zero)),
+                Lanes::bitAnd(Lanes::ge(tileYs, height), Lanes::lt(zero, stepYs))));
+        activeMask = Lanes::bitAndNot(leaving, activeMask);
+
+        Float inside = Lanes::bitAnd(
+            Lanes::bitAnd(Lanes::ge(tileXs, zero), Lanes::lt(tileXs, width)),
+            Lanes::bitAnd(Lanes::ge(tileYs, zero), Lanes::lt(tileYs, height)));
+        uint32_t testLanes = Lanes::moveMask(Lanes::bitAnd(activeMask, inside));
+        if (!testLanes) continue;
+
+        Lanes::store(tileX, tileXs);
+        Lanes::store(tileY, tileYs);
+        Lanes::store(stepCountX, stepCountXs);
+        Lanes::store(stepCountY, stepCountYs);
+        Lanes::store(sideDistX, sideDistXs);
+        Lanes::store(sideDistY, sideDistYs);
+        Lanes::store(active, activeMask);
+
+        for (; testLanes; testLanes &= testLanes - 1)
+        {
+            uint32_t lane = std::countr_zero(testLanes);
+            PHYSICS_PROFILE_INC(cellsScanned);
+
+            GridWalk walk{
+                glm::ivec2(int32_t(tileX[lane]), int32_t(tileY[lane])),
+                glm::ivec2(int32_t(stepX[lane]), int32_t(stepY[lane])),
+                glm::ivec2(int32_t(stepCountX[lane]), int32_t(stepCountY[lane])),
+                glm::vec2(sideDistX[lane], sideDistY[lane]),
+                glm::vec2(startSideDistX[lane], startSideDistY[lane]),
+                glm::vec2(deltaDistX[lane], deltaDistY[lane]),
+                maxLength[lane]
+            };
+            if (!skipEmptyBlocks(walk))
+            {
+                active[lane] = 0.0f;
+                continue;
+            }
+
+            tileX[lane] = float(walk.Tile.x);
+            tileY[lane] = float(walk.Tile.y);
+            stepCountX[lane] = float(walk.StepCount.x);
+            stepCountY[lane] = float(walk.StepCount.y);
+            sideDistX[lane] = walk.SideDist.x;
+            sideDistY[lane] = walk.SideDist.y;
+            if (!isTileInside(walk.Tile))
+                continue;
 
-    ADDWalker(rayStart, rayEnd, [&](const glm::ivec2& tile) {
-        if (m_tiles.isSet(tile.x + tile.y * tilemapSize.x)) {
-            AABB tileBounds(
-                m_bounds.Min + glm::vec2(tile) * tileSize,
-                m_bounds.Min + glm::vec2(tile + glm::ivec2(1)) * tileSize
-            );
+            uint32_t idx = uint32_t(walk.Tile.x) + uint32_t(walk.Tile.y) * rowStride;
+            if (!((words[idx / Bitset::BITS_PER_WORD] >> (idx % Bitset::BITS_PER_WORD)) & 1u))
+                continue;
+
+            // Same distance as the scalar raycast reports for the tile
             float tileTmin, tileTmax;
-            ray.intersect(tileBounds, tileTmin, tileTmax);
-            results.push_back(RayHitData(
-                TilemapCollisionData(m_id, tileBounds, tile.x, tile.y),
-                tileTmin, tileTmax)
-            );
+            rays[first + lane].intersect(getTileBounds(walk.Tile.x, walk.Tile.y), tileTmin, tileTmax);
+            hitDistances[first + lane] = std::min(hitDistances[first + lane], tileTmin);
+            active[lane] = 0.0f;
+        }
+
+        tileXs = Lanes::load(tileX);
+        tileYs = Lanes::load(tileY);
+        stepCountXs = Lanes::load(stepCountX);
+        stepCountYs = Lanes::load(stepCountY);
+        sideDistXs = Lanes::load(sideDistX);
+        sideDistYs = Lanes::load(sideDistY);
+        activeMask = Lanes::load(active);
+    }
+}
+
+bool TilemapColliderGroup::skipEmptyBlocks(GridWalk& walk) const {
+    while (isTileInside(walk.Tile))
+    {
+        // Coarsest empty block containing the tile
+        int32_t level = OccupancyPyramid::LevelCount - 1;
+        while (level >= 0 && !m_occupancy->isBlockEmpty(level, walk.Tile.x, walk.Tile.y))
+            level--;
+        if (level < 0) return true;
+
+        int32_t blockSize = 1 << OccupancyPyramid::BlockShifts[level];
+        glm::ivec2 blockMin(walk.Tile.x & ~(blockSize - 1), walk.Tile.y & ~(blockSize - 1));
+
+        // Step counts on each axis once the walk crossed the block boundary on that axis
+        glm::ivec2 exitStepCount;
+        exitStepCount.x = walk.StepCount.x + (walk.Step.x > 0 ? blockMin.x + blockSize - walk.Tile.x : walk.Tile.x - blockMin.x + 1);
+        exitStepCount.y = walk.StepCount.y + (walk.Step.y > 0 ? blockMin.y + blockSize - walk.Tile.y : walk.Tile.y - blockMin.y + 1);
+        float exitDistX = gridLineDistance(walk.StartSideDist.x, walk.DeltaDist.x, exitStepCount.x - 1);
+        float exitDistY = gridLineDistance(walk.StartSideDist.y, walk.DeltaDist.y, exitStepCount.y - 1);
+
+        // Number of steps on an axis before a distance: the walk steps on x while sideDist.x < sideDist.y,
+        // so a y line is crossed before an x line at the same distance. Grid line distances grow with the
+        // step count, so the first line not crossed yet is found with a binary search.
+        auto stepsBefore = [](float startSideDist, float deltaDist, int32_t low, int32_t high, auto&& crossed) {
+            while (low < high)
+            {
+                int32_t mid = low + (high - low) / 2;
+                if (crossed(gridLineDistance(startSideDist, deltaDist, mid))) low = mid + 1;
+                else high = mid;
+            }
+            return low;
+        };
 
-            if (stopAtFirst) return false;
+        glm::ivec2 stepCount;
+        if (exitDistX < exitDistY)
+        {
+            if (exitDistX > walk.MaxLength) return false;
+            stepCount.x = exitStepCount.x;
+            stepCount.y = stepsBefore(walk.StartSideDist.y, walk.DeltaDist.y, walk.StepCount.y, exitStepCount.y - 1,
+                [&](float distance) { return distance <= exitDistX; });
+        }
+        else
+        {
+            if (exitDistY > walk.MaxLength) return false;
+            stepCount.y = exitStepCount.y;
+            stepCount.x = stepsBefore(walk.StartSideDist.x, walk.DeltaDist.x, walk.StepCount.x, exitStepCount.x - 1,
+                [&](float distance) { return distance < exitDistY; });
         }
 
-        return true;
-    });
+        walk.Tile += walk.Step * (stepCount - walk.StepCount);
+        walk.StepCount = stepCount;
+        walk.SideDist.x = gridLineDistance(walk.StartSideDist.x, walk.DeltaDist.x, walk.StepCount.x);
+        walk.SideDist.y = gridLineDistance(walk.StartSideDist.y, walk.DeltaDist.y, walk.StepCount.y);
+    }
 
-    return results;
+    return true;
 }
 
 std::vector<glm::ivec2> TilemapColliderGroup::ADDRasterization(glm::vec2 start, glm::vec2 end) const {
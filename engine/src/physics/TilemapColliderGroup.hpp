@@ -3,132 +3,320 @@
 
 #include "physics/AABB.hpp"
 #include "physics/CollisionData.hpp"
+#include "physics/CollisionFilter.hpp"
 #include "physics/Ray2D.hpp"
+#include "physics/TileRectMesh.hpp"
+#include "physics/PhysicsProfiler.hpp"
 #include "ecs/types/EngineComponents.hpp"
 #include "utilities/Bitset.hpp"
+#include "utilities/OccupancyPyramid.hpp"
+#include "utilities/assertions.hpp"
 
 namespace TileBite {
 
 class TilemapColliderGroup {
 public:
 	TilemapColliderGroup() = default;
-	TilemapColliderGroup(ID tilemapID, const AABB& bounds, glm::vec2 tilemapSize, glm::vec2 tileSize, Bitset solidTiles)
-		: m_bounds(bounds), m_tiles(solidTiles),
-		tilemapSize(tilemapSize), tileSize(tileSize), m_id(tilemapID)
-	{}
+	// solidTiles, solidOccupancy and solidRects are owned by the tilemap resource and must outlive the group,
+	// tile edits made on them are seen by the next query without updating the group.
+	// With solidRects, hits are reported per merged rectangle instead of per tile.
+	TilemapColliderGroup(ID tilemapID, const AABB& bounds, glm::vec2 tilemapSize, glm::vec2 tileSize,
+		const Bitset* solidTiles, const OccupancyPyramid* solidOccupancy, const TileRectMesh* solidRects = nullptr,
+		const CollisionFilter& filter = CollisionFilter())
+		: m_bounds(bounds), tilemapSize(tilemapSize), tileSize(tileSize), m_tiles(solidTiles),
+		m_occupancy(solidOccupancy), m_rects(solidRects), m_id(tilemapID), m_filter(filter)
+	{
+		ASSERT(solidTiles && solidOccupancy, "Tilemap collider group needs the solid tiles of the tilemap");
+	}
 
-    // Generic scaning method within bounding box area with custom collision test for each tile
-    // Implement overloaded function manualy if needing custom implementation
-    template<typename ColliderT>
-    std::vector<CollisionData> query(const ColliderT& collider) const
+    // Generic scaning method within bounding box area with custom collision test for each tile.
+    // Calls visitor(const CollisionHit&) for every overlapping solid tile, stops early if it returns false.
+    template<typename ColliderT, typename Visitor>
+    requires HitVisitor<Visitor, const CollisionHit&>
+    void query(const ColliderT& collider, Visitor&& visitor) const
     {
-        std::vector<CollisionData> results;
+        ASSERT(!m_bounds.isEmpty(), "TilemapColliderGroup bounds cannot be empty");
+
+        // Search area is the collider's bounding box clamped to the tilemap bounds
+        AABB intersectionArea = AABB::intersectionBound(collider.getBoundingBox(), m_bounds);
+        if (intersectionArea.isEmpty()) return;
 
-        // Search are is the collider's bound box in AABB space
-        AABB worldAABB = collider.getBoundingBox();
-        AABB clampedAABB = AABB::intersectionBound(m_bounds, worldAABB);
-        clampedAABB.Min = worldPositionToTileIndices(clampedAABB.Min);
-        clampedAABB.Max = worldPositionToTileIndices(clampedAABB.Max);
-        // Clamped to be within tilemap bounds
+        glm::ivec2 startIndices = worldPositionToTileIndices(intersectionArea.Min);
+        glm::ivec2 endIndices = worldPositionToTileIndices(intersectionArea.Max, -1e-4f);
+        PHYSICS_PROFILE_ADD(TileCellsScanned, uint64_t(endIndices.x - startIndices.x + 1) * uint64_t(endIndices.y - startIndices.y + 1));
+        PHYSICS_PROFILE_LOCAL(satTests, TileSATTests);
 
-        for (int y = clampedAABB.Min.y; y <= clampedAABB.Max.y; ++y)
+        // Rows are scanned 64 tiles at a time from the solid bits, empty spans cost a single word read
+        const uint32_t rowStride = uint32_t(tilemapSize.x);
+        for (uint32_t y = startIndices.y; y <= uint32_t(endIndices.y); ++y)
         {
-            for (int x = clampedAABB.Min.x; x <= clampedAABB.Max.x; ++x)
+            for (uint32_t spanX = startIndices.x; spanX <= uint32_t(endIndices.x); spanX += 64)
             {
-                uint32_t idx = x + y * uint32_t(tilemapSize.x);
-                if (!m_tiles.isSet(idx))
-                    continue;
+                uint32_t spanLength = std::min<uint32_t>(64, uint32_t(endIndices.x) - spanX + 1);
+                uint64_t solidBits = m_tiles->getBits(spanX + y * rowStride, spanLength);
+                while (solidBits)
+                {
+                    uint32_t x = spanX + uint32_t(std::countr_zero(solidBits));
+                    CollisionHit hit(m_id, x, y);
+                    if (m_rects)
+                    {
+                        // The rest of the rectangle row is skipped, each rectangle is reported once
+                        // from its first tile in the search area
+                        const TileRectMesh::Rect& rect = m_rects->getRect(m_rects->getRectIndex(x, y));
+                        uint32_t skippedBits = rect.X + rect.Width - spanX;
+                        solidBits = (skippedBits >= 64) ? 0 : solidBits & ~((uint64_t(1) << skippedBits) - 1);
 
-                glm::vec2 tileMin = m_bounds.Min + glm::vec2(x, y) * tileSize;
-                glm::vec2 tileMax = tileMin + tileSize;
-                AABB tileAABB(tileMin, tileMax);
+                        if (x != std::max<uint32_t>(rect.X, startIndices.x) || y != std::max<uint32_t>(rect.Y, startIndices.y))
+                            continue;
+                        hit = CollisionHit(m_id, rect.X, rect.Y, rect.Width, rect.Height);
+                    }
+                    else
+                    {
+                        solidBits &= solidBits - 1;
+                    }
 
-                // SAT check against each tile AABB collider
-                if (collider.intersects(tileAABB))
-                {
-                    results.emplace_back(
-                        CollisionData(
-                            TilemapCollisionData(m_id, tileAABB, x, y)
-                        )
-                    );
+                    // Every tile in the clamped area overlaps an AABB,
+                    // other shapes run a SAT check against each tile AABB
+                    if constexpr (!std::same_as<ColliderT, AABB>)
+                    {
+                        PHYSICS_PROFILE_INC(satTests);
+                        if (!collider.intersects(getHitBounds(hit)))
+                            continue;
+                    }
+
+                    if (!visitor(hit))
+                        return;
                 }
             }
         }
+    }
+
+    // Appends a hit for every overlapping solid tile to results
+    template<typename ColliderT>
+    void query(const ColliderT& collider, std::vector<CollisionHit>& results) const
+    {
+        query(collider, [&](const CollisionHit& hit) {
+            results.push_back(hit);
+            return true;
+        });
+    }
+
+    template<typename ColliderT>
+    std::vector<CollisionData> query(const ColliderT& collider) const
+    {
+        std::vector<CollisionData> results;
+        query(collider, [&](const CollisionHit& hit) {
+            results.emplace_back(toCollisionData(hit));
+            return true;
+        });
 
         return results;
     }
 
-	std::vector<CollisionData> query(const AABB& collider) const;
+    // Calls visitor(const RayHit&) for every solid tile (or merged rectangle) hit by the ray, closest first.
+    // Stops early if the visitor returns false. Empty blocks of the occupancy pyramid are crossed in one step.
+    template<typename Visitor>
+    requires HitVisitor<Visitor, const RayHit&>
+    void raycast(const Ray2D& ray, Visitor&& visitor) const
+    {
+        glm::vec2 rayStart, rayEnd;
+        if (!getRayWalkSegment(ray, rayStart, rayEnd))
+            return;
+
+        uint32_t lastRectIndex = TileRectMesh::NoRect;
+        ADDWalker<true>(rayStart, rayEnd, [&](const glm::ivec2& tile) {
+            if (!m_tiles->isSet(tile.x + tile.y * tilemapSize.x))
+                return true;
+
+            CollisionHit hit(m_id, tile.x, tile.y);
+            if (m_rects)
+            {
+                // Rectangles are convex, the tiles of one rectangle hit by the ray are consecutive
+                uint32_t rectIndex = m_rects->getRectIndex(tile.x, tile.y);
+                if (rectIndex == lastRectIndex)
+                    return true;
+                lastRectIndex = rectIndex;
+
+                const TileRectMesh::Rect& rect = m_rects->getRect(rectIndex);
+                hit = CollisionHit(m_id, rect.X, rect.Y, rect.Width, rect.Height);
+            }
+
+            float tileTmin, tileTmax;
+            ray.intersect(getHitBounds(hit), tileTmin, tileTmax);
+            return bool(visitor(RayHit(hit, tileTmin, tileTmax)));
+        });
+    }
+
+    // Appends a hit for every solid tile hit by the ray to results, closest first
+    void raycastAll(const Ray2D& ray, std::vector<RayHit>& results) const;
+
+    // Distance to the first solid tile along each ray, hitDistances[i] for rays[i].
+    // Entries are only lowered, so they must be initialized (e.g. to NoHit) and can accumulate
+    // the closest hit over several groups. Rays are walked through the grid in SIMD packets.
+    static constexpr float NoHit = std::numeric_limits<float>::infinity();
+    void raycastFirstHits(std::span<const Ray2D> rays, std::span<float> hitDistances) const;
+
+    // Closest solid tile (or merged rectangle) touched by shape moving along displacement, unless its time
+    // of impact is past maxToi. The center of the shape is walked through the grid and only the tiles that
+    // enter the window its bounds can reach are tested, so the walk stops once no further tile can be closer.
+    std::optional<ShapeCastHit> shapeCast(const Collider& shape, glm::vec2 displacement, float maxToi = 1.0f) const;
+
     std::vector<CollisionData> queryScanline(const OBB& collider) const;
 	std::vector<RayHitData> raycastAll(const Ray2D& ray) const;
 	std::optional<RayHitData> raycastClosest(const Ray2D& ray) const;
+
+	inline AABB getTileBounds(uint32_t x, uint32_t y, uint32_t xSpan = 1, uint32_t ySpan = 1) const
+	{
+		glm::vec2 tileMin = m_bounds.Min + glm::vec2(x, y) * tileSize;
+		return AABB(tileMin, tileMin + glm::vec2(xSpan, ySpan) * tileSize);
+	}
+
+	inline AABB getHitBounds(const CollisionHit& hit) const
+	{
+		return getTileBounds(hit.XTilemapIndex, hit.YTilemapIndex, hit.XTileSpan, hit.YTileSpan);
+	}
+
+	inline TilemapCollisionData toCollisionData(const CollisionHit& hit) const
+	{
+		return TilemapCollisionData(m_id, getHitBounds(hit), hit.XTilemapIndex, hit.YTilemapIndex, hit.XTileSpan, hit.YTileSpan);
+	}
+
+	const AABB& getBounds() const { return m_bounds; }
+	const CollisionFilter& getFilter() const { return m_filter; }
 private:
 	AABB m_bounds; // The bounding box of the tilemap collider group
 	glm::vec2 tilemapSize, tileSize;
 	
-	Bitset m_tiles; // Bitset representing the tiles in the group
+	const Bitset* m_tiles = nullptr; // Bitset representing the tiles in the group
+	const OccupancyPyramid* m_occupancy = nullptr; // Empty block summary of m_tiles
+	const TileRectMesh* m_rects = nullptr; // Merged rectangles of m_tiles, nullptr when tiles are reported one by one
 	ID m_id = INVALID_ID; // Unique ID for the tilemap collider group
+	CollisionFilter m_filter; // Same for every tile
 
-	std::vector<RayHitData> ADDSearch(const Ray2D& ray, bool stopAtFirst) const;
     std::vector<glm::ivec2> ADDRasterization(glm::vec2 start, glm::vec2 end) const;
 
 	glm::ivec2 worldPositionToTileIndices(glm::vec2 position, float epsilon = 0) const;
 	
-    template <typename Callback>
-    void ADDWalker(glm::vec2 start, glm::vec2 end, Callback&& callback) const
+    // DDA state of a segment walk, in tile units except for the distances (world units along the segment).
+    // The distance to a grid line is computed from the number of steps taken on its axis instead of being
+    // accumulated, so that a walk can jump over many tiles and land in the same state as stepping through them.
+    struct GridWalk {
+        glm::ivec2 Tile;
+        glm::ivec2 Step;
+        glm::ivec2 StepCount; // Steps taken on each axis
+        glm::vec2 SideDist; // Distance to the next vertical / horizontal grid line
+        glm::vec2 StartSideDist; // Distance to the first vertical / horizontal grid line
+        glm::vec2 DeltaDist; // Distance between grid lines on each axis
+        float MaxLength;
+    };
+
+    // Distance to the grid line crossed by the (stepCount + 1)th step on an axis
+    static inline float gridLineDistance(float startSideDist, float deltaDist, int32_t stepCount)
+    {
+        // deltaDist is infinite for axis aligned segments, which never step on that axis
+        return stepCount == 0 ? startSideDist : startSideDist + float(stepCount) * deltaDist;
+    }
+
+    GridWalk beginGridWalk(glm::vec2 start, glm::vec2 end) const
     {
         glm::vec2 lineDir = glm::normalize(end - start);
         glm::vec2 lineDirLocal = lineDir / tileSize;
         glm::vec2 rayStartLocal = (start - m_bounds.Min) / tileSize;
 
-        glm::ivec2 currentTile = floor(rayStartLocal);
-        glm::ivec2 step;
-        glm::vec2 sideDist;
-        glm::vec2 deltaDist;
+        GridWalk walk;
+        walk.Tile = floor(rayStartLocal);
+        walk.StepCount = glm::ivec2(0);
+        walk.MaxLength = glm::length(end - start);
 
         // Step size (distance to next grid line in each axis)
-        deltaDist.x = (lineDirLocal.x == 0.0f) ? std::numeric_limits<float>::infinity() : std::abs(1.0f / lineDirLocal.x);
-        deltaDist.y = (lineDirLocal.y == 0.0f) ? std::numeric_limits<float>::infinity() : std::abs(1.0f / lineDirLocal.y);
+        walk.DeltaDist.x = (lineDirLocal.x == 0.0f) ? std::numeric_limits<float>::infinity() : std::abs(1.0f / lineDirLocal.x);
+        walk.DeltaDist.y = (lineDirLocal.y == 0.0f) ? std::numeric_limits<float>::infinity() : std::abs(1.0f / lineDirLocal.y);
 
         // Step direction and initial sideDist
         if (lineDirLocal.x < 0) {
-            step.x = -1;
-            sideDist.x = (rayStartLocal.x - currentTile.x) * deltaDist.x;
+            walk.Step.x = -1;
+            walk.SideDist.x = (rayStartLocal.x - walk.Tile.x) * walk.DeltaDist.x;
         }
         else {
-            step.x = 1;
-            sideDist.x = (currentTile.x + 1.0f - rayStartLocal.x) * deltaDist.x;
+            walk.Step.x = 1;
+            walk.SideDist.x = (walk.Tile.x + 1.0f - rayStartLocal.x) * walk.DeltaDist.x;
         }
 
         if (lineDirLocal.y < 0) {
-            step.y = -1;
-            sideDist.y = (rayStartLocal.y - currentTile.y) * deltaDist.y;
+            walk.Step.y = -1;
+            walk.SideDist.y = (rayStartLocal.y - walk.Tile.y) * walk.DeltaDist.y;
         }
         else {
-            step.y = 1;
-            sideDist.y = (currentTile.y + 1.0f - rayStartLocal.y) * deltaDist.y;
+            walk.Step.y = 1;
+            walk.SideDist.y = (walk.Tile.y + 1.0f - rayStartLocal.y) * walk.DeltaDist.y;
         }
 
-        float tileDistance = 0.0f;
-        float maxLength = glm::length(end - start);
-        while (true) {
-            if (sideDist.x < sideDist.y) {
-                tileDistance = sideDist.x;
-                if (tileDistance > maxLength) break;
-                sideDist.x += deltaDist.x;
-                currentTile.x += step.x;
-            }
-            else {
-                tileDistance = sideDist.y;
-                if (tileDistance > maxLength) break;
-                sideDist.y += deltaDist.y;
-                currentTile.y += step.y;
+        walk.StartSideDist = walk.SideDist;
+        return walk;
+    }
+
+    // Moves the walk to the next tile, false once the next grid line is past the end of the segment
+    inline bool stepGridWalk(GridWalk& walk) const
+    {
+        if (walk.SideDist.x < walk.SideDist.y) {
+            if (walk.SideDist.x > walk.MaxLength) return false;
+            walk.StepCount.x++;
+            walk.SideDist.x = gridLineDistance(walk.StartSideDist.x, walk.DeltaDist.x, walk.StepCount.x);
+            walk.Tile.x += walk.Step.x;
+        }
+        else {
+            if (walk.SideDist.y > walk.MaxLength) return false;
+            walk.StepCount.y++;
+            walk.SideDist.y = gridLineDistance(walk.StartSideDist.y, walk.DeltaDist.y, walk.StepCount.y);
+            walk.Tile.y += walk.Step.y;
+        }
+        return true;
+    }
+
+    // While the walk is in an empty block of the occupancy pyramid, moves it to the first tile past the block.
+    // False if the segment ends before leaving the block.
+    bool skipEmptyBlocks(GridWalk& walk) const;
+
+    inline bool isTileInside(glm::ivec2 tile) const
+    {
+        return tile.x >= 0 && tile.x < tilemapSize.x &&
+            tile.y >= 0 && tile.y < tilemapSize.y;
+    }
+
+    // Segment of the ray to walk through the grid, false if the ray misses the tilemap
+    bool getRayWalkSegment(const Ray2D& ray, glm::vec2& start, glm::vec2& end) const
+    {
+        float tmin, tmax;
+        if (!ray.intersect(m_bounds, tmin, tmax))
+            return false;
+
+        float startingT = std::max(0.0f, tmin); // If tmin is negative we are inside the tilemap so we start at 0
+        start = ray.at(startingT - 0.01f); // Slightly offset to avoid missing first tile
+        end = ray.at(ray.getMaxT());
+        return true;
+    }
+
+    // Walks Width rays of rays (starting at first) in lockstep and lowers their hit distances
+    template<typename Lanes>
+    void raycastPacket(std::span<const Ray2D> rays, uint32_t first, std::span<float> hitDistances) const;
+
+    // Calls callback(const glm::ivec2&) for each tile of the segment, stops early if it returns false.
+    // With SkipEmptyBlocks the tiles of empty pyramid blocks are not reported, for walks that only look for solid tiles.
+    template <bool SkipEmptyBlocks = false, typename Callback>
+    void ADDWalker(glm::vec2 start, glm::vec2 end, Callback&& callback) const
+    {
+        PHYSICS_PROFILE_LOCAL(cellsScanned, TileCellsScanned);
+        GridWalk walk = beginGridWalk(start, end);
+        while (stepGridWalk(walk)) {
+            PHYSICS_PROFILE_INC(cellsScanned);
+            if constexpr (SkipEmptyBlocks)
+            {
+                if (!skipEmptyBlocks(walk)) break;
             }
 
-            if (currentTile.x >= 0 && currentTile.x < tilemapSize.x &&
-                currentTile.y >= 0 && currentTile.y < tilemapSize.y)
+            if (isTileInside(walk.Tile))
             {
-                if (!callback(currentTile)) break;
+                if (!callback(walk.Tile)) break;
             }
         }
     }
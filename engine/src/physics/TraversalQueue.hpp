@@ -0,0 +1,64 @@
+#ifndef TRAVERSAL_QUEUE_HPP
+#define TRAVERSAL_QUEUE_HPP
+
+#include "core/pch.hpp"
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+// Min priority queue of node indices for best first tree traversals, owned by a single query.
+// Same storage as TraversalStack: the first InlineCapacity entries live on the call stack,
+// larger queues move into a heap buffer.
+template<uint32_t InlineCapacity = 64>
+class TraversalQueue {
+public:
+	struct Entry {
+		float Priority;
+		uint32_t Index;
+	};
+
+	inline void push(float priority, uint32_t index)
+	{
+		if (m_size == InlineCapacity && m_overflow.empty())
+			m_overflow.assign(m_inline, m_inline + InlineCapacity);
+
+		if (m_overflow.empty())
+			m_inline[m_size] = Entry{ priority, index };
+		else
+			m_overflow.push_back(Entry{ priority, index });
+		m_size++;
+		std::push_heap(data(), data() + m_size, isLater);
+	}
+
+	inline Entry pop()
+	{
+		ASSERT(m_size > 0, "Popping empty traversal queue");
+		std::pop_heap(data(), data() + m_size, isLater);
+		m_size--;
+		Entry entry = data()[m_size];
+		if (!m_overflow.empty()) m_overflow.pop_back();
+		return entry;
+	}
+
+	inline const Entry& top() const
+	{
+		ASSERT(m_size > 0, "Reading empty traversal queue");
+		return data()[0];
+	}
+
+	inline bool isEmpty() const { return m_size == 0; }
+
+private:
+	Entry m_inline[InlineCapacity];
+	std::vector<Entry> m_overflow;
+	uint32_t m_size = 0;
+
+	static inline bool isLater(const Entry& a, const Entry& b) { return a.Priority > b.Priority; }
+
+	inline Entry* data() { return m_overflow.empty() ? m_inline : m_overflow.data(); }
+	inline const Entry* data() const { return m_overflow.empty() ? m_inline : m_overflow.data(); }
+};
+
+} // TileBite
+
+#endif // !TRAVERSAL_QUEUE_HPP
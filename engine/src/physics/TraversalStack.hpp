@@ -0,0 +1,46 @@
+#ifndef TRAVERSAL_STACK_HPP
+#define TRAVERSAL_STACK_HPP
+
+#include "core/pch.hpp"
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+// Node index stack for tree traversals, owned by a single query.
+// The first InlineCapacity entries live on the call stack, deeper traversals spill into a heap buffer.
+// Since no state is shared between calls, queries can run concurrently from multiple threads.
+template<uint32_t InlineCapacity = 64>
+class TraversalStack {
+public:
+	inline void push(uint32_t index)
+	{
+		if (m_size < InlineCapacity)
+			m_inline[m_size] = index;
+		else
+			m_overflow.push_back(index);
+		m_size++;
+	}
+
+	inline uint32_t pop()
+	{
+		ASSERT(m_size > 0, "Popping empty traversal stack");
+		m_size--;
+		if (m_size < InlineCapacity)
+			return m_inline[m_size];
+
+		uint32_t index = m_overflow.back();
+		m_overflow.pop_back();
+		return index;
+	}
+
+	inline bool isEmpty() const { return m_size == 0; }
+
+private:
+	uint32_t m_inline[InlineCapacity];
+	std::vector<uint32_t> m_overflow;
+	uint32_t m_size = 0;
+};
+
+} // TileBite
+
+#endif // !TRAVERSAL_STACK_HPP
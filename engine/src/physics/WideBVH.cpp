@@ -0,0 +1,246 @@
+#include "physics/WideBVH.hpp"
+
+#include "utilities/SIMD.hpp"
+
+namespace TileBite {
+
+void WideBVH::clear()
+{
+	m_nodes.clear();
+	m_items.clear();
+}
+
+void WideBVH::build(std::vector<ColliderInfo> items)
+{
+	clear();
+	m_items = std::move(items);
+	if (m_items.empty()) return;
+
+	std::vector<BuildItem> buildItems;
+	buildItems.reserve(m_items.size());
+	for (uint32_t i = 0; i < m_items.size(); i++)
+	{
+		AABB bounds = m_items[i].getAABBBounds();
+		buildItems.push_back(BuildItem{ bounds, (bounds.Min + bounds.Max) * 0.5f, i });
+	}
+
+	m_nodes.reserve(m_items.size());
+	buildNode(buildItems, 0, static_cast<uint32_t>(buildItems.size()), 0);
+}
+
+uint32_t WideBVH::buildNode(std::vector<BuildItem>& buildItems, uint32_t begin, uint32_t end, uint32_t depth)
+{
+	uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+	m_nodes.emplace_back();
+
+	// Split the range in up to 4 child ranges by applying the binary SAH split twice.
+	// Small ranges are not split, every item becomes a leaf child instead.
+	std::array<std::pair<uint32_t, uint32_t>, Width> childRanges;
+	uint32_t childCount = 0;
+	if (end - begin <= Width)
+	{
+		for (uint32_t i = begin; i < end; i++)
+			childRanges[childCount++] = { i, i + 1 };
+	}
+	else
+	{
+		uint32_t mid = splitRange(buildItems, begin, end, depth);
+		for (auto [rangeBegin, rangeEnd] : { std::pair{ begin, mid }, std::pair{ mid, end } })
+		{
+			if (rangeEnd - rangeBegin < 2)
+			{
+				childRanges[childCount++] = { rangeBegin, rangeEnd };
+				continue;
+			}
+
+			uint32_t rangeMid = splitRange(buildItems, rangeBegin, rangeEnd, depth);
+			childRanges[childCount++] = { rangeBegin, rangeMid };
+			childRanges[childCount++] = { rangeMid, rangeEnd };
+		}
+	}
+
+	// NOTE: m_nodes may reallocate while building children so the node is written at the end.
+	Node node;
+	for (uint32_t slot = 0; slot < Width; slot++)
+	{
+		if (slot >= childCount)
+		{
+			// Inverted bounds never overlap anything
+			node.MinX[slot] = node.MinY[slot] = std::numeric_limits<float>::max();
+			node.MaxX[slot] = node.MaxY[slot] = -std::numeric_limits<float>::max();
+			node.Children[slot] = NullIndex;
+			continue;
+		}
+
+		auto [rangeBegin, rangeEnd] = childRanges[slot];
+		AABB bounds = rangeBounds(buildItems, rangeBegin, rangeEnd);
+		node.MinX[slot] = bounds.Min.x;
+		node.MinY[slot] = bounds.Min.y;
+		node.MaxX[slot] = bounds.Max.x;
+		node.MaxY[slot] = bounds.Max.y;
+		node.Children[slot] = (rangeEnd - rangeBegin == 1)
+			? (LeafFlag | buildItems[rangeBegin].ItemIndex)
+			: buildNode(buildItems, rangeBegin, rangeEnd, depth + 1);
+	}
+
+	m_nodes[nodeIndex] = node;
+	return nodeIndex;
+}
+
+uint32_t WideBVH::splitRange(std::vector<BuildItem>& buildItems, uint32_t begin, uint32_t end, uint32_t depth) const
+{
+	ASSERT(end - begin >= 2, "Splitting a range with less than 2 items");
+
+	// Sort along the axis with the biggest centroid extent
+	glm::vec2 centroidMin(std::numeric_limits<float>::max());
+	glm::vec2 centroidMax(-std::numeric_limits<float>::max());
+	for (uint32_t i = begin; i < end; i++)
+	{
+		centroidMin = glm::min(centroidMin, buildItems[i].Centroid);
+		centroidMax = glm::max(centroidMax, buildItems[i].Centroid);
+	}
+	int axis = (centroidMax.x - centroidMin.x >= centroidMax.y - centroidMin.y) ? 0 : 1;
+
+	std::sort(buildItems.begin() + begin, buildItems.begin() + end, [axis](const BuildItem& a, const BuildItem& b) {
+		return a.Centroid[axis] < b.Centroid[axis];
+	});
+
+	uint32_t count = end - begin;
+	if (depth >= MaxSAHDepth || centroidMax[axis] == centroidMin[axis])
+		return begin + count / 2;
+
+	// Sweep from the right to store the area of every right partition,
+	// then sweep from the left and keep the cheapest split.
+	// cost(i) = area(left) * leftCount + area(right) * rightCount
+	std::vector<float> rightAreas(count);
+	AABB rightBounds = buildItems[end - 1].Bounds;
+	for (uint32_t i = count - 1; i > 0; i--)
+	{
+		rightBounds = AABB::getUnion(rightBounds, buildItems[begin + i].Bounds);
+		rightAreas[i] = rightBounds.getArea();
+	}
+
+	float bestCost = std::numeric_limits<float>::max();
+	uint32_t bestSplit = count / 2;
+	AABB leftBounds = buildItems[begin].Bounds;
+	for (uint32_t i = 1; i < count; i++)
+	{
+		leftBounds = AABB::getUnion(leftBounds, buildItems[begin + i - 1].Bounds);
+		float cost = leftBounds.getArea() * i + rightAreas[i] * (count - i);
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestSplit = i;
+		}
+	}
+
+	return begin + bestSplit;
+}
+
+AABB WideBVH::rangeBounds(const std::vector<BuildItem>& buildItems, uint32_t begin, uint32_t end)
+{
+	AABB bounds = buildItems[begin].Bounds;
+	for (uint32_t i = begin + 1; i < end; i++)
+		bounds = AABB::getUnion(bounds, buildItems[i].Bounds);
+	return bounds;
+}
+
+uint32_t WideBVH::overlapMask(const Node& node, const AABB& bounds)
+{
+#if defined(TILEBITE_SIMD_SSE)
+	__m128 overlapX = _mm_and_ps(
+		_mm_cmple_ps(_mm_load_ps(node.MinX), _mm_set1_ps(bounds.Max.x)),
+		_mm_cmpge_ps(_mm_load_ps(node.MaxX), _mm_set1_ps(bounds.Min.x)));
+	__m128 overlapY = _mm_and_ps(
+		_mm_cmple_ps(_mm_load_ps(node.MinY), _mm_set1_ps(bounds.Max.y)),
+		_mm_cmpge_ps(_mm_load_ps(node.MaxY), _mm_set1_ps(bounds.Min.y)));
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(overlapX, overlapY)));
+#else
+	uint32_t mask = 0;
+	for (uint32_t slot = 0; slot < Width; slot++)
+	{
+		bool overlaps =
+			node.MinX[slot] <= bounds.Max.x && node.MaxX[slot] >= bounds.Min.x &&
+			node.MinY[slot] <= bounds.Max.y && node.MaxY[slot] >= bounds.Min.y;
+		mask |= uint32_t(overlaps) << slot;
+	}
+	return mask;
+#endif
+}
+
+uint32_t WideBVH::rayMask(const Node& node, const Ray2D& ray, float* tmin, float* tmax)
+{
+	// Same slab test as Ray2D::intersect, boxes behind the ray origin or past maxT are rejected
+	glm::vec2 origin = ray.getOrigin();
+	glm::vec2 invDir = ray.getInvDirection();
+	uint32_t mask = 0;
+
+#if defined(TILEBITE_SIMD_SSE)
+	__m128 originX = _mm_set1_ps(origin.x);
+	__m128 originY = _mm_set1_ps(origin.y);
+	__m128 invDirX = _mm_set1_ps(invDir.x);
+	__m128 invDirY = _mm_set1_ps(invDir.y);
+
+	__m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinX), originX), invDirX);
+	__m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxX), originX), invDirX);
+	__m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MinY), originY), invDirY);
+	__m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.MaxY), originY), invDirY);
+
+	__m128 entry = _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y));
+	__m128 exit = _mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y));
+	_mm_store_ps(tmin, entry);
+	_mm_store_ps(tmax, exit);
+
+	__m128 hit = _mm_and_ps(
+		_mm_and_ps(_mm_cmpge_ps(exit, entry), _mm_cmpge_ps(exit, _mm_setzero_ps())),
+		_mm_cmple_ps(entry, _mm_set1_ps(ray.getMaxT())));
+	mask = static_cast<uint32_t>(_mm_movemask_ps(hit));
+#else
+	for (uint32_t slot = 0; slot < Width; slot++)
+	{
+		float t0x = (node.MinX[slot] - origin.x) * invDir.x;
+		float t1x = (node.MaxX[slot] - origin.x) * invDir.x;
+		float t0y = (node.MinY[slot] - origin.y) * invDir.y;
+		float t1y = (node.MaxY[slot] - origin.y) * invDir.y;
+		tmin[slot] = std::max(std::min(t0x, t1x), std::min(t0y, t1y));
+		tmax[slot] = std::min(std::max(t0x, t1x), std::max(t0y, t1y));
+		bool hit = tmax[slot] >= tmin[slot] && tmax[slot] >= 0.0f && tmin[slot] <= ray.getMaxT();
+		mask |= uint32_t(hit) << slot;
+	}
+#endif
+
+	// Empty slots have inverted bounds which the slab test can not reject on its own
+	for (uint32_t slot = 0; slot < Width; slot++)
+	{
+		if (node.Children[slot] == NullIndex)
+			mask &= ~(1u << slot);
+	}
+
+	return mask;
+}
+
+std::vector<AABB> WideBVH::getInternalBounds() const
+{
+	std::vector<AABB> results;
+	results.reserve(m_nodes.size() * Width);
+	for (const Node& node : m_nodes)
+	{
+		for (uint32_t slot = 0; slot < Width; slot++)
+		{
+			if (node.Children[slot] == NullIndex) continue;
+			results.push_back(AABB(
+				glm::vec2(node.MinX[slot], node.MinY[slot]),
+				glm::vec2(node.MaxX[slot], node.MaxY[slot])
+			));
+		}
+	}
+
+	return results;
+}
+
+std::vector<Collider> WideBVH::getLeafColliders() const
+{
+	return std::vector<Collider>(m_items.begin(), m_items.end());
+}
+
+} // TileBite
@@ -0,0 +1,154 @@
+#ifndef WIDE_BVH_HPP
+#define WIDE_BVH_HPP
+
+#include "core/pch.hpp"
+#include "physics/AABB.hpp"
+#include "physics/Ray2D.hpp"
+#include "physics/AABBTree.hpp"
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+// Build once, 4-ary bounding volume hierarchy for static content (eg: tilemap bounds).
+// Unlike AABBTree it does not support incremental updates, the whole hierarchy is rebuilt
+// top down with SAH (surface area heuristic) when the content changes.
+// Bounds of the children of each node are packed in SoA fashion so that all of them
+// are tested against a query with a single SIMD operation.
+class WideBVH {
+public:
+	static constexpr uint32_t Width = 4;
+
+	void build(std::vector<ColliderInfo> items);
+	void clear();
+
+	bool isEmpty() const { return m_nodes.empty(); }
+
+	// Calls callback(const ColliderInfo&) for every item whose bounds overlap bounds.
+	// Traversal stops early if the callback returns false.
+	template<typename Callback>
+	void query(const AABB& bounds, Callback&& callback) const
+	{
+		if (isEmpty()) return;
+
+		uint32_t nodeStack[MaxStackSize];
+		uint32_t stackSize = 0;
+		nodeStack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node = m_nodes[nodeStack[--stackSize]];
+
+			uint32_t hits = overlapMask(node, bounds);
+			while (hits)
+			{
+				uint32_t slot = std::countr_zero(hits);
+				hits &= hits - 1;
+
+				uint32_t child = node.Children[slot];
+				if (child & LeafFlag)
+				{
+					if (!callback(m_items[child & ~LeafFlag])) return;
+				}
+				else
+				{
+					ASSERT(stackSize < MaxStackSize, "WideBVH traversal stack overflow");
+					nodeStack[stackSize++] = child;
+				}
+			}
+		}
+	}
+
+	// Calls callback(const ColliderInfo&, float tmin, float tmax) for every item whose bounds
+	// are hit by the ray. Closer children are visited first.
+	// Traversal stops early if the callback returns false.
+	template<typename Callback>
+	void raycast(const Ray2D& ray, Callback&& callback) const
+	{
+		if (isEmpty()) return;
+
+		uint32_t nodeStack[MaxStackSize];
+		uint32_t stackSize = 0;
+		nodeStack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const Node& node = m_nodes[nodeStack[--stackSize]];
+
+			alignas(16) float tmin[Width];
+			alignas(16) float tmax[Width];
+			uint32_t hits = rayMask(node, ray, tmin, tmax);
+
+			// Sort hit slots by entry distance (at most 4 entries)
+			uint32_t order[Width];
+			uint32_t hitCount = 0;
+			while (hits)
+			{
+				uint32_t slot = std::countr_zero(hits);
+				hits &= hits - 1;
+
+				uint32_t i = hitCount++;
+				while (i > 0 && tmin[order[i - 1]] > tmin[slot])
+				{
+					order[i] = order[i - 1];
+					i--;
+				}
+				order[i] = slot;
+			}
+
+			// Leaves are reported closest first, inner nodes are pushed furthest first
+			// so the closest one is popped next.
+			for (uint32_t i = 0; i < hitCount; i++)
+			{
+				uint32_t slot = order[i];
+				uint32_t child = node.Children[slot];
+				if ((child & LeafFlag) && !callback(m_items[child & ~LeafFlag], tmin[slot], tmax[slot]))
+					return;
+			}
+			for (uint32_t i = hitCount; i > 0; i--)
+			{
+				uint32_t child = node.Children[order[i - 1]];
+				if (child & LeafFlag) continue;
+
+				ASSERT(stackSize < MaxStackSize, "WideBVH traversal stack overflow");
+				nodeStack[stackSize++] = child;
+			}
+		}
+	}
+
+	std::vector<AABB> getInternalBounds() const;
+	std::vector<Collider> getLeafColliders() const;
+
+private:
+	constexpr static uint32_t NullIndex = UINT32_MAX;
+	constexpr static uint32_t LeafFlag = 0x80000000;
+	constexpr static uint32_t MaxStackSize = 256;
+	constexpr static uint32_t MaxSAHDepth = 32; // Deeper ranges use median splits to bound the stack size
+
+	struct alignas(16) Node {
+		float MinX[Width];
+		float MinY[Width];
+		float MaxX[Width];
+		float MaxY[Width];
+		uint32_t Children[Width]; // Node index, (LeafFlag | item index) or NullIndex for empty slots
+	};
+
+	struct BuildItem {
+		AABB Bounds;
+		glm::vec2 Centroid;
+		uint32_t ItemIndex;
+	};
+
+	std::vector<Node> m_nodes;
+	std::vector<ColliderInfo> m_items;
+
+	uint32_t buildNode(std::vector<BuildItem>& buildItems, uint32_t begin, uint32_t end, uint32_t depth);
+	uint32_t splitRange(std::vector<BuildItem>& buildItems, uint32_t begin, uint32_t end, uint32_t depth) const;
+	static AABB rangeBounds(const std::vector<BuildItem>& buildItems, uint32_t begin, uint32_t end);
+
+	static uint32_t overlapMask(const Node& node, const AABB& bounds);
+	static uint32_t rayMask(const Node& node, const Ray2D& ray, float* tmin, float* tmax);
+};
+
+} // TileBite
+
+#endif // !WIDE_BVH_HPP
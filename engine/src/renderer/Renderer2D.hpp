@@ -43,6 +43,10 @@ public:
 
 	virtual void setViewportSize(uint32_t width, uint32_t height) {}
 
+	// Sprites drawn as instances of one quad, expanded and rotated on the GPU (on by default)
+	virtual void setSpriteInstancing(bool /*enabled*/) {}
+	virtual bool isSpriteInstancing() const { return false; }
+
 	static std::unique_ptr<Renderer2D> createRenderer2D(SystemResourceHub& systemResourceHub);
 
 protected:
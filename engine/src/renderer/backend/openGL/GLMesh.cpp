@@ -33,10 +33,18 @@ GLenum GLMesh::getOpenGLBaseType(ShaderAttributeType type) {
 	}
 }
 
-GLMesh::GLMesh(uint32_t size, uint32_t indicesCount)
-	: m_indexBuffer(indicesCount), m_vertexBuffer(size)
+GLMesh::GLMesh(uint32_t size, uint32_t indicesCount, uint32_t instanceSize, StreamedBuffer streamed)
+	: m_indexBuffer(indicesCount), m_vertexBuffer(streamed == StreamedBuffer::Vertex ? 0 : size), m_streamed(streamed)
 {
+	ASSERT(streamed != StreamedBuffer::Instance || instanceSize > 0, "Streamed instance buffer needs a size");
+
 	GL(glCreateVertexArrays(1, &m_glVAO));
+	if (streamed == StreamedBuffer::Vertex)
+		m_streamBuffer = std::make_unique<GLStreamBuffer>(size);
+	else if (streamed == StreamedBuffer::Instance)
+		m_streamBuffer = std::make_unique<GLStreamBuffer>(instanceSize);
+	else if (instanceSize > 0)
+		m_instanceBuffer = std::make_unique<GLVBO>(instanceSize);
 }
 
 GLMesh::~GLMesh()
@@ -46,6 +54,7 @@ GLMesh::~GLMesh()
 
 void GLMesh::setVertexData(const void* data, size_t size)
 {
+	ASSERT(m_streamed != StreamedBuffer::Vertex, "Streamed vertex data is written with mapStream");
 	m_vertexBuffer.setData(data, size);
 }
 
@@ -59,6 +68,31 @@ void GLMesh::setIndexData(const uint32_t* data, size_t count)
 	m_indexBuffer.setData(data, count);
 }
 
+void GLMesh::setInstanceData(const void* data, size_t size)
+{
+	ASSERT(m_instanceBuffer != nullptr, "Mesh created without a (non streamed) instance buffer");
+	m_instanceBuffer->setData(data, size);
+}
+
+uint8_t* GLMesh::mapStream()
+{
+	ASSERT(m_streamBuffer != nullptr, "Mesh created without a streamed buffer");
+	return m_streamBuffer->map();
+}
+
+void GLMesh::unmapStream()
+{
+	ASSERT(m_streamStride > 0, "Streamed buffer attributes not set up");
+	m_streamFirst = m_streamBuffer->unmap() / m_streamStride;
+}
+
+void GLMesh::setStreamStride(uint32_t stride)
+{
+	// Draws start at the region offset in vertices / instances, regions must hold whole ones
+	ASSERT(m_streamBuffer->getRegionSize() % stride == 0, "Streamed buffer size must be a multiple of its stride");
+	m_streamStride = stride;
+}
+
 void GLMesh::bind()
 {
 	GL(glBindVertexArray(m_glVAO));
@@ -74,9 +108,41 @@ void GLMesh::setupAttributes(const VertexLayout& layout, GLuint shaderProgram)
 	// Bind (VAO)
 	GL(glBindVertexArray(m_glVAO)); 
 
-	m_vertexBuffer.bind();
+	if (m_streamed == StreamedBuffer::Vertex)
+	{
+		m_streamBuffer->bind();
+		setStreamStride(layout.getStride());
+	}
+	else
+	{
+		m_vertexBuffer.bind();
+	}
 	m_indexBuffer.bind();
 
+	setupAttributePointers(layout, shaderProgram, 0);
+}
+
+void GLMesh::setupInstanceAttributes(const VertexLayout& layout, GLuint shaderProgram)
+{
+	ASSERT(m_instanceBuffer != nullptr || m_streamed == StreamedBuffer::Instance, "Mesh created without an instance buffer");
+	GL(glBindVertexArray(m_glVAO));
+
+	if (m_streamed == StreamedBuffer::Instance)
+	{
+		m_streamBuffer->bind();
+		setStreamStride(layout.getStride());
+	}
+	else
+	{
+		m_instanceBuffer->bind();
+	}
+
+	setupAttributePointers(layout, shaderProgram, 1);
+}
+
+void GLMesh::setupAttributePointers(const VertexLayout& layout, GLuint shaderProgram, GLuint divisor)
+{
+	// Pointers read from the buffer bound to GL_ARRAY_BUFFER
 	for (const auto& attribute : layout.getLayout())
 	{
 		GLint location;
@@ -109,6 +175,10 @@ void GLMesh::setupAttributes(const VertexLayout& layout, GLuint shaderProgram)
 				(const void*)(uintptr_t)attribute.Offset
 			));
 		}
+
+		// Advance once per instance instead of once per vertex
+		if (divisor > 0)
+			GL(glVertexAttribDivisor(location, divisor));
 	}
 }
 
@@ -116,14 +186,43 @@ void GLMesh::drawIndexed(uint32_t indicesCount)
 {
 	// Draw using index buffer (EBO)
 	GL(glBindVertexArray(m_glVAO));
-	GL(glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, nullptr));
+	if (m_streamed == StreamedBuffer::Vertex)
+	{
+		// Indices are relative to the region written last
+		GL(glDrawElementsBaseVertex(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, nullptr, m_streamFirst));
+		m_streamBuffer->fence();
+	}
+	else
+	{
+		GL(glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, nullptr));
+	}
+}
+
+void GLMesh::drawIndexedInstanced(uint32_t indicesCount, uint32_t instanceCount)
+{
+	GL(glBindVertexArray(m_glVAO));
+	if (m_streamed == StreamedBuffer::Instance && m_streamFirst > 0)
+	{
+		// Instances are read from the region written last
+		GL(glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, nullptr, instanceCount, m_streamFirst));
+	}
+	else
+	{
+		GL(glDrawElementsInstanced(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, nullptr, instanceCount));
+	}
+
+	if (m_streamed == StreamedBuffer::Instance)
+		m_streamBuffer->fence();
 }
 
 void GLMesh::drawLines(uint32_t verticesCount)
 {
 	GL(glLineWidth(0.3f)); // TODO: Make line width configurable 
 	GL(glBindVertexArray(m_glVAO));
-	GL(glDrawArrays(GL_LINES, 0, verticesCount));
+	GL(glDrawArrays(GL_LINES, m_streamed == StreamedBuffer::Vertex ? m_streamFirst : 0, verticesCount));
+
+	if (m_streamed == StreamedBuffer::Vertex)
+		m_streamBuffer->fence();
 }
 
 } // TileBite
\ No newline at end of file
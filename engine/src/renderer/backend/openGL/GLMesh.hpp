@@ -5,23 +5,41 @@
 #include "renderer/backend/openGL/GLWrapper.hpp"
 #include "renderer/backend/openGL/GLVBO.hpp"
 #include "renderer/backend/openGL/GLEBO.hpp"
+#include "renderer/backend/openGL/GLStreamBuffer.hpp"
 #include "renderer/VertexLayout.hpp"
 
 namespace TileBite {
 
+// Buffer of a mesh rewritten for every draw, see GLStreamBuffer
+enum class StreamedBuffer {
+	None,
+	Vertex,
+	Instance
+};
+
 // OpenGL Mesh is a VAO holding VBOs and EBOs
+// An instance buffer of instanceSize bytes is added when instanceSize > 0, its attributes advance once per instance.
+// The streamed buffer (if any) is not set with set*Data but written in place between mapStream() and unmapStream(),
+// the next draw reads what was written.
 class GLMesh {
 public:
-	GLMesh(uint32_t size, uint32_t indicesCount);
+	GLMesh(uint32_t size, uint32_t indicesCount, uint32_t instanceSize = 0, StreamedBuffer streamed = StreamedBuffer::None);
 	~GLMesh();
 
 	void setVertexData(const void* data, size_t size);
 	void setSubVertexData(const void* data, size_t size, size_t offset);
 	void setIndexData(const uint32_t* data, size_t count);
+	void setInstanceData(const void* data, size_t size);
+
+	// Writable memory of the size given for the streamed buffer
+	uint8_t* mapStream();
+	void unmapStream();
 
 	void setupAttributes(const VertexLayout& layout, GLuint shaderProgram);
+	void setupInstanceAttributes(const VertexLayout& layout, GLuint shaderProgram);
 
 	void drawIndexed(uint32_t indicesCount);
+	void drawIndexedInstanced(uint32_t indicesCount, uint32_t instanceCount);
 	void drawLines(uint32_t verticesCount);
 
 	void bind();
@@ -29,8 +47,16 @@ public:
 private:
 	GLVBO m_vertexBuffer;
 	GLEBO m_indexBuffer;
+	std::unique_ptr<GLVBO> m_instanceBuffer;
+	std::unique_ptr<GLStreamBuffer> m_streamBuffer;
+	StreamedBuffer m_streamed;
+	uint32_t m_streamStride = 0;
+	uint32_t m_streamFirst = 0; // First vertex / instance of the last unmapped region
 	GLuint m_glVAO;
 
+	void setupAttributePointers(const VertexLayout& layout, GLuint shaderProgram, GLuint divisor);
+	void setStreamStride(uint32_t stride);
+
 	static GLenum getOpenGLBaseType(ShaderAttributeType type);
 };
 
@@ -154,6 +154,10 @@ void GLRenderer2D::setupShaders()
 	m_spriteProgramHandle.watch();
 	m_spriteProgramHandle.load();
 
+	m_spriteInstancedProgramHandle = m_resourceHub.getManager<GLProgram>().getResource(ResourceNames::SpriteInstancedShader);
+	m_spriteInstancedProgramHandle.watch();
+	m_spriteInstancedProgramHandle.load();
+
 	m_tilemapProgramHandle = m_resourceHub.getManager<GLProgram>().getResource(ResourceNames::TilemapShader);
 	m_tilemapProgramHandle.watch();
 	m_tilemapProgramHandle.load();
@@ -165,11 +169,11 @@ void GLRenderer2D::setupShaders()
 	// Setup a uniform texture sampler array in the fragment shader
 	// Each slot corresponds to an array index
 	// eg: slot 0 -> uTextures[0]
-	auto* spriteProgram = m_spriteProgramHandle.getResource();
 	const uint8_t textureSlots = numberOfGPUSlots();
 	std::vector<int> samplers(textureSlots);
 	for (uint8_t i = 0; i < textureSlots; ++i) samplers[i] = i;
-	spriteProgram->setUniform("uTextures", samplers.data(), textureSlots);
+	m_spriteProgramHandle.getResource()->setUniform("uTextures", samplers.data(), textureSlots);
+	m_spriteInstancedProgramHandle.getResource()->setUniform("uTextures", samplers.data(), textureSlots);
 }
 
 void GLRenderer2D::setupBuffers()
@@ -186,15 +190,50 @@ void GLRenderer2D::setupBuffers()
 	spriteLayout.add(VertexAttribute("aColor", ShaderAttributeType::Float4));
 	spriteLayout.add(VertexAttribute("aUV", ShaderAttributeType::Float2));
 	spriteLayout.add(VertexAttribute("aTextureIndex", ShaderAttributeType::Float));
+	// Batches are written straight into a streamed vertex buffer (see GLStreamBuffer)
 	m_spritesBatch = std::make_unique<GLMesh>(
 		spriteLayout.getStride() * verticesPerQuad * maxQuadsPerBatch,
-		quadsIndicesCount
+		quadsIndicesCount,
+		0,
+		StreamedBuffer::Vertex
 	);
 
 	auto* spriteProgram = m_spriteProgramHandle.getResource();
 	m_spritesBatch->setupAttributes(spriteLayout, spriteProgram->getGLID());
 	m_spritesBatch->setIndexData(indexData.data(), indexData.size());
-	m_spriteVertexData.resize(maxQuadsPerBatch * verticesPerQuad * spriteLayout.getStride());
+
+	// Instanced sprites
+	// One static unit quad (same corners order as makeSpriteQuadVertices) and a SpriteInstance per sprite
+	constexpr std::array<float, 8> unitQuad = {
+		-0.5f,  0.5f, // top-left
+		 0.5f,  0.5f, // top-right
+		 0.5f, -0.5f, // bottom-right
+		-0.5f, -0.5f  // bottom-left
+	};
+	auto quadIndices = makeIndices(indicesPerQuad, verticesPerQuad, indicesPerQuad, 1);
+
+	VertexLayout quadLayout;
+	quadLayout.add(VertexAttribute("aCorner", ShaderAttributeType::Float2));
+	VertexLayout instanceLayout;
+	instanceLayout.add(VertexAttribute("aPosition", ShaderAttributeType::Float2));
+	instanceLayout.add(VertexAttribute("aSize", ShaderAttributeType::Float2));
+	instanceLayout.add(VertexAttribute("aRotation", ShaderAttributeType::Float));
+	instanceLayout.add(VertexAttribute("aPackedColor", ShaderAttributeType::UInt));
+	instanceLayout.add(VertexAttribute("aUVRect", ShaderAttributeType::Float4));
+	instanceLayout.add(VertexAttribute("aTextureIndex", ShaderAttributeType::UInt));
+	ASSERT(instanceLayout.getStride() == sizeof(SpriteInstance), "Instance layout does not match SpriteInstance");
+	m_spriteInstancesBatch = std::make_unique<GLMesh>(
+		sizeof(unitQuad),
+		indicesPerQuad,
+		sizeof(SpriteInstance) * maxSpriteInstancesPerBatch,
+		StreamedBuffer::Instance
+	);
+
+	auto* spriteInstancedProgram = m_spriteInstancedProgramHandle.getResource();
+	m_spriteInstancesBatch->setupAttributes(quadLayout, spriteInstancedProgram->getGLID());
+	m_spriteInstancesBatch->setupInstanceAttributes(instanceLayout, spriteInstancedProgram->getGLID());
+	m_spriteInstancesBatch->setVertexData(unitQuad.data(), sizeof(unitQuad));
+	m_spriteInstancesBatch->setIndexData(quadIndices.data(), quadIndices.size());
 
 	// Tilemap
 	// tilemap layout is created upon request in renderQuadMeshes
@@ -205,12 +244,13 @@ void GLRenderer2D::setupBuffers()
 	lineLayout.add(VertexAttribute("aColor", ShaderAttributeType::Float4));
 	m_linesBatch = std::make_unique<GLMesh>(
 		lineLayout.getStride() * verticesPerLine * maxLinesPerBatch,
-		0 // Not using index buffer for line drawing (EBO will not be init)
+		0, // Not using index buffer for line drawing (EBO will not be init)
+		0,
+		StreamedBuffer::Vertex
 	);
 
 	auto* lineProgram = m_lineProgramHandle.getResource();
 	m_linesBatch->setupAttributes(lineLayout, lineProgram->getGLID());
-	m_linesVertexData.resize(maxLinesPerBatch * verticesPerLine * lineLayout.getStride());
 }
 
 void GLRenderer2D::setupTextures()
@@ -233,6 +273,9 @@ bool GLRenderer2D::terminate()
 	m_spriteProgramHandle.unwatch();
 	m_spriteProgramHandle.unload();
 
+	m_spriteInstancedProgramHandle.unwatch();
+	m_spriteInstancedProgramHandle.unload();
+
 	m_tilemapProgramHandle.unwatch();
 	m_tilemapProgramHandle.unload();
 
@@ -253,22 +296,46 @@ void GLRenderer2D::clearScreen()
 	GL(glClear(GL_COLOR_BUFFER_BIT));
 }
 
-void GLRenderer2D::drawSpritesBatch(uint32_t& quadsCount, uint32_t& bytes, int& drawCalls)
+void GLRenderer2D::setSpriteInstancing(bool enabled)
+{
+	m_spriteInstancing = enabled;
+	// The texture mapping uniform is per program
+	m_textureSlotManager.setDirty(true);
+}
+
+GLProgram* GLRenderer2D::getSpriteProgram()
+{
+	return m_spriteInstancing ? m_spriteInstancedProgramHandle.getResource() : m_spriteProgramHandle.getResource();
+}
+
+GLMesh& GLRenderer2D::getSpritesBatch()
+{
+	return m_spriteInstancing ? *m_spriteInstancesBatch : *m_spritesBatch;
+}
+
+void GLRenderer2D::drawSpritesBatch(uint32_t& quadsCount, uint32_t& bytes, uint8_t*& mappedData, int& drawCalls)
 {
-	m_spritesBatch->bind();
-	m_spritesBatch->setVertexData(m_spriteVertexData.data(), bytes);
+	if (quadsCount == 0) return; // Nothing written (texture slot change before the first sprite)
+
+	GLMesh& batch = getSpritesBatch();
+	batch.bind();
+	batch.unmapStream();
+	mappedData = nullptr;
 
 	if (m_textureSlotManager.isDirty())
 	{
 		// Update uniform buffer to correspond to the current texture slots
-		auto* spriteProgram = m_spriteProgramHandle.getResource();
+		auto* spriteProgram = getSpriteProgram();
 		auto mapping = m_textureSlotManager.createTextureMapping(maxTextures);
 		spriteProgram->setUniform("uTexSlotMap", mapping.data(), maxTextures);
 
 		m_textureSlotManager.setDirty(false);
 	}
 
-	m_spritesBatch->drawIndexed(quadsCount * 6);
+	if (m_spriteInstancing)
+		batch.drawIndexedInstanced(indicesPerQuad, quadsCount);
+	else
+		batch.drawIndexed(quadsCount * 6);
 
 	quadsCount = 0;
 	bytes = 0;
@@ -298,28 +365,42 @@ void GLRenderer2D::render(CameraController& camera)
 	renderLines(camera);
 }
 
-void GLRenderer2D::renderLines(CameraController& camera)
+void GLRenderer2D::drawLinesBatch(uint32_t& linesCount, uint8_t*& mappedData, int& drawCalls)
 {
-	// TODO: Optimize line rendering by batching
+	m_linesBatch->bind();
+	m_linesBatch->unmapStream();
+	m_linesBatch->drawLines(linesCount * verticesPerLine);
+
+	mappedData = nullptr;
+	linesCount = 0;
+	drawCalls++;
+}
 
+void GLRenderer2D::renderLines(CameraController& camera)
+{
 	GLProgram* program = m_lineProgramHandle.getResource();
 	program->use();
 	camera.recalculate();
 	program->setUniform("uViewProjection", camera.getViewProjectionMatrix());
 
 	int drawCalls = 0;
+	uint32_t linesCount = 0;
+	uint8_t* mappedData = nullptr;
 	for (const auto& command : m_lineDrawCommands)
 	{
 		if (shouldCullLine(command, camera)) continue;
 
+		if (!mappedData) mappedData = m_linesBatch->mapStream();
 		auto lineVertices = makeLineVerticesColored(command.Start, command.End, command.Color);
-		m_linesBatch->bind();
-		m_linesBatch->setVertexData(lineVertices.data(), lineVertices.size() * sizeof(float));
-		m_linesBatch->drawLines(2);
+		memcpy(mappedData + linesCount * sizeof(lineVertices), lineVertices.data(), sizeof(lineVertices));
+		linesCount++;
 
-		drawCalls++;
+		if (linesCount == maxLinesPerBatch) drawLinesBatch(linesCount, mappedData, drawCalls);
 	}
 
+	// Render last remaining batch if it contains data
+	if (linesCount) drawLinesBatch(linesCount, mappedData, drawCalls);
+
 	m_lineDrawCommands.clear();
 }
 
@@ -407,7 +488,7 @@ void GLRenderer2D::renderTilemaps(CameraController& camera)
 
 void GLRenderer2D::renderSpriteQuads(CameraController& camera)
 {
-	GLProgram* program = m_spriteProgramHandle.getResource();
+	GLProgram* program = getSpriteProgram();
 	program->use();
 	camera.recalculate();
 	program->setUniform("uViewProjection", camera.getViewProjectionMatrix());
@@ -416,6 +497,7 @@ void GLRenderer2D::renderSpriteQuads(CameraController& camera)
 
 	uint32_t vertexPos = 0;
 	uint32_t quadsCount = 0;
+	uint8_t* mappedData = nullptr; // Region of the streamed batch buffer being written
 
 	uint8_t previousTextureSlot = 0;
 	ID previousTextureID = 0;
@@ -461,9 +543,9 @@ void GLRenderer2D::renderSpriteQuads(CameraController& camera)
 			newSlotAdded = true;
 		}
 
-		bool maxQuadsReached = quadsCount == maxQuadsPerBatch;
+		bool maxQuadsReached = quadsCount == (m_spriteInstancing ? maxSpriteInstancesPerBatch : maxQuadsPerBatch);
 		bool shouldFlush = maxQuadsReached || batchTextureSlotChange;
-		if (shouldFlush) drawSpritesBatch(quadsCount, vertexPos, drawCalls);
+		if (shouldFlush) drawSpritesBatch(quadsCount, vertexPos, mappedData, drawCalls);
 		if (newSlotAdded)
 		{
 			// Change slot state after drawing potentional batch so mapping is correct
@@ -471,10 +553,20 @@ void GLRenderer2D::renderSpriteQuads(CameraController& camera)
 			bindTextureToSlot(currentTextureID, textureSlot);
 		}
 
-		auto vertices = makeSpriteQuadVertices(command.TransformComp, command.SpriteComp);
-		int verticesSizeInBytes = vertices.size() * sizeof(float);
-		memcpy(m_spriteVertexData.data() + vertexPos, vertices.data(), verticesSizeInBytes);
-		vertexPos += verticesSizeInBytes;
+		// Written straight into GPU visible memory, never read back
+		if (!mappedData) mappedData = getSpritesBatch().mapStream();
+		if (m_spriteInstancing)
+		{
+			// Rotation and corners are left to the vertex shader
+			reinterpret_cast<SpriteInstance*>(mappedData)[quadsCount] = makeSpriteInstance(command.TransformComp, command.SpriteComp);
+		}
+		else
+		{
+			auto vertices = makeSpriteQuadVertices(command.TransformComp, command.SpriteComp);
+			int verticesSizeInBytes = vertices.size() * sizeof(float);
+			memcpy(mappedData + vertexPos, vertices.data(), verticesSizeInBytes);
+			vertexPos += verticesSizeInBytes;
+		}
 		quadsCount++;
 		m_textureSlotManager.incrementSlotCounter(textureSlot);
 
@@ -484,7 +576,7 @@ void GLRenderer2D::renderSpriteQuads(CameraController& camera)
 	}
 
 	// Render last remaining batch if it contains data
-	if (quadsCount) drawSpritesBatch(quadsCount, vertexPos, drawCalls);
+	if (quadsCount) drawSpritesBatch(quadsCount, vertexPos, mappedData, drawCalls);
 
 	//LOG_INFO("DrawCalls: {}", drawCalls);
 	m_spriteDrawCommands.clear();
@@ -6,6 +6,7 @@
 #include "renderer/backend/openGL/GLResourceHub.hpp"
 #include "renderer/backend/openGL/GLMesh.hpp"
 #include "renderer/backend/openGL/GLGPUAssets.hpp"
+#include "utilities/misc.hpp"
 
 namespace TileBite {
 
@@ -15,6 +16,7 @@ constexpr uint32_t maxQuadsPerBatch = 1024;
 constexpr uint32_t quadsIndicesCount = 6 * maxQuadsPerBatch;
 constexpr uint32_t verticesPerQuad = 4;
 constexpr uint32_t indicesPerQuad = 6;
+constexpr uint32_t maxSpriteInstancesPerBatch = 16384; // Instances share the quad indices, batches are only bounded by memory
 constexpr uint32_t maxLinesPerBatch = 1024;
 constexpr uint32_t verticesPerLine = 2;
 
@@ -32,6 +34,9 @@ public:
 
 	virtual IGPUAssets& getGPUAssets() override { return m_gpuAssets; }
 
+	virtual void setSpriteInstancing(bool enabled) override;
+	virtual bool isSpriteInstancing() const override { return m_spriteInstancing; }
+
 private:
 	GLResourceHub m_resourceHub;
 	GLGPUAssets m_gpuAssets;
@@ -39,11 +44,12 @@ private:
 	std::unordered_map<ID, std::unique_ptr<GLMesh>> m_tilemapBuffers;
 
 	std::unique_ptr<GLMesh> m_spritesBatch;
+	std::unique_ptr<GLMesh> m_spriteInstancesBatch;
 	std::unique_ptr<GLMesh> m_linesBatch;
-	std::vector<uint8_t> m_spriteVertexData;
-	std::vector<uint8_t> m_linesVertexData;
+	bool m_spriteInstancing = true;
 
 	ResourceHandle<GLProgram> m_spriteProgramHandle;
+	ResourceHandle<GLProgram> m_spriteInstancedProgramHandle;
 	ResourceHandle<GLProgram> m_tilemapProgramHandle;
 	ResourceHandle<GLProgram> m_lineProgramHandle;
 	ResourceHandle<GLTexture> m_fallbackTexture;
@@ -51,10 +57,13 @@ private:
 	void setupShaders();
 	void setupBuffers();
 	void setupTextures();
-	void drawSpritesBatch(uint32_t& quadsCount, uint32_t& bytes, int& drawCalls);
+	void drawSpritesBatch(uint32_t& quadsCount, uint32_t& bytes, uint8_t*& mappedData, int& drawCalls);
+	void drawLinesBatch(uint32_t& linesCount, uint8_t*& mappedData, int& drawCalls);
 	void bindTextureToSlot(ID textureID, uint8_t slot);
 
 	uint8_t numberOfGPUSlots() const;
+	GLProgram* getSpriteProgram();
+	GLMesh& getSpritesBatch();
 
 	void renderSpriteQuads(CameraController& camera);
 	void renderTilemaps(CameraController& camera);
@@ -43,6 +43,7 @@ bool GLResourceHub::init()
 
 	// ========= Shaders =========
 	LOAD_SHADER(ResourceNames::SpriteVertShader, ResourceNames::SpriteVertFile, ShaderType::Vertex);
+	LOAD_SHADER(ResourceNames::SpriteInstancedVertShader, ResourceNames::SpriteInstancedVertFile, ShaderType::Vertex);
 	LOAD_SHADER(ResourceNames::TilemapVertShader, ResourceNames::TilemapVertFile, ShaderType::Vertex);
 	LOAD_SHADER(ResourceNames::LineVertShader, ResourceNames::LineVertFile, ShaderType::Vertex);
 
@@ -51,6 +52,7 @@ bool GLResourceHub::init()
 
 	// ========= Programs =========
 	LOAD_PROGRAM(ResourceNames::SpriteShader, ResourceNames::SpriteVertShader, ResourceNames::SpriteFragShader);
+	LOAD_PROGRAM(ResourceNames::SpriteInstancedShader, ResourceNames::SpriteInstancedVertShader, ResourceNames::SpriteFragShader);
 	LOAD_PROGRAM(ResourceNames::TilemapShader, ResourceNames::TilemapVertShader, ResourceNames::SpriteFragShader);
 	LOAD_PROGRAM(ResourceNames::LineShader, ResourceNames::LineVertShader, ResourceNames::LineFragShader);
 
@@ -0,0 +1,123 @@
+#include "renderer/backend/openGL/GLStreamBuffer.hpp"
+
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+GLStreamBuffer::GLStreamBuffer(uint32_t regionSize, uint32_t regionCount)
+	: m_regionSize(regionSize), m_regionCount(regionCount), m_persistent(GLAD_GL_VERSION_4_4 && glBufferStorage != nullptr)
+{
+	ASSERT(regionSize > 0 && regionCount > 0, "Stream buffer needs at least one non empty region");
+
+	GL(glCreateBuffers(1, &m_glBuffer));
+	GL(glBindBuffer(GL_ARRAY_BUFFER, m_glBuffer));
+
+	if (m_persistent)
+	{
+		// Coherent: writes are visible to the GPU without flushing, the fences alone order them
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLsizeiptr size = static_cast<GLsizeiptr>(m_regionSize) * m_regionCount;
+		GL(glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags));
+		void* data;
+		GL_RET(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags), data);
+		m_persistentData = static_cast<uint8_t*>(data);
+		ASSERT(m_persistentData != nullptr, "Failed to map stream buffer");
+		m_fences.resize(m_regionCount, nullptr);
+	}
+	else
+	{
+		// Orphaning gives a new storage every map, the driver keeps the old one alive for pending draws
+		m_regionCount = 1;
+		GL(glBufferData(GL_ARRAY_BUFFER, m_regionSize, nullptr, GL_STREAM_DRAW));
+	}
+}
+
+GLStreamBuffer::~GLStreamBuffer()
+{
+	for (GLsync fence : m_fences)
+		if (fence) GL(glDeleteSync(fence));
+
+	if (m_persistent || m_mapped)
+	{
+		GL(glBindBuffer(GL_ARRAY_BUFFER, m_glBuffer));
+		GL(glUnmapBuffer(GL_ARRAY_BUFFER));
+	}
+	GL(glDeleteBuffers(1, &m_glBuffer));
+}
+
+void GLStreamBuffer::bind()
+{
+	GL(glBindBuffer(GL_ARRAY_BUFFER, m_glBuffer));
+}
+
+void GLStreamBuffer::unbind()
+{
+	GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+}
+
+uint8_t* GLStreamBuffer::map()
+{
+	ASSERT(!m_mapped, "Stream buffer region already mapped");
+	m_mapped = true;
+
+	if (m_persistent)
+	{
+		waitFence(m_region);
+		return m_persistentData + static_cast<size_t>(m_region) * m_regionSize;
+	}
+
+	GL(glBindBuffer(GL_ARRAY_BUFFER, m_glBuffer));
+	GL(glBufferData(GL_ARRAY_BUFFER, m_regionSize, nullptr, GL_STREAM_DRAW));
+	void* data;
+	GL_RET(glMapBufferRange(GL_ARRAY_BUFFER, 0, m_regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT), data);
+	ASSERT(data != nullptr, "Failed to map stream buffer");
+	return static_cast<uint8_t*>(data);
+}
+
+uint32_t GLStreamBuffer::unmap()
+{
+	ASSERT(m_mapped, "Stream buffer region not mapped");
+	m_mapped = false;
+
+	if (m_persistent) return m_region * m_regionSize;
+
+	GL(glBindBuffer(GL_ARRAY_BUFFER, m_glBuffer));
+	GL(glUnmapBuffer(GL_ARRAY_BUFFER));
+	return 0;
+}
+
+void GLStreamBuffer::fence()
+{
+	if (!m_persistent) return;
+
+	if (m_fences[m_region]) GL(glDeleteSync(m_fences[m_region]));
+	GL_RET(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_fences[m_region]);
+	m_region = (m_region + 1) % m_regionCount;
+}
+
+void GLStreamBuffer::waitFence(uint32_t region)
+{
+	GLsync& fence = m_fences[region];
+	if (!fence) return;
+
+	// Flush on the first wait so the fence is sure to be signaled eventually
+	GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	constexpr GLuint64 timeoutNs = 1000000; // 1 ms, loops until signaled
+	while (true)
+	{
+		GLenum result;
+		GL_RET(glClientWaitSync(fence, waitFlags, timeoutNs), result);
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) break;
+		if (result == GL_WAIT_FAILED)
+		{
+			ASSERT_FALSE("Waiting for stream buffer fence failed");
+			break;
+		}
+		waitFlags = 0;
+	}
+
+	GL(glDeleteSync(fence));
+	fence = nullptr;
+}
+
+} // TileBite
\ No newline at end of file
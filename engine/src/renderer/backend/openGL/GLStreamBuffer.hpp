@@ -0,0 +1,49 @@
+#ifndef GL_STREAM_BUFFER_HPP
+#define GL_STREAM_BUFFER_HPP
+
+#include "core/pch.hpp"
+#include "renderer/backend/openGL/GLWrapper.hpp"
+
+namespace TileBite {
+
+// OpenGL vertex buffer for data rewritten every batch, written straight into mapped memory.
+// The buffer is split in regionCount regions used in turn. A fence after the draw reading a region
+// keeps the CPU from writing it again before the GPU is done with it (no implicit driver sync).
+// Persistently mapped once when buffer storage is available (GL 4.4), otherwise a single region
+// is orphaned and mapped again for every batch.
+class GLStreamBuffer {
+public:
+	GLStreamBuffer(uint32_t regionSize, uint32_t regionCount = 3);
+	~GLStreamBuffer();
+
+	GLStreamBuffer(const GLStreamBuffer&) = delete;
+	GLStreamBuffer& operator=(const GLStreamBuffer&) = delete;
+
+	void bind();
+	void unbind();
+
+	// Writable pointer to the next region (regionSize bytes), waits for the GPU if it still reads it
+	uint8_t* map();
+	// Ends the writes, returns the byte offset of the region in the buffer to draw from
+	uint32_t unmap();
+	// Call after the draws reading the region returned by unmap()
+	void fence();
+
+	uint32_t getRegionSize() const { return m_regionSize; }
+	bool isPersistent() const { return m_persistent; }
+private:
+	GLuint m_glBuffer;
+	uint32_t m_regionSize;
+	uint32_t m_regionCount;
+	uint32_t m_region = 0;
+	bool m_persistent;
+	bool m_mapped = false;
+	uint8_t* m_persistentData = nullptr;
+	std::vector<GLsync> m_fences;
+
+	void waitFence(uint32_t region);
+};
+
+} // TileBite
+
+#endif // !GL_STREAM_BUFFER_HPP
\ No newline at end of file
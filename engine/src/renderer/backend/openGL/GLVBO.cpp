@@ -7,6 +7,8 @@ namespace TileBite {
 GLVBO::GLVBO(const float* data, uint32_t size)
 	: m_size(size)
 {
+	if (size == 0) return; // Data streamed elsewhere (GLStreamBuffer), do not make buffers in GPU
+
 	GL(glCreateBuffers(1, &m_glVBO));
 	GL(glBindBuffer(GL_ARRAY_BUFFER, m_glVBO));
 	GL(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
@@ -14,6 +16,8 @@ GLVBO::GLVBO(const float* data, uint32_t size)
 
 GLVBO::~GLVBO()
 {
+	if (m_size == 0) return; // No buffers created
+
 	GL(glDeleteBuffers(1, &m_glVBO));
 }
 
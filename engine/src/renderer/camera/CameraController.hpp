@@ -69,6 +69,8 @@ public:
 
 	const glm::mat4& getViewProjectionMatrix() const { return m_camera.getViewProjectionMatrix(); }
 
+	const AABB& getFrustum() const { return m_cameraFrustum; }
+
 	bool isInsideFrustum(AABB collider) const {
 		// TODO: consider rotation?
 		return m_cameraFrustum.intersects(collider);
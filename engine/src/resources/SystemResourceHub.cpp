@@ -25,6 +25,7 @@ bool SystemResourceHub::init()
 
 	// Vertex
 	LOAD_TEXT(ResourceNames::SpriteVertFile, ResourcePaths::SpriteVertFile());
+	LOAD_TEXT(ResourceNames::SpriteInstancedVertFile, ResourcePaths::SpriteInstancedVertFile());
 	LOAD_TEXT(ResourceNames::TilemapVertFile, ResourcePaths::TilemapVertFile());
 	LOAD_TEXT(ResourceNames::LineVertFile, ResourcePaths::LineVertFile());
 
@@ -15,7 +15,8 @@ TilemapResource::TilemapResource(
 	: 
 	Resource(resourceName, true),
 	m_width(dimensions.x), m_height(dimensions.y), m_worldTileSize(tileSize), m_atlasTileSize(atlasSize), m_atlasID(atlasID), m_atlasDim(atlasDim),
-	m_solidTiles(tiles.size())
+	m_solidTiles(tiles.size()),
+	m_solidOccupancy(dimensions.x, dimensions.y)
 {
 	m_vertices.resize(dimensions.x * dimensions.y * PACKED_TILEMAP_QUAD_BYTES);
 	for (size_t y = 0; y < dimensions.y; y++)
@@ -64,10 +65,26 @@ void TilemapResource::setTile(Tile tile, uint8_t xIndex, uint8_t yIndex)
 	m_bytesChanges.push_back(BytesChange{ byteOffset, size });
 
 	uint32_t index = yIndex * m_width + xIndex;
+	if (tile.IsSolid == m_solidTiles.isSet(index))
+		return;
+
 	if(tile.IsSolid)
 		m_solidTiles.set(index);
 	else
 		m_solidTiles.clear(index);
+	m_solidOccupancy.setCell(xIndex, yIndex, tile.IsSolid);
+	if (m_solidRects)
+		m_solidRects->update(m_solidTiles, xIndex, yIndex);
+}
+
+void TilemapResource::setMergedSolidRects(bool enabled)
+{
+	m_mergedSolidRects = enabled;
+	if (enabled && !m_solidRects)
+	{
+		m_solidRects = std::make_unique<TileRectMesh>(m_width, m_height);
+		m_solidRects->build(m_solidTiles);
+	}
 }
 
 Tile TilemapResource::getTile(uint8_t xIndex, uint8_t yIndex)
@@ -6,6 +6,8 @@
 
 #include "ecs/types/EngineComponents.hpp"
 #include "utilities/Bitset.hpp"
+#include "utilities/OccupancyPyramid.hpp"
+#include "physics/TileRectMesh.hpp"
 
 namespace TileBite {
 
@@ -42,6 +44,12 @@ public:
 	void resetChangesList() { m_bytesChanges.clear(); }
 	const std::vector<BytesChange>& getBytesChanges() const { return m_bytesChanges; }
 	const Bitset& getSolidTiles() const { return m_solidTiles; }
+	const OccupancyPyramid& getSolidOccupancy() const { return m_solidOccupancy; }
+	const TileRectMesh* getSolidRects() const { return m_mergedSolidRects ? m_solidRects.get() : nullptr; }
+
+	// Keeps the solid tiles merged in rectangles (updated on each setTile) so that collisions
+	// are reported per rectangle instead of per tile
+	void setMergedSolidRects(bool enabled);
 
 	void mergeBytesChanges();
 
@@ -69,6 +77,11 @@ private:
 
 	std::vector<BytesChange> m_bytesChanges;
 	Bitset m_solidTiles; // Bitset representing solid tiles in the tilemap
+	OccupancyPyramid m_solidOccupancy; // Empty block summary of m_solidTiles, lets raycasts skip empty areas
+	// Created on first use and kept up to date afterwards, collider groups of other tilemaps sharing
+	// this resource may still point to it after it is disabled
+	std::unique_ptr<TileRectMesh> m_solidRects;
+	bool m_mergedSolidRects = false;
 };
 
 } // TileBite
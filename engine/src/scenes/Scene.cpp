@@ -2,6 +2,7 @@
 
 #include "events/EventDispatcher.hpp"
 #include "window/Window.hpp"
+#include "ecs/types/EngineComponents.hpp"
 
 #include "core/EngineApp.hpp"
 
@@ -23,6 +24,36 @@ void Scene::onUpdate(float deltaTime)
 	m_systemManager.updateSystems(deltaTime);
 }
 
+void Scene::onFixedUpdate(float fixedDeltaTime)
+{
+	m_systemManager.fixedUpdateSystems(fixedDeltaTime);
+}
+
+uint64_t Scene::computeStateHash()
+{
+	StateHasher hasher;
+
+	// Queries visit entities in an order that only depends on what was done to this world
+	m_world.query<TransformComponent>().each([&](ID entityID, TransformComponent* transform) {
+		hasher.add(entityID);
+		hasher.add(transform->getPosition().x);
+		hasher.add(transform->getPosition().y);
+		hasher.add(transform->getSize().x);
+		hasher.add(transform->getSize().y);
+		hasher.add(transform->getRotation());
+	});
+
+	m_world.query<VelocityComponent>().each([&](ID entityID, VelocityComponent* velocity) {
+		hasher.add(entityID);
+		hasher.add(velocity->Linear.x);
+		hasher.add(velocity->Linear.y);
+		hasher.add(velocity->Angular);
+	});
+
+	onHashState(hasher);
+	return hasher.getHash();
+}
+
 void Scene::setCameraController(std::shared_ptr<CameraController> cameraController)
 {
 	m_cameraController = cameraController;
@@ -9,6 +9,7 @@
 #include "events/EventCallback.hpp"
 #include "events/types/WindowResizeEvent.hpp"
 #include "scenes/SceneGraph.hpp"
+#include "utilities/StateHasher.hpp"
 
 namespace TileBite {
 
@@ -25,10 +26,18 @@ public:
 	std::shared_ptr<CameraController> getCameraController() const { return m_cameraController; }
 	
 	void onUpdate(float deltaTime);
+	void onFixedUpdate(float fixedDeltaTime);
+
+	// Hash of the transforms and velocities of every entity (plus whatever onHashState adds), compare it
+	// between runs or peers after each tick to find the first tick that diverged
+	uint64_t computeStateHash();
 	void updateWorldActions() { m_world.executeDeferredActions(); }
 
 	virtual void onLoad() {};
 protected:
+	// Override to add game state that isn't in engine components to the state hash
+	virtual void onHashState(StateHasher& /*hasher*/) {}
+
 	void setCameraController(std::shared_ptr<CameraController> cameraController);
 
 	SystemManager& getSystemManager() { return m_systemManager; } // TODO: make a more protective interface for client side use.
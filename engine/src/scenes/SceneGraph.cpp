@@ -16,6 +16,8 @@ void SceneGraph::traverseHierarchy(uint32_t previousIndex, uint32_t currentIndex
 		if (parentNode.WorldTransform.isDirty() || currentTransform->isDirty())
 		{
 			currentNode.WorldTransform = compose(parentNode.WorldTransform, *currentTransform);
+			// Moved with its parent, wakes up a sleeping collider of the child
+			currentTransform->notifyChange();
 		}
 	}
 	else
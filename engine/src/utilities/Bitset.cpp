@@ -12,6 +12,23 @@ bool Bitset::isSet(size_t index) const {
 	return (m_words[index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
 }
 
+uint64_t Bitset::getBits(size_t first, uint32_t count) const
+{
+	ASSERT(count <= 64 && first + count <= m_bitsSize, "Out of range");
+	if (count == 0) return 0;
+
+	size_t wordIdx = first / BITS_PER_WORD;
+	uint32_t gathered = BITS_PER_WORD - first % BITS_PER_WORD;
+	uint64_t bits = uint64_t(m_words[wordIdx]) >> (first % BITS_PER_WORD);
+	while (gathered < count)
+	{
+		bits |= uint64_t(m_words[++wordIdx]) << gathered;
+		gathered += BITS_PER_WORD;
+	}
+
+	return (count == 64) ? bits : bits & ((uint64_t(1) << count) - 1);
+}
+
 void Bitset::set(size_t index)
 {
 	ASSERT(index < m_bitsSize, "Out of range");
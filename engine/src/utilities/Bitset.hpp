@@ -31,6 +31,12 @@ public:
 	size_t popCount() const;
 	size_t getSize() const { return m_bitsSize; }
 
+	// Bits [first, first + count) packed from bit 0, count is at most 64
+	uint64_t getBits(size_t first, uint32_t count) const;
+
+	// Raw words, bit i lives in word i / BITS_PER_WORD at bit i % BITS_PER_WORD
+	std::span<const WordType> getWords() const { return m_words; }
+
 	std::string toString() const;
 private:
 	std::vector<WordType> m_words;
@@ -0,0 +1,63 @@
+#ifndef DETERMINISTIC_MATH_HPP
+#define DETERMINISTIC_MATH_HPP
+
+#include <cmath>
+#include <cstdint>
+
+namespace TileBite {
+
+// Sine and cosine from basic arithmetic only (IEEE exact operations), the results are bit identical on
+// every platform and standard library as long as the compiler doesn't contract them (-ffp-contract=off).
+// Accurate to float precision for |radians| < 1e5.
+inline void deterministicSinCos(float radians, float& sine, float& cosine)
+{
+	// Reduces to r in [-pi/4, pi/4] around the closest multiple q of pi/2, pi/2 is split in a 33 bit part
+	// (q * PiOver2High is exact) and the rest
+	constexpr double PiOver2High = 1.57079632673412561417e+00;
+	constexpr double PiOver2Low = 6.07710050650619224932e-11;
+	constexpr double TwoOverPi = 6.36619772367581382433e-01;
+
+	double x = radians;
+	double q = std::floor(x * TwoOverPi + 0.5);
+	double r = (x - q * PiOver2High) - q * PiOver2Low;
+	double r2 = r * r;
+
+	// Taylor series, the first skipped term is below 1e-13 on the reduced range
+	double s = r * (1.0 - r2 / 6.0 * (1.0 - r2 / 20.0 * (1.0 - r2 / 42.0 * (1.0 - r2 / 72.0 * (1.0 - r2 / 110.0 * (1.0 - r2 / 156.0))))));
+	double c = 1.0 - r2 / 2.0 * (1.0 - r2 / 12.0 * (1.0 - r2 / 30.0 * (1.0 - r2 / 56.0 * (1.0 - r2 / 90.0 * (1.0 - r2 / 132.0 * (1.0 - r2 / 182.0))))));
+
+	switch (static_cast<int64_t>(q) & 3) {
+	case 0: sine = float(s);  cosine = float(c);  break;
+	case 1: sine = float(c);  cosine = float(-s); break;
+	case 2: sine = float(-s); cosine = float(-c); break;
+	default: sine = float(-c); cosine = float(s); break;
+	}
+}
+
+// Sine and cosine for anything that ends up in the simulation state (colliders, transforms of hierarchies).
+// DETERMINISTIC_MODE swaps the platform ones for the deterministic ones above.
+inline float simSin(float radians)
+{
+#ifdef DETERMINISTIC_MODE
+	float sine, cosine;
+	deterministicSinCos(radians, sine, cosine);
+	return sine;
+#else
+	return std::sin(radians);
+#endif
+}
+
+inline float simCos(float radians)
+{
+#ifdef DETERMINISTIC_MODE
+	float sine, cosine;
+	deterministicSinCos(radians, sine, cosine);
+	return cosine;
+#else
+	return std::cos(radians);
+#endif
+}
+
+} // TileBite
+
+#endif // !DETERMINISTIC_MATH_HPP
@@ -0,0 +1,63 @@
+#include "utilities/OccupancyPyramid.hpp"
+
+namespace TileBite {
+
+OccupancyPyramid::OccupancyPyramid(uint32_t width, uint32_t height)
+	: m_width(width), m_height(height)
+{
+	for (uint32_t level = 0; level < LevelCount; level++)
+	{
+		Level& lvl = m_levels[level];
+		uint32_t blockSize = 1u << BlockShifts[level];
+		lvl.Width = (width + blockSize - 1) >> BlockShifts[level];
+		lvl.Height = (height + blockSize - 1) >> BlockShifts[level];
+		lvl.SolidCounts.assign(lvl.Width * lvl.Height, 0);
+		lvl.Occupied = Bitset(lvl.Width * lvl.Height);
+	}
+}
+
+void OccupancyPyramid::build(const Bitset& cells)
+{
+	ASSERT(cells.getSize() == size_t(m_width) * m_height, "Cells don't match the pyramid size");
+
+	for (Level& lvl : m_levels)
+	{
+		std::fill(lvl.SolidCounts.begin(), lvl.SolidCounts.end(), uint16_t(0));
+		lvl.Occupied.clear();
+	}
+
+	for (uint32_t y = 0; y < m_height; y++)
+	{
+		for (uint32_t x = 0; x < m_width; x++)
+		{
+			if (cells.isSet(x + y * m_width))
+				setCell(x, y, true);
+		}
+	}
+}
+
+void OccupancyPyramid::setCell(uint32_t x, uint32_t y, bool solid)
+{
+	ASSERT(x < m_width && y < m_height, "Cell out of range");
+
+	for (uint32_t level = 0; level < LevelCount; level++)
+	{
+		Level& lvl = m_levels[level];
+		uint32_t shift = BlockShifts[level];
+		uint32_t block = (x >> shift) + (y >> shift) * lvl.Width;
+
+		if (solid)
+		{
+			if (lvl.SolidCounts[block]++ == 0)
+				lvl.Occupied.set(block);
+		}
+		else
+		{
+			ASSERT(lvl.SolidCounts[block] > 0, "Clearing a cell of an empty block");
+			if (--lvl.SolidCounts[block] == 0)
+				lvl.Occupied.clear(block);
+		}
+	}
+}
+
+} // TileBite
@@ -0,0 +1,52 @@
+#ifndef OCCUPANCY_PYRAMID_HPP
+#define OCCUPANCY_PYRAMID_HPP
+
+#include "core/pch.hpp"
+#include "utilities/Bitset.hpp"
+
+namespace TileBite {
+
+// Summary levels over a grid of solid cells, used to skip empty areas of a tilemap.
+// Level 0 has a bit per 4x4 block and level 1 a bit per 16x16 block, a bit is set while the block
+// has at least one solid cell. Per block counts let single cell edits update it in constant time.
+class OccupancyPyramid {
+public:
+	static constexpr uint32_t LevelCount = 2;
+	static constexpr uint32_t BlockShifts[LevelCount] = { 2, 4 }; // log2 of the block size of each level
+
+	OccupancyPyramid() = default;
+	OccupancyPyramid(uint32_t width, uint32_t height);
+
+	// Recomputes every level from the cells (bit x + y * width)
+	void build(const Bitset& cells);
+
+	// Call when a cell changes between empty and solid
+	void setCell(uint32_t x, uint32_t y, bool solid);
+
+	// True if the level block containing cell (x, y) has no solid cell
+	inline bool isBlockEmpty(uint32_t level, uint32_t x, uint32_t y) const
+	{
+		const Level& lvl = m_levels[level];
+		uint32_t shift = BlockShifts[level];
+		return !lvl.Occupied.isSet((x >> shift) + (y >> shift) * lvl.Width);
+	}
+
+	uint32_t getWidth() const { return m_width; }
+	uint32_t getHeight() const { return m_height; }
+
+private:
+	struct Level {
+		uint32_t Width = 0; // In blocks
+		uint32_t Height = 0;
+		std::vector<uint16_t> SolidCounts;
+		Bitset Occupied;
+	};
+
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+	std::array<Level, LevelCount> m_levels;
+};
+
+} // TileBite
+
+#endif // !OCCUPANCY_PYRAMID_HPP
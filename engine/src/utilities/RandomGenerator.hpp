@@ -0,0 +1,47 @@
+#ifndef RANDOM_GENERATOR_HPP
+#define RANDOM_GENERATOR_HPP
+
+#include <cstdint>
+
+namespace TileBite {
+
+// PCG32 (https://www.pcg-random.org/), unlike rand() it gives the same sequence for a seed on every platform.
+class RandomGenerator {
+public:
+	explicit RandomGenerator(uint64_t seed = 0) { setSeed(seed); }
+
+	void setSeed(uint64_t seed)
+	{
+		m_state = 0;
+		next();
+		m_state += seed;
+		next();
+	}
+
+	uint32_t next()
+	{
+		uint64_t oldState = m_state;
+		m_state = oldState * Multiplier + Increment;
+		uint32_t xorShifted = static_cast<uint32_t>(((oldState >> 18u) ^ oldState) >> 27u);
+		uint32_t rotation = static_cast<uint32_t>(oldState >> 59u);
+		return (xorShifted >> rotation) | (xorShifted << ((32u - rotation) & 31u));
+	}
+
+	// Uniform in [min, max), from the top 24 bits so every value is exact in a float
+	float nextFloat(float min = 0.0f, float max = 1.0f)
+	{
+		return min + (max - min) * (static_cast<float>(next() >> 8) * (1.0f / 16777216.0f));
+	}
+
+	uint64_t getState() const { return m_state; }
+
+private:
+	static constexpr uint64_t Multiplier = 6364136223846793005ull;
+	static constexpr uint64_t Increment = 1442695040888963407ull;
+
+	uint64_t m_state = 0;
+};
+
+} // TileBite
+
+#endif // !RANDOM_GENERATOR_HPP
@@ -0,0 +1,20 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+// Compile time detection of the available SIMD instruction sets.
+// SSE2 is part of every x64 target, AVX has to be enabled explicitly
+// (see ENABLE_AVX in engine/CMakeLists.txt).
+
+#if defined(__AVX__)
+#define TILEBITE_SIMD_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILEBITE_SIMD_SSE
+#endif
+
+#if defined(TILEBITE_SIMD_SSE) || defined(TILEBITE_SIMD_AVX)
+#include <immintrin.h>
+#endif
+
+#endif // !SIMD_HPP
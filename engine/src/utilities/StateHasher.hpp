@@ -0,0 +1,38 @@
+#ifndef STATE_HASHER_HPP
+#define STATE_HASHER_HPP
+
+#include "core/pch.hpp"
+
+namespace TileBite {
+
+// 64 bit FNV-1a (http://www.isthe.com/chongo/tech/comp/fnv/) over simulation values. Two runs that simulated
+// the same ticks give the same hash, so comparing one number per tick detects a desync.
+class StateHasher {
+public:
+	void addBytes(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			m_hash ^= bytes[i];
+			m_hash *= Prime;
+		}
+	}
+
+	// Values must have no padding bytes, hash the fields of structs one by one
+	template<typename T>
+	requires std::is_trivially_copyable_v<T>
+	void add(const T& value) { addBytes(&value, sizeof(T)); }
+
+	uint64_t getHash() const { return m_hash; }
+
+private:
+	static constexpr uint64_t OffsetBasis = 14695981039346656037ull;
+	static constexpr uint64_t Prime = 1099511628211ull;
+
+	uint64_t m_hash = OffsetBasis;
+};
+
+} // TileBite
+
+#endif // !STATE_HASHER_HPP
@@ -0,0 +1,109 @@
+#include "utilities/ThreadPool.hpp"
+
+#include "utilities/assertions.hpp"
+
+namespace TileBite {
+
+ThreadPool::ThreadPool(uint32_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	m_workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_workers.emplace_back([this]() { workerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_taskCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push_back(std::move(task));
+	}
+	m_taskCondition.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_taskCondition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+			if (m_stopping && m_tasks.empty()) return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop_front();
+		}
+
+		task();
+	}
+}
+
+void ThreadPool::parallelFor(uint32_t count, uint32_t minChunkSize, const RangeJob& job)
+{
+	if (count == 0) return;
+
+	// A few chunks per thread so uneven chunks balance out
+	uint32_t threadCount = getWorkerCount() + 1;
+	uint32_t chunkSize = std::max(std::max(minChunkSize, 1u), (count + threadCount * 4 - 1) / (threadCount * 4));
+	uint32_t chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount == 1)
+	{
+		job(0, count);
+		return;
+	}
+
+	// Chunks are claimed with an atomic counter by the helpers and the calling thread.
+	// The state lives on this stack frame, so the call only returns once every helper has exited.
+	std::atomic<uint32_t> nextChunk = 0;
+	uint32_t helperCount = std::min(getWorkerCount(), chunkCount - 1);
+	uint32_t finishedHelpers = 0;
+
+	auto runChunks = [&]() {
+		uint32_t chunk;
+		while ((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount)
+		{
+			uint32_t begin = chunk * chunkSize;
+			job(begin, std::min(begin + chunkSize, count));
+		}
+	};
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (uint32_t i = 0; i < helperCount; i++)
+		{
+			m_tasks.push_back([&]() {
+				runChunks();
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				finishedHelpers++;
+				m_doneCondition.notify_all();
+			});
+		}
+	}
+	m_taskCondition.notify_all();
+
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [&]() { return finishedHelpers == helperCount; });
+}
+
+} // TileBite
@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include "core/pch.hpp"
+
+namespace TileBite {
+
+// Fixed set of worker threads fed from a shared task queue.
+class ThreadPool {
+public:
+	using RangeJob = std::function<void(uint32_t begin, uint32_t end)>;
+
+	// 0 uses one worker less than the hardware threads (the calling thread also works in parallelFor)
+	explicit ThreadPool(uint32_t workerCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	uint32_t getWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	void submit(std::function<void()> task);
+
+	// Splits [0, count) in chunks of at least minChunkSize items and runs job(begin, end) for each of them
+	// on the workers and the calling thread. Blocks until every chunk is done.
+	// NOTE: must not be called from inside a job, the caller would wait on workers that wait on it.
+	void parallelFor(uint32_t count, uint32_t minChunkSize, const RangeJob& job);
+
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_taskCondition;
+	std::condition_variable m_doneCondition;
+	bool m_stopping = false;
+
+	void workerLoop();
+};
+
+} // TileBite
+
+#endif // !THREAD_POOL_HPP
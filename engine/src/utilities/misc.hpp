@@ -4,6 +4,8 @@
 #include "core/pch.hpp"
 #include "utilities/Logger.hpp"
 #include "ecs/types/EngineComponents.hpp"
+#include "utilities/DeterministicMath.hpp"
+#include "utilities/RandomGenerator.hpp"
 
 namespace TileBite {
 
@@ -121,6 +123,31 @@ inline uint32_t packRGBA(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
 		(uint32_t(a) << 24);
 }
 
+// Per instance data of the instanced sprite path (44 bytes instead of 144 for makeSpriteQuadVertices).
+// The vertex shader (spriteInstanced.vert) scales and rotates a shared unit quad, must match its attributes.
+struct SpriteInstance {
+	glm::vec2 Position;
+	glm::vec2 Size;
+	float Rotation;
+	uint32_t PackedColor;
+	glm::vec4 UVRect;
+	uint32_t TextureID;
+};
+static_assert(sizeof(SpriteInstance) == 44, "SpriteInstance must be tightly packed to match its vertex layout");
+
+inline SpriteInstance makeSpriteInstance(TransformComponent* t, SpriteComponent* spr)
+{
+	glm::u8vec4 u8Color = glm::u8vec4(glm::clamp(spr->Color, 0.0f, 1.0f) * 255.0f);
+	return SpriteInstance{
+		t->getPosition(),
+		t->getSize(),
+		t->getRotation(),
+		packRGBA(u8Color.r, u8Color.g, u8Color.b, u8Color.a),
+		spr->UVRect,
+		static_cast<uint32_t>(spr->TextureID)
+	};
+}
+
 inline void unpackXYIndexUV(uint32_t packed,
 	uint8_t& x, uint8_t& y,
 	uint8_t& uvx, uint8_t& uvy)
@@ -198,8 +225,14 @@ inline std::vector<uint32_t> makeIndices(int indicesCount, int verticesPerQuad,
 	return indexData;
 }
 
+// Generator behind quickRandFloat, seeded from AppConfig::randomSeed when the app starts
+inline RandomGenerator& getDefaultRandomGenerator() {
+	static RandomGenerator generator;
+	return generator;
+}
+
 inline float quickRandFloat(float min = -1.0f, float max = 1.0f) {
-	return min + (max - min) * (rand() / float(RAND_MAX));
+	return getDefaultRandomGenerator().nextFloat(min, max);
 }
 
 inline TransformComponent compose(const TransformComponent& P, const TransformComponent& Q)
@@ -207,8 +240,8 @@ inline TransformComponent compose(const TransformComponent& P, const TransformCo
 	TransformComponent R;
 
 	glm::vec2 scaled = Q.getPosition() * P.getSize();
-	float s = std::sin(P.getRotation());
-	float c = std::cos(P.getRotation());
+	float s = simSin(P.getRotation());
+	float c = simCos(P.getRotation());
 	glm::vec2 rotated = { scaled.x * c - scaled.y * s,
 						  scaled.x * s + scaled.y * c };
 
@@ -227,8 +260,8 @@ inline TransformComponent inverse(const TransformComponent& T)
 	glm::vec2 invSize = 1.0f / T.getSize();
 
 	glm::vec2 negPos = -T.getPosition();
-	float s = std::sin(invRot);
-	float c = std::cos(invRot);
+	float s = simSin(invRot);
+	float c = simCos(invRot);
 	glm::vec2 rotated = { negPos.x * c - negPos.y * s,
 						  negPos.x * s + negPos.y * c };
 	glm::vec2 invPos = rotated * invSize;
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <physics/PhysicsEngine.hpp>
+
+using namespace TileBite;
+
+// Compares the AABBTree and SpatialHashGrid broad phases of the physics engine under churn:
+// every collider moves every frame, a slice of them is removed and added back now and then,
+// and each frame computes the collision pairs and runs a batch of queries and raycasts.
+
+constexpr uint32_t ColliderCount = 20000;
+constexpr uint32_t Frames = 200;
+constexpr uint32_t QueriesPerFrame = 500;
+constexpr uint32_t RaycastsPerFrame = 200;
+constexpr float WorldSize = 1000.0f;
+
+struct FrameTimes {
+    double Update = 0.0;
+    double Pairs = 0.0;
+    double Queries = 0.0;
+    size_t PairCount = 0;
+    size_t Hits = 0;
+};
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static FrameTimes runChurn(PhysicsEngine::BroadphaseType broadphase)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0.0f, WorldSize);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    PhysicsEngine physicsEngine;
+    physicsEngine.setBroadphase(broadphase);
+
+    TransformComponent transform;
+    std::vector<AABB> colliders;
+    std::vector<glm::vec2> velocities;
+    colliders.reserve(ColliderCount);
+    velocities.reserve(ColliderCount);
+    for (uint32_t i = 0; i < ColliderCount; i++)
+    {
+        glm::vec2 min(position(rng), position(rng));
+        colliders.push_back(AABB(min, min + glm::vec2(size(rng), size(rng))));
+        velocities.push_back(glm::vec2(velocity(rng), velocity(rng)));
+        physicsEngine.updateCollider(i + 1, &colliders[i], &transform);
+    }
+
+    FrameTimes times;
+    std::vector<CollisionHit> hits;
+    for (uint32_t frame = 0; frame < Frames; frame++)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < ColliderCount; i++)
+        {
+            colliders[i] = AABB(colliders[i].Min + velocities[i], colliders[i].Max + velocities[i]);
+            physicsEngine.updateCollider(i + 1, &colliders[i], &transform);
+        }
+
+        if (frame % 10 == 0)
+        {
+            for (uint32_t i = frame % 7; i < ColliderCount; i += 7)
+                physicsEngine.removeCollider(i + 1);
+            for (uint32_t i = frame % 7; i < ColliderCount; i += 7)
+                physicsEngine.updateCollider(i + 1, &colliders[i], &transform);
+        }
+        times.Update += elapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        times.PairCount += physicsEngine.computePairs().size();
+        times.Pairs += elapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (uint32_t i = 0; i < QueriesPerFrame; i++)
+        {
+            glm::vec2 min(position(rng), position(rng));
+            hits.clear();
+            physicsEngine.query(AABB(min, min + glm::vec2(10.0f)), QueryFilter(), hits);
+            times.Hits += hits.size();
+        }
+        for (uint32_t i = 0; i < RaycastsPerFrame; i++)
+        {
+            float direction = angle(rng);
+            Ray2D ray(glm::vec2(position(rng), position(rng)), glm::vec2(std::cos(direction), std::sin(direction)), 100.0f);
+            times.Hits += physicsEngine.raycastClosest(ray).has_value() ? 1 : 0;
+        }
+        times.Queries += elapsedMs(start);
+    }
+
+    return times;
+}
+
+static void printTimes(const char* label, const FrameTimes& times)
+{
+    std::cout << label
+        << ": update " << times.Update / Frames << " ms"
+        << ", pairs " << times.Pairs / Frames << " ms"
+        << ", queries " << times.Queries / Frames << " ms"
+        << ", total " << (times.Update + times.Pairs + times.Queries) / Frames << " ms/frame"
+        << " (pairs " << times.PairCount << ", hits " << times.Hits << ")\n";
+}
+
+int main()
+{
+    printTimes("AABBTree", runChurn(PhysicsEngine::BroadphaseType::AABBTree));
+    printTimes("SpatialHashGrid", runChurn(PhysicsEngine::BroadphaseType::SpatialHashGrid));
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <physics/Collider.hpp>
+#include <physics/CollisionUtilities.hpp>
+#include <physics/GJK.hpp>
+
+using namespace TileBite;
+
+// Compares the specialized AABB / OBB / Circle narrow phase tests with the generic GJK / EPA path
+// on the same shapes. Boxes go through the generic path as polygons and circles as zero length capsules.
+
+constexpr uint32_t ShapeCount = 4096;
+constexpr uint32_t Rounds = 50;
+constexpr float WorldSize = 40.0f;
+
+struct Shapes {
+    std::vector<AABB> AABBs;
+    std::vector<OBB> OBBs;
+    std::vector<Circle> Circles;
+};
+
+struct PairTimes {
+    double Specialized = 0.0;
+    double Generic = 0.0;
+    size_t SpecializedHits = 0;
+    size_t GenericHits = 0;
+};
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static Shapes makeShapes()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0.0f, WorldSize);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    Shapes shapes;
+    for (uint32_t i = 0; i < ShapeCount; i++)
+    {
+        glm::vec2 min(position(rng), position(rng));
+        shapes.AABBs.push_back(AABB(min, min + glm::vec2(size(rng), size(rng))));
+        shapes.OBBs.push_back(OBB(glm::vec2(position(rng), position(rng)), glm::vec2(size(rng), size(rng)), angle(rng)));
+        shapes.Circles.push_back(Circle(glm::vec2(position(rng), position(rng)), size(rng) * 0.5f));
+    }
+    return shapes;
+}
+
+static Collider toGenericCollider(const AABB& aabb)
+{
+    std::array<glm::vec2, 4> corners = { aabb.Min, glm::vec2(aabb.Max.x, aabb.Min.y), aabb.Max, glm::vec2(aabb.Min.x, aabb.Max.y) };
+    return Collider(Polygon(corners));
+}
+
+static Collider toGenericCollider(const OBB& obb)
+{
+    return Collider(Polygon(obb.getCorners()));
+}
+
+static Collider toGenericCollider(const Circle& circle)
+{
+    return Collider(Capsule(circle.Center, circle.Center, circle.Radius));
+}
+
+template<typename ShapeA, typename ShapeB>
+static PairTimes runIntersects(const std::vector<ShapeA>& as, const std::vector<ShapeB>& bs)
+{
+    PairTimes times;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t round = 0; round < Rounds; round++)
+        for (uint32_t i = 0; i < ShapeCount; i++)
+            times.SpecializedHits += as[i].intersects(bs[(i + round) % ShapeCount]) ? 1 : 0;
+    times.Specialized = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t round = 0; round < Rounds; round++)
+        for (uint32_t i = 0; i < ShapeCount; i++)
+            times.GenericHits += CollisionUtilities::gjkIntersects(ConvexShape(as[i]), ConvexShape(bs[(i + round) % ShapeCount])) ? 1 : 0;
+    times.Generic = elapsedMs(start);
+
+    return times;
+}
+
+template<typename ShapeA, typename ShapeB>
+static PairTimes runManifolds(const std::vector<ShapeA>& as, const std::vector<ShapeB>& bs)
+{
+    std::vector<Collider> specializedA, specializedB, genericA, genericB;
+    for (uint32_t i = 0; i < ShapeCount; i++)
+    {
+        specializedA.push_back(Collider(as[i]));
+        specializedB.push_back(Collider(bs[i]));
+        genericA.push_back(toGenericCollider(as[i]));
+        genericB.push_back(toGenericCollider(bs[i]));
+    }
+
+    PairTimes times;
+    ContactManifold manifold;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t round = 0; round < Rounds; round++)
+        for (uint32_t i = 0; i < ShapeCount; i++)
+            times.SpecializedHits += CollisionUtilities::computeManifold(specializedA[i], specializedB[(i + round) % ShapeCount], manifold) ? 1 : 0;
+    times.Specialized = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t round = 0; round < Rounds; round++)
+        for (uint32_t i = 0; i < ShapeCount; i++)
+            times.GenericHits += CollisionUtilities::computeManifold(genericA[i], genericB[(i + round) % ShapeCount], manifold) ? 1 : 0;
+    times.Generic = elapsedMs(start);
+
+    return times;
+}
+
+static void printTimes(const char* label, const PairTimes& times)
+{
+    double tests = static_cast<double>(Rounds) * ShapeCount;
+    std::cout << label
+        << ": specialized " << times.Specialized * 1e6 / tests << " ns"
+        << ", generic " << times.Generic * 1e6 / tests << " ns"
+        << " (x" << times.Generic / times.Specialized << ")"
+        << " (hits " << times.SpecializedHits << " / " << times.GenericHits << ")\n";
+}
+
+int main()
+{
+    Shapes shapes = makeShapes();
+
+    std::cout << "intersects\n";
+    printTimes("  AABB-OBB", runIntersects(shapes.AABBs, shapes.OBBs));
+    printTimes("  OBB-OBB", runIntersects(shapes.OBBs, shapes.OBBs));
+    printTimes("  Circle-AABB", runIntersects(shapes.Circles, shapes.AABBs));
+    printTimes("  Circle-OBB", runIntersects(shapes.Circles, shapes.OBBs));
+
+    std::cout << "computeManifold\n";
+    printTimes("  AABB-OBB", runManifolds(shapes.AABBs, shapes.OBBs));
+    printTimes("  OBB-OBB", runManifolds(shapes.OBBs, shapes.OBBs));
+    printTimes("  Circle-AABB", runManifolds(shapes.Circles, shapes.AABBs));
+    printTimes("  Circle-OBB", runManifolds(shapes.Circles, shapes.OBBs));
+
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <physics/AABBTree.hpp>
+
+using namespace TileBite;
+
+// Measures AABBTree query throughput on a tree fragmented by incremental inserts,
+// updates and removals, then again after a full rebuild (SAH + depth first node layout).
+
+constexpr uint32_t ColliderCount = 20000;
+constexpr uint32_t ChurnFrames = 100;
+constexpr uint32_t QueryCount = 200000;
+constexpr float WorldSize = 2000.0f;
+
+static std::vector<AABB> makeQueries(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> position(0.0f, WorldSize);
+    std::uniform_real_distribution<float> size(1.0f, 20.0f);
+
+    std::vector<AABB> queries;
+    queries.reserve(QueryCount);
+    for (uint32_t i = 0; i < QueryCount; i++)
+    {
+        glm::vec2 min(position(rng), position(rng));
+        queries.push_back(AABB(min, min + glm::vec2(size(rng), size(rng))));
+    }
+
+    return queries;
+}
+
+static void runQueries(const char* label, const AABBTree& tree, const std::vector<AABB>& queries)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t hits = 0;
+    for (const AABB& query : queries)
+        hits += tree.query(query, INVALID_ID).size();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    AABBTree::Metrics metrics = tree.getMetrics();
+    std::cout << label
+        << ": " << static_cast<uint64_t>(queries.size() / seconds) << " queries/s"
+        << ", hits " << hits
+        << ", height " << metrics.Height
+        << ", nodes " << metrics.NodeCount
+        << ", SAH cost " << metrics.SAHCost << "\n";
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0.0f, WorldSize);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> velocity(-2.0f, 2.0f);
+
+    AABBTree tree;
+    std::vector<AABB> colliders;
+    colliders.reserve(ColliderCount);
+    for (uint32_t i = 0; i < ColliderCount; i++)
+    {
+        glm::vec2 min(position(rng), position(rng));
+        colliders.push_back(AABB(min, min + glm::vec2(size(rng), size(rng))));
+        tree.insert(ColliderInfo(i, colliders.back()));
+    }
+
+    // Move everything around and periodically remove / re-add a slice of the colliders
+    for (uint32_t frame = 0; frame < ChurnFrames; frame++)
+    {
+        for (uint32_t i = 0; i < ColliderCount; i++)
+        {
+            glm::vec2 delta(velocity(rng), velocity(rng));
+            colliders[i] = AABB(colliders[i].Min + delta, colliders[i].Max + delta);
+            tree.update(ColliderInfo(i, colliders[i]));
+        }
+
+        if (frame % 10 == 0)
+        {
+            for (uint32_t i = frame % 7; i < ColliderCount; i += 7)
+                tree.remove(i);
+            for (uint32_t i = frame % 7; i < ColliderCount; i += 7)
+                tree.insert(ColliderInfo(i, colliders[i]));
+        }
+    }
+
+    std::vector<AABB> queries = makeQueries(rng);
+    runQueries("Incremental", tree, queries);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    tree.rebuild();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Rebuild: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms\n";
+
+    runQueries("Rebuilt", tree, queries);
+
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <utilities/misc.hpp>
+
+using namespace TileBite;
+
+// Compares the per frame CPU work and upload size of the two sprite paths of the renderer:
+// four expanded vertices per sprite (makeSpriteQuadVertices) against one instance (makeSpriteInstance).
+
+constexpr uint32_t SpriteCount = 100000;
+constexpr uint32_t Frames = 100;
+constexpr float WorldSize = 1000.0f;
+
+struct PathResult {
+    double Ms = 0.0;
+    size_t Bytes = 0;
+    float Checksum = 0.0f;
+};
+
+static PathResult runVertices(std::vector<TransformComponent>& transforms, std::vector<SpriteComponent>& sprites)
+{
+    std::vector<float> upload(SpriteCount * 36);
+    PathResult result;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t frame = 0; frame < Frames; frame++)
+    {
+        for (uint32_t i = 0; i < SpriteCount; i++)
+        {
+            auto vertices = makeSpriteQuadVertices(&transforms[i], &sprites[i]);
+            memcpy(upload.data() + i * vertices.size(), vertices.data(), sizeof(vertices));
+        }
+        result.Checksum += upload[frame % upload.size()];
+    }
+    result.Ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Frames;
+    result.Bytes = upload.size() * sizeof(float);
+    return result;
+}
+
+static PathResult runInstances(std::vector<TransformComponent>& transforms, std::vector<SpriteComponent>& sprites)
+{
+    std::vector<SpriteInstance> upload(SpriteCount);
+    PathResult result;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t frame = 0; frame < Frames; frame++)
+    {
+        for (uint32_t i = 0; i < SpriteCount; i++)
+            upload[i] = makeSpriteInstance(&transforms[i], &sprites[i]);
+        result.Checksum += upload[frame % upload.size()].Rotation;
+    }
+    result.Ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / Frames;
+    result.Bytes = upload.size() * sizeof(SpriteInstance);
+    return result;
+}
+
+static void printResult(const char* label, const PathResult& result)
+{
+    std::cout << label
+        << ": " << result.Ms << " ms/frame"
+        << ", " << result.Bytes / 1024 << " KiB/frame"
+        << " (" << result.Bytes / SpriteCount << " bytes/sprite)"
+        << " (checksum " << result.Checksum << ")\n";
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> position(0.0f, WorldSize);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+    std::vector<TransformComponent> transforms;
+    std::vector<SpriteComponent> sprites;
+    transforms.reserve(SpriteCount);
+    sprites.reserve(SpriteCount);
+    for (uint32_t i = 0; i < SpriteCount; i++)
+    {
+        transforms.emplace_back(glm::vec2(position(rng), position(rng)), glm::vec2(size(rng), size(rng)), angle(rng));
+        sprites.emplace_back(glm::vec4(channel(rng), channel(rng), channel(rng), 1.0f), i % 4);
+    }
+
+    printResult("Vertices", runVertices(transforms, sprites));
+    printResult("Instances", runInstances(transforms, sprites));
+
+    return 0;
+}